@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Generates the training workload for profile guided optimization.
+
+Every scenario is written into its own binary data file, in the same format that is produced
+by iptsd-dump. The data is synthetic, but it follows the layout of reports sent by real
+devices, so that processing it exercises the same code paths as real input.
+"""
+
+from __future__ import annotations
+
+import math
+import random
+import struct
+import sys
+from pathlib import Path
+from typing import Callable
+
+ROWS: int = 44
+COLUMNS: int = 64
+BUFFER_SIZE: int = 8192
+REPORTS: int = 600
+
+HID_FRAME_HID: int = 0x00
+HID_FRAME_HEATMAP: int = 0x01
+HID_FRAME_REPORTS: int = 0xFF
+
+REPORT_HEATMAP_DIMENSIONS: int = 0x03
+REPORT_DFT_WINDOW: int = 0x5C
+REPORT_DFT_METADATA: int = 0x5F
+REPORT_STYLUS_MPP_1_51: int = 0x60
+
+DFT_POSITION: int = 0x06
+DFT_BUTTON: int = 0x09
+DFT_PRESSURE: int = 0x0B
+
+# A contact on the heatmap: center x, center y, radius x, radius y and amplitude.
+Blob = tuple[float, float, float, float, float]
+
+
+def hid_frame(type: int, payload: bytes) -> bytes:
+	return struct.pack("<IBBB", 7 + len(payload), 0, type, 0) + payload
+
+
+def report_frame(type: int, payload: bytes) -> bytes:
+	return struct.pack("<BBH", type, 0, len(payload)) + payload
+
+
+def heatmap(rng: random.Random, blobs: list[Blob]) -> bytes:
+	values: list[float] = [rng.gauss(0, 1.5) for _ in range(ROWS * COLUMNS)]
+
+	for (cx, cy, rx, ry, amplitude) in blobs:
+		x0: int = max(0, int(cx - 3 * rx))
+		x1: int = min(COLUMNS, int(cx + 3 * rx) + 1)
+		y0: int = max(0, int(cy - 3 * ry))
+		y1: int = min(ROWS, int(cy + 3 * ry) + 1)
+
+		for y in range(y0, y1):
+			for x in range(x0, x1):
+				d: float = ((x - cx) / rx)**2 + ((y - cy) / ry)**2
+				values[y * COLUMNS + x] += amplitude * math.exp(-d / 2)
+
+	# IPTS sends data that goes from 255 (no contact) to 0 (contact)
+	return bytes(max(0, min(255, round(251 - v))) for v in values)
+
+
+def dimensions() -> bytes:
+	data: bytes = struct.pack("<8B", ROWS, COLUMNS, 0, ROWS - 1, 0, COLUMNS - 1, 0, 255)
+	return hid_frame(HID_FRAME_REPORTS, report_frame(REPORT_HEATMAP_DIMENSIONS, data))
+
+
+def touch(rng: random.Random, blobs: list[Blob]) -> bytes:
+	data: bytes = heatmap(rng, blobs)
+	return dimensions() + hid_frame(HID_FRAME_HEATMAP, bytes(5) + struct.pack("<I", len(data)) + data)
+
+
+def mpp(i: int, x: float, y: float, pressure: float) -> bytes:
+	state: int = 0x1 | (0x2 if pressure > 0 else 0)
+
+	sample: bytes = struct.pack(
+	    "<HHHHHHH2s",
+	    i & 0xFFFF,
+	    state,
+	    round(x * 9600),
+	    round(y * 7200),
+	    round(pressure * 4096),
+	    4500,
+	    (i * 30) % 36000,
+	    bytes(2),
+	)
+
+	data: bytes = struct.pack("<B3sI", 1, bytes(3), 0x1234) + sample
+	return hid_frame(HID_FRAME_REPORTS, report_frame(REPORT_STYLUS_MPP_1_51, data))
+
+
+def dft_row(position: float, magnitude: int) -> bytes:
+	first: int = int(position) - 4
+	amplitude: float = math.sqrt(magnitude)
+
+	real: list[int] = []
+	imag: list[int] = []
+
+	for i in range(9):
+		antenna: int = first + i
+		value: float = 0
+
+		if 0 <= antenna < COLUMNS:
+			value = amplitude * math.exp(-(antenna - position)**2 / 2)
+
+		real.append(round(value * 0.6))
+		imag.append(round(value * 0.8))
+
+	return struct.pack("<II9h9hbbbb", 1000000, magnitude, *real, *imag, first, first + 8, 4, 0)
+
+
+def dft(group: int, type: int, rows: list[tuple[bytes, bytes]]) -> bytes:
+	metadata: bytes = struct.pack("<IBB10s", group, group & 0xFF, type, bytes(10))
+	window: bytes = struct.pack("<IBB3sB2s", group * 100, len(rows), group & 0xFF, bytes(3), type,
+	                            bytes(2))
+
+	window += b"".join(x for (x, _) in rows)
+	window += b"".join(y for (_, y) in rows)
+
+	return hid_frame(
+	    HID_FRAME_REPORTS,
+	    report_frame(REPORT_DFT_METADATA, metadata) + report_frame(REPORT_DFT_WINDOW, window),
+	)
+
+
+def idle(rng: random.Random, i: int) -> bytes:
+	return touch(rng, [])
+
+
+def multitouch(rng: random.Random, i: int) -> bytes:
+	blobs: list[Blob] = []
+
+	# Five fingers moving on circles, that are lifted and placed again one after the other
+	for finger in range(5):
+		if (i // 50 + finger) % 6 == 0:
+			continue
+
+		a: float = i / 30 + finger * 2 * math.pi / 5
+		x: float = 32 + 20 * math.cos(a) + 4 * math.sin(i / 17)
+		y: float = 22 + 13 * math.sin(a)
+
+		blobs.append((x, y, 1.1, 0.9, 110))
+
+	return touch(rng, blobs)
+
+
+def palm(rng: random.Random, i: int) -> bytes:
+	# A resting palm and a finger, while a stylus is writing next to them
+	x: float = 0.4 + 0.2 * math.sin(i / 40)
+	y: float = 0.5 + 0.1 * math.sin(i / 13)
+
+	blobs: list[Blob] = [
+	    (COLUMNS * x + 8, ROWS * y + 5, 5.5, 3.5, 80 + 10 * math.sin(i / 20)),
+	    (50, 10, 1.1, 0.9, 100),
+	]
+
+	data: bytes = mpp(i, x, y, 0.5 + 0.3 * math.sin(i / 9))
+
+	if i % 2 == 0:
+		data += touch(rng, blobs)
+
+	return data
+
+
+def stylus(rng: random.Random, i: int) -> bytes:
+	# Strokes that alternate with hovering
+	x: float = 0.5 + 0.3 * math.cos(i / 50) + rng.gauss(0, 0.0005)
+	y: float = 0.5 + 0.3 * math.sin(i / 35) + rng.gauss(0, 0.0005)
+	pressure: float = 0.6 + 0.3 * math.sin(i / 25) if (i // 100) % 3 != 2 else 0
+
+	return mpp(i, x, y, pressure)
+
+
+def dft_stylus(rng: random.Random, i: int) -> bytes:
+	group: int = i // 3
+	x: float = 10 + 40 * (0.5 + 0.5 * math.sin(group / 40)) + rng.gauss(0, 0.01)
+	y: float = 8 + 25 * (0.5 + 0.5 * math.cos(group / 30)) + rng.gauss(0, 0.01)
+
+	# The pen is lifted out of range from time to time
+	magnitude: int = 40000 if (group // 80) % 4 != 3 else 500
+
+	data: bytes = dimensions()
+
+	if i % 3 == 0:
+		rows: list[tuple[bytes, bytes]] = [
+		    (dft_row(x, magnitude), dft_row(y, magnitude)),
+		    (dft_row(x + 1.5, magnitude), dft_row(y - 1, magnitude)),
+		]
+
+		data += dft(group, DFT_POSITION, rows)
+	elif i % 3 == 1:
+		data += dft(group, DFT_BUTTON, [(dft_row(x, magnitude), dft_row(y, magnitude))])
+	else:
+		# The pressure is encoded in which frequency has the highest magnitude
+		peak: float = 1 + 3 * (0.5 + 0.5 * math.sin(group / 15))
+		rows = []
+
+		for row in range(16):
+			m: int = round(magnitude * math.exp(-(row - peak)**2))
+			rows.append((dft_row(x, m), dft_row(y, m)))
+
+		data += dft(group, DFT_PRESSURE, rows)
+
+	# The touch sensor keeps sending data while the pen is used
+	if i % 6 == 0:
+		data += touch(rng, [])
+
+	return data
+
+
+SCENARIOS: dict[str, Callable[[random.Random, int], bytes]] = {
+    "idle": idle,
+    "multitouch": multitouch,
+    "palm": palm,
+    "mpp": stylus,
+    "dft": dft_stylus,
+}
+
+
+def write(path: Path, scenario: Callable[[random.Random, int], bytes], seed: int) -> None:
+	rng: random.Random = random.Random(seed)
+
+	with path.open("wb") as file:
+		# Device info: vendor, product, padding and buffer size
+		file.write(struct.pack("<HH4sQ", 0x045E, 0x0C1A, bytes(4), BUFFER_SIZE))
+
+		# Metadata: dimensions, transform and unknown values
+		file.write(b"\x01")
+		file.write(struct.pack("<IIII", ROWS, COLUMNS, 26000, 17300))
+		file.write(struct.pack("<6f", 1, 0, 0, 0, 1, 0))
+		file.write(bytes(65))
+
+		for i in range(REPORTS):
+			data: bytes = scenario(rng, i)
+			data = struct.pack("<BH", 0x0B, (i * 50) & 0xFFFF) + hid_frame(HID_FRAME_HID, data)
+
+			if len(data) > BUFFER_SIZE:
+				raise ValueError(f"Report {i} of {path.name} is larger than the buffer")
+
+			file.write(struct.pack("<Q", len(data)))
+			file.write(data + bytes(BUFFER_SIZE - len(data)))
+
+
+def main() -> int:
+	if len(sys.argv) != 2:
+		print(f"Usage: {sys.argv[0]} OUTDIR")
+		return 1
+
+	outdir: Path = Path(sys.argv[1])
+	outdir.mkdir(parents=True, exist_ok=True)
+
+	for seed, (name, scenario) in enumerate(SCENARIOS.items()):
+		write(outdir / f"{name}.bin", scenario, seed)
+
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
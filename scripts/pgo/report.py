@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Compares the performance of the regular and the profile guided optimized build of iptsd-perf.
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import re
+import subprocess
+import sys
+from pathlib import Path
+from typing import Optional
+
+# How many times every data file is processed.
+RUNS: str = "20"
+
+
+def mean(perf: Path, data: Path) -> Optional[float]:
+	ret = subprocess.run([str(perf), str(data), RUNS], capture_output=True, text=True)
+	match = re.search(r"Mean: (\S+)μs", ret.stdout)
+
+	if match is None:
+		raise RuntimeError(f"Failed to process {data} with {perf}")
+
+	# iptsd-perf only measures reports that contain a heatmap
+	value: float = float(match.group(1))
+
+	if math.isnan(value):
+		return None
+
+	return value
+
+
+def main() -> int:
+	parser = argparse.ArgumentParser(description="Reports the gain of PGO.")
+	parser.add_argument("--baseline", type=Path, required=True, help="The regular iptsd-perf")
+	parser.add_argument("--optimized", type=Path, required=True, help="The PGO iptsd-perf")
+	parser.add_argument("corpus", type=Path, nargs="+", help="The data files to compare")
+
+	args = parser.parse_args()
+
+	print(f"{'Data':<16} {'Baseline':>12} {'PGO':>12} {'Gain':>8}")
+
+	total_baseline: float = 0
+	total_optimized: float = 0
+
+	for data in args.corpus:
+		baseline = mean(args.baseline, data)
+		optimized = mean(args.optimized, data)
+
+		if baseline is None or optimized is None:
+			print(f"{data.stem:<16} {'-':>12} {'-':>12} {'-':>8}")
+			continue
+
+		total_baseline += baseline
+		total_optimized += optimized
+
+		gain: float = (1 - optimized / baseline) * 100
+		print(f"{data.stem:<16} {baseline:>10.2f}μs {optimized:>10.2f}μs {gain:>7.1f}%")
+
+	gain = (1 - total_optimized / total_baseline) * 100
+	print(f"{'Total':<16} {total_baseline:>10.2f}μs {total_optimized:>10.2f}μs {gain:>7.1f}%")
+
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
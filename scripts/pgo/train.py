@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Runs the instrumented build of iptsd-perf over the training workload to record a profile.
+"""
+
+from __future__ import annotations
+
+import argparse
+import os
+import subprocess
+import sys
+from pathlib import Path
+
+# How many times every data file is processed.
+RUNS: str = "5"
+
+# The heatmap widths that are used for training the contact detection on larger sensors.
+SYNTHETIC: list[str] = ["64", "128"]
+
+
+def main() -> int:
+	parser = argparse.ArgumentParser(description="Records a profile of iptsd-perf.")
+	parser.add_argument("--perf", type=Path, required=True, help="The instrumented iptsd-perf")
+	parser.add_argument("--profile", type=Path, required=True, help="The profile directory")
+	parser.add_argument("--merge", help="llvm-profdata, for merging raw profiles of clang")
+	parser.add_argument("--stamp", type=Path, required=True, help="Written after training")
+	parser.add_argument("corpus", type=Path, nargs="+", help="The training data files")
+
+	args = parser.parse_args()
+	profile: Path = args.profile
+
+	# Counters are accumulated by the instrumentation, old data would skew the new profile.
+	profile.mkdir(parents=True, exist_ok=True)
+
+	for file in profile.iterdir():
+		if file.suffix in [".gcda", ".profraw", ".profdata"]:
+			file.unlink()
+
+	env: dict[str, str] = dict(os.environ)
+	env["LLVM_PROFILE_FILE"] = str(profile / "iptsd-%p.profraw")
+
+	commands: list[list[str]] = [[str(args.perf), str(data), RUNS] for data in args.corpus]
+	commands.append([str(args.perf), "--synthetic", *SYNTHETIC])
+
+	for command in commands:
+		ret = subprocess.run(command, env=env, stdout=subprocess.DEVNULL)
+
+		# The exit code of iptsd-perf doesn't tell whether all data was processed,
+		# but a crash means that the profile was not written.
+		if ret.returncode < 0:
+			print(f"ERROR: Training failed: {' '.join(command)}")
+			return 1
+
+	if args.merge:
+		raw: list[str] = [str(file) for file in profile.glob("*.profraw")]
+		output: str = str(profile / "iptsd.profdata")
+
+		subprocess.run([args.merge, "merge", "-output", output, *raw], check=True)
+
+	args.stamp.write_text("// Generated after recording the profile for PGO, do not edit.\n")
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
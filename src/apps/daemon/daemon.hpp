@@ -10,6 +10,7 @@
 #include <contacts/contact.hpp>
 #include <core/generic/application.hpp>
 #include <core/generic/config.hpp>
+#include <core/linux/ring-writer.hpp>
 #include <ipts/data.hpp>
 
 #include <spdlog/spdlog.h>
@@ -20,20 +21,27 @@
 namespace iptsd::apps::daemon {
 
 class Daemon : public core::Application {
-private:
+protected:
 	// The touchscreen device.
 	TouchDevice m_touch;
 
 	// The stylus device.
 	StylusDevice m_stylus;
 
+	// The shared memory ring for other programs, if it is enabled.
+	std::optional<core::linux::RingWriter> m_ring {};
+
 public:
 	Daemon(const core::Config &config,
 	       const core::DeviceInfo &info,
 	       const std::optional<const ipts::Metadata> &metadata)
 		: core::Application(config, info, metadata),
 		  m_touch {config, info},
-		  m_stylus {config, info} {};
+		  m_stylus {config, info}
+	{
+		if (!config.output_shared_memory.empty())
+			m_ring.emplace(config.output_shared_memory, config, info);
+	}
 
 	void on_start() override
 	{
@@ -46,6 +54,9 @@ public:
 
 	void on_contacts(const std::vector<contacts::Contact<f64>> &contacts) override
 	{
+		if (m_ring.has_value())
+			m_ring->update(contacts, m_timeline.now());
+
 		if (m_config.touch_disable)
 			return;
 
@@ -58,6 +69,9 @@ public:
 
 	void on_stylus(const ipts::StylusData &stylus) override
 	{
+		if (m_ring.has_value())
+			m_ring->update(stylus, m_timeline.now());
+
 		if (m_config.stylus_disable)
 			return;
 
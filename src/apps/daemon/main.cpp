@@ -2,7 +2,10 @@
 
 #include "daemon.hpp"
 
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
 #include <common/types.hpp>
+#include <core/generic/startup.hpp>
 #include <core/linux/device-runner.hpp>
 #include <core/linux/signal-handler.hpp>
 
@@ -10,15 +13,82 @@
 #include <gsl/gsl>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <csignal>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace iptsd::apps::daemon {
 namespace {
 
+/*!
+ * Brings the device up and down repeatedly, and prints how long the steps took.
+ *
+ * @param[in] path The hidraw device node of the touchscreen.
+ * @param[in] runs How many times the device is brought up.
+ */
+void run_startup_benchmark(const std::filesystem::path &path, const usize runs)
+{
+	using ms = milliseconds<f64>;
+
+	struct Step {
+		std::string_view name;
+
+		f64 sum = 0;
+		f64 min = std::numeric_limits<f64>::infinity();
+		f64 max = 0;
+	};
+
+	std::vector<Step> steps {};
+
+	// The log of every single run would hide the results.
+	const spdlog::level::level_enum level = spdlog::get_level();
+	spdlog::set_level(spdlog::level::warn);
+
+	for (usize i = 0; i <= runs; i++) {
+		core::linux::DeviceRunner<Daemon> daemon {path};
+
+		// Switches the device to multitouch mode and right back, without reading any data.
+		daemon.stop();
+		daemon.run();
+
+		// The first run fills the caches of the kernel and is not counted.
+		if (i == 0)
+			continue;
+
+		const std::vector<core::StartupTrace::Step> &trace = daemon.startup().steps();
+		steps.resize(trace.size());
+
+		for (usize j = 0; j < trace.size(); j++) {
+			const f64 duration = chrono::duration_cast<ms>(trace[j].duration).count();
+
+			Step &step = steps[j];
+			step.name = trace[j].name;
+			step.sum += duration;
+			step.min = std::min(step.min, duration);
+			step.max = std::max(step.max, duration);
+		}
+	}
+
+	spdlog::set_level(level);
+
+	spdlog::info("Startup over {} runs:", runs);
+	spdlog::info("  {:<12} {:>10} {:>10} {:>10}", "(ms)", "Mean", "Min", "Max");
+
+	for (const Step &step : steps) {
+		spdlog::info("  {:<12} {:>10.3f} {:>10.3f} {:>10.3f}",
+		             step.name,
+		             step.sum / casts::to<f64>(runs),
+		             step.min,
+		             step.max);
+	}
+}
+
 int run(const int argc, const char **argv)
 {
 	CLI::App app {"Daemon to translate touchscreen inputs to Linux input events."};
@@ -29,8 +99,19 @@ int run(const int argc, const char **argv)
 		->type_name("FILE")
 		->required();
 
+	usize benchmark = 0;
+	app.add_option("--startup-benchmark", benchmark)
+		->description("Measure how long it takes to bring up the device, over RUNS runs.")
+		->type_name("RUNS")
+		->check(CLI::PositiveNumber);
+
 	CLI11_PARSE(app, argc, argv);
 
+	if (benchmark > 0) {
+		run_startup_benchmark(path, benchmark);
+		return 0;
+	}
+
 	// Create a daemon application that reads from a device.
 	core::linux::DeviceRunner<Daemon> daemon {path};
 
@@ -156,6 +156,14 @@ public:
 		return m_active;
 	}
 
+	/*!
+	 * The uinput device that the stylus events are emitted through.
+	 */
+	[[nodiscard]] const UinputDevice &device() const
+	{
+		return *m_uinput;
+	}
+
 private:
 	/*!
 	 * Calculates the tilt of the stylus on X and Y axis.
@@ -157,6 +157,14 @@ public:
 		return !m_current.empty();
 	}
 
+	/*!
+	 * The uinput device that the touchscreen events are emitted through.
+	 */
+	[[nodiscard]] const UinputDevice &device() const
+	{
+		return *m_uinput;
+	}
+
 private:
 	/*!
 	 * Builds the difference between the current and the last frame.
@@ -3,14 +3,18 @@
 #ifndef IPTSD_APPS_DAEMON_UINPUT_DEVICE_HPP
 #define IPTSD_APPS_DAEMON_UINPUT_DEVICE_HPP
 
+#include <common/error.hpp>
 #include <common/types.hpp>
+#include <core/linux/errors.hpp>
 #include <core/linux/syscalls.hpp>
 
 #include <linux/input.h>
 #include <linux/uinput.h>
 
+#include <array>
 #include <exception>
 #include <fcntl.h>
+#include <filesystem>
 #include <string>
 #include <utility>
 
@@ -166,6 +170,31 @@ public:
 		syscalls::ioctl(m_fd, UI_DEV_CREATE);
 	}
 
+	/*!
+	 * Determines the event node that the kernel created for the device.
+	 *
+	 * Must be called after @ref create().
+	 *
+	 * @return The path of the event node, e.g. /dev/input/event5.
+	 */
+	[[nodiscard]] std::filesystem::path event_node() const
+	{
+		std::array<char, 64> name {};
+		syscalls::ioctl(m_fd, UI_GET_SYSNAME(name.size()), name.data());
+
+		const std::filesystem::path sysfs = std::filesystem::path {"/sys/class/input"} /
+		                                    name.data();
+
+		for (const auto &entry : std::filesystem::directory_iterator {sysfs}) {
+			const std::string node = entry.path().filename().string();
+
+			if (node.rfind("event", 0) == 0)
+				return std::filesystem::path {"/dev/input"} / node;
+		}
+
+		throw common::Error<core::linux::Error::EventNodeNotFound> {name.data()};
+	}
+
 	/*!
 	 * Emits an event.
 	 *
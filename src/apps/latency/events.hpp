@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_LATENCY_EVENTS_HPP
+#define IPTSD_APPS_LATENCY_EVENTS_HPP
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/linux/syscalls.hpp>
+
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <linux/input.h>
+#include <poll.h>
+
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <exception>
+#include <fcntl.h>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace iptsd::apps::latency {
+
+/*
+ * An input event that was read back from an event node.
+ */
+struct Event {
+	// The index of the event node that the event was read from.
+	usize device = 0;
+
+	// The event, including the time at which the kernel received it.
+	struct input_event event {};
+
+	// The time at which the event was read.
+	chrono::steady_clock::time_point received {};
+
+	/*!
+	 * The time at which the kernel received the event.
+	 */
+	[[nodiscard]] chrono::steady_clock::time_point timestamp() const
+	{
+		const chrono::seconds sec {event.input_event_sec};
+		const chrono::microseconds usec {event.input_event_usec};
+
+		const auto time = chrono::duration_cast<chrono::steady_clock::duration>(sec + usec);
+		return chrono::steady_clock::time_point {time};
+	}
+};
+
+/*
+ * Reads events from a list of event nodes on a separate thread.
+ *
+ * The kernel is told to timestamp the events with the monotonic clock,
+ * which is the same clock std::chrono::steady_clock uses on Linux.
+ */
+class EventReader {
+private:
+	// The file descriptors of the opened event nodes.
+	std::vector<int> m_fds {};
+
+	// All events that were read.
+	std::vector<Event> m_events {};
+
+	// Whether the reading thread should stop.
+	std::atomic_bool m_should_stop = false;
+
+	std::thread m_thread {};
+
+public:
+	EventReader(const std::vector<std::filesystem::path> &nodes)
+	{
+		for (const std::filesystem::path &node : nodes) {
+			const int fd = core::linux::syscalls::open(node, O_RDONLY | O_NONBLOCK);
+			m_fds.push_back(fd);
+
+			int clock = CLOCK_MONOTONIC;
+			core::linux::syscalls::ioctl(fd, EVIOCSCLOCKID, &clock);
+		}
+
+		m_thread = std::thread {[&]() { this->read(); }};
+	}
+
+	~EventReader()
+	{
+		this->stop();
+
+		try {
+			for (const int fd : m_fds)
+				core::linux::syscalls::close(fd);
+		} catch (const std::exception & /* unused */) {
+			// ignored
+		}
+	}
+
+	EventReader(const EventReader &) = delete;
+	EventReader &operator=(const EventReader &) = delete;
+
+	/*!
+	 * Stops reading events.
+	 */
+	void stop()
+	{
+		m_should_stop = true;
+
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	/*!
+	 * All events that were read.
+	 *
+	 * Must only be called after @ref stop().
+	 */
+	[[nodiscard]] const std::vector<Event> &events() const
+	{
+		return m_events;
+	}
+
+private:
+	/*!
+	 * The main loop of the reading thread.
+	 */
+	void read()
+	{
+		std::vector<struct pollfd> fds {};
+
+		for (const int fd : m_fds)
+			fds.push_back(pollfd {fd, POLLIN, 0});
+
+		try {
+			while (!m_should_stop) {
+				// Wake up regularly to check if the thread should stop.
+				if (core::linux::syscalls::poll(fds, 10) == 0)
+					continue;
+
+				for (usize i = 0; i < fds.size(); i++) {
+					if ((fds[i].revents & POLLIN) != 0)
+						this->read_from(i);
+				}
+			}
+		} catch (const std::exception &e) {
+			spdlog::error(e.what());
+		}
+	}
+
+	/*!
+	 * Reads the pending events from an event node.
+	 *
+	 * @param[in] device The index of the event node.
+	 */
+	void read_from(const usize device)
+	{
+		std::array<struct input_event, 64> buffer {};
+
+		const gsl::span<struct input_event> dest {buffer};
+		const isize size = core::linux::syscalls::read(m_fds[device], dest);
+
+		const auto now = chrono::steady_clock::now();
+		const usize count = casts::to_unsigned(size) / sizeof(struct input_event);
+
+		for (usize i = 0; i < count; i++)
+			m_events.push_back(Event {device, buffer.at(i), now});
+	}
+};
+
+} // namespace iptsd::apps::latency
+
+#endif // IPTSD_APPS_LATENCY_EVENTS_HPP
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_LATENCY_LATENCY_HPP
+#define IPTSD_APPS_LATENCY_LATENCY_HPP
+
+#include "events.hpp"
+
+#include <apps/daemon/daemon.hpp>
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/generic/config.hpp>
+#include <core/generic/device.hpp>
+#include <ipts/data.hpp>
+
+#include <gsl/gsl>
+
+#include <linux/input-event-codes.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace iptsd::apps::latency {
+
+/*
+ * Collects durations and summarizes their distribution.
+ */
+class Distribution {
+private:
+	// The collected durations in microseconds.
+	std::vector<f64> m_values {};
+
+public:
+	/*!
+	 * Adds a duration to the distribution.
+	 *
+	 * @param[in] value The duration.
+	 */
+	void add(const chrono::steady_clock::duration value)
+	{
+		m_values.push_back(chrono::duration_cast<microseconds<f64>>(value).count());
+	}
+
+	/*!
+	 * The number of collected durations.
+	 */
+	[[nodiscard]] usize count() const
+	{
+		return m_values.size();
+	}
+
+	/*!
+	 * The average duration in microseconds.
+	 */
+	[[nodiscard]] f64 mean() const
+	{
+		if (m_values.empty())
+			return 0;
+
+		const f64 sum = std::accumulate(m_values.begin(), m_values.end(), 0.0);
+		return sum / casts::to<f64>(m_values.size());
+	}
+
+	/*!
+	 * The duration in microseconds that a fraction of the collected durations is below.
+	 *
+	 * @param[in] fraction The fraction of durations, between 0 and 1.
+	 * @return The smallest duration that is larger than the given fraction of durations.
+	 */
+	[[nodiscard]] f64 percentile(const f64 fraction) const
+	{
+		if (m_values.empty())
+			return 0;
+
+		std::vector<f64> values = m_values;
+
+		const f64 last = casts::to<f64>(values.size() - 1);
+		const f64 position = std::clamp(fraction, 0.0, 1.0) * last;
+		const usize index = casts::to<usize>(std::round(position));
+
+		const auto nth = values.begin() + casts::to_signed(index);
+		std::nth_element(values.begin(), nth, values.end());
+
+		return *nth;
+	}
+};
+
+/*
+ * Runs the daemon and records when every report was processed.
+ */
+class Latency : public daemon::Daemon {
+private:
+	using clock = chrono::steady_clock;
+
+public:
+	struct Report {
+		// The time at which processing the report started.
+		clock::time_point start {};
+
+		// The time at which processing the report was done.
+		clock::time_point end {};
+	};
+
+public:
+	// All processed reports, in the order they were processed.
+	std::vector<Report> reports {};
+
+public:
+	Latency(const core::Config &config,
+	        const core::DeviceInfo &info,
+	        const std::optional<const ipts::Metadata> &metadata)
+		: daemon::Daemon(config, info, metadata) {};
+
+	void on_data(const gsl::span<u8> data) override
+	{
+		const clock::time_point start = clock::now();
+
+		daemon::Daemon::on_data(data);
+
+		reports.push_back(Report {start, clock::now()});
+	}
+
+	/*!
+	 * The event nodes of the devices that the daemon created.
+	 *
+	 * @return The event nodes of the touchscreen and stylus device, in that order.
+	 */
+	[[nodiscard]] std::vector<std::filesystem::path> event_nodes() const
+	{
+		return {m_touch.device().event_node(), m_stylus.device().event_node()};
+	}
+};
+
+/*
+ * Matches the events that were read back to the reports that caused them.
+ *
+ * The daemon emits events while it processes a report, so a frame of events belongs to the
+ * report that was being processed when the kernel received its SYN_REPORT event.
+ */
+class Analysis {
+public:
+	// The names of the devices, in the order of their event nodes.
+	static constexpr std::array<const char *, 2> NAMES {"Touch", "Stylus"};
+
+	struct Device {
+		// The time from receiving a report until the kernel received the resulting frame.
+		Distribution kernel {};
+
+		// The time from receiving a report until the resulting frame was read back.
+		Distribution delivery {};
+
+		// The number of frames, which are terminated by a SYN_REPORT event.
+		usize frames = 0;
+
+		// The number of events, including the SYN_REPORT events.
+		usize events = 0;
+
+		// How often the kernel dropped events because they were not read quickly enough.
+		usize dropped = 0;
+
+		// The number of frames that were not received while a report was processed.
+		usize unmatched = 0;
+	};
+
+public:
+	std::array<Device, NAMES.size()> devices {};
+
+	// The number of processed reports.
+	usize reports = 0;
+
+	// The number of reports that resulted in at least one frame.
+	usize productive = 0;
+
+public:
+	Analysis(const std::vector<Latency::Report> &processed, const std::vector<Event> &events)
+		: reports {processed.size()}
+	{
+		std::vector<bool> matched(processed.size(), false);
+
+		for (const Event &event : events) {
+			Device &device = devices.at(event.device);
+			device.events++;
+
+			if (event.event.type != EV_SYN)
+				continue;
+
+			if (event.event.code == SYN_DROPPED) {
+				device.dropped++;
+				continue;
+			}
+
+			if (event.event.code != SYN_REPORT)
+				continue;
+
+			device.frames++;
+
+			const std::optional<usize> index = find(processed, event.timestamp());
+
+			if (!index.has_value()) {
+				device.unmatched++;
+				continue;
+			}
+
+			const Latency::Report &report = processed[index.value()];
+
+			device.kernel.add(event.timestamp() - report.start);
+			device.delivery.add(event.received - report.start);
+
+			matched[index.value()] = true;
+		}
+
+		productive = casts::to_unsigned(std::count(matched.begin(), matched.end(), true));
+	}
+
+private:
+	/*!
+	 * Searches for the report that was being processed at a given time.
+	 *
+	 * @param[in] reports All processed reports.
+	 * @param[in] time The time to search for.
+	 * @return The index of the report, or nothing if no report was being processed.
+	 */
+	static std::optional<usize> find(const std::vector<Latency::Report> &reports,
+	                                 const chrono::steady_clock::time_point time)
+	{
+		const auto after = [](const auto t, const Latency::Report &r) {
+			return t < r.start;
+		};
+
+		// The first report that started after the given time.
+		const auto it = std::upper_bound(reports.begin(), reports.end(), time, after);
+
+		if (it == reports.begin())
+			return std::nullopt;
+
+		const auto report = std::prev(it);
+
+		if (time > report->end)
+			return std::nullopt;
+
+		return casts::to_unsigned(std::distance(reports.begin(), report));
+	}
+};
+
+} // namespace iptsd::apps::latency
+
+#endif // IPTSD_APPS_LATENCY_LATENCY_HPP
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "events.hpp"
+#include "latency.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/linux/file-runner.hpp>
+#include <core/linux/signal-handler.hpp>
+
+#include <CLI/CLI.hpp>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace iptsd::apps::latency {
+namespace {
+
+/*!
+ * Prints the summary of a distribution.
+ *
+ * @param[in] name The name of the distribution.
+ * @param[in] distribution The distribution to print.
+ */
+void print(const std::string &name, const Distribution &distribution)
+{
+	spdlog::info("  {:<10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}",
+	             name,
+	             distribution.mean(),
+	             distribution.percentile(0.5),
+	             distribution.percentile(0.95),
+	             distribution.percentile(0.99),
+	             distribution.percentile(1.0));
+}
+
+int run(const int argc, const char **argv)
+{
+	CLI::App app {"Utility for measuring the latency from touch reports to input events."};
+
+	std::filesystem::path path {};
+	app.add_option("DATA", path)
+		->description("A binary data file containing touch reports.")
+		->type_name("FILE")
+		->required();
+
+	f64 speed {};
+	app.add_option("-p,--pace", speed)
+		->description("Replay the data at the speed it was recorded at, times this factor.")
+		->type_name("SPEED")
+		->check(CLI::PositiveNumber)
+		->default_val(1);
+
+	CLI11_PARSE(app, argc, argv);
+
+	// Run the daemon on the recorded data, it creates the same devices as on real hardware.
+	core::linux::FileRunner<Latency> latency {path};
+	latency.pace(speed);
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { latency.stop(); });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { latency.stop(); });
+
+	const Latency &daemon = latency.application();
+
+	// Read the events back from the devices the daemon created.
+	EventReader reader {daemon.event_nodes()};
+
+	const bool should_stop = latency.run();
+
+	// Give the kernel time to deliver the last events.
+	std::this_thread::sleep_for(100ms);
+	reader.stop();
+
+	const Analysis analysis {daemon.reports, reader.events()};
+
+	spdlog::info("Reports: {}, {} of them emitted input events",
+	             analysis.reports,
+	             analysis.productive);
+
+	for (usize i = 0; i < Analysis::NAMES.size(); i++) {
+		const Analysis::Device &device = analysis.devices.at(i);
+
+		if (device.frames == 0)
+			continue;
+
+		const f64 per_frame = casts::to<f64>(device.events) / casts::to<f64>(device.frames);
+
+		spdlog::info("{}: {} frames, {} events ({:.1f} per frame)",
+		             Analysis::NAMES.at(i),
+		             device.frames,
+		             device.events,
+		             per_frame);
+
+		spdlog::info("  Dropped: {}, Unmatched: {}", device.dropped, device.unmatched);
+
+		spdlog::info("  {:<10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+		             "(μs)",
+		             "Mean",
+		             "Median",
+		             "95%",
+		             "99%",
+		             "Max");
+
+		print("Kernel", device.kernel);
+		print("Delivery", device.delivery);
+	}
+
+	if (should_stop)
+		return EXIT_FAILURE;
+
+	return 0;
+}
+
+} // namespace
+} // namespace iptsd::apps::latency
+
+int main(const int argc, const char **argv)
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	try {
+		return iptsd::apps::latency::run(argc, argv);
+	} catch (const std::exception &e) {
+		spdlog::error(e.what());
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/linux/signal-handler.hpp>
+#include <ring/layout.hpp>
+#include <ring/reader.hpp>
+
+#include <CLI/CLI.hpp>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace iptsd::apps::monitor {
+namespace {
+
+/*!
+ * Prints a frame that was read from the ring.
+ *
+ * @param[in] frame The frame to print.
+ * @param[in] delay How long it took until the frame was read.
+ */
+void print(const ring::Frame &frame, const f64 delay)
+{
+	if ((frame.flags & ring::flags::STYLUS) != 0) {
+		const ring::Stylus &stylus = frame.stylus;
+
+		spdlog::info("{:>8} {:>8.1f}us  Stylus: {:.3f} {:.3f} {:.3f} {}{}{}",
+		             frame.sequence,
+		             delay,
+		             stylus.x,
+		             stylus.y,
+		             stylus.pressure,
+		             stylus.proximity != 0 ? "P" : "-",
+		             stylus.contact != 0 ? "C" : "-",
+		             stylus.button != 0 ? "B" : "-");
+
+		return;
+	}
+
+	spdlog::info("{:>8} {:>8.1f}us  Contacts: {}{}",
+	             frame.sequence,
+	             delay,
+	             frame.contact_count,
+	             (frame.flags & ring::flags::TRUNCATED) != 0 ? " (truncated)" : "");
+
+	for (u32 i = 0; i < frame.contact_count; i++) {
+		const ring::Contact &contact = frame.contacts.at(i);
+
+		spdlog::info("{:>29}: {:.3f} {:.3f} {:.3f} {:.3f}",
+		             contact.index,
+		             contact.x,
+		             contact.y,
+		             contact.major,
+		             contact.minor);
+	}
+}
+
+int run(const int argc, const char **argv)
+{
+	CLI::App app {"Utility for reading the output of iptsd from shared memory."};
+
+	std::string name = ring::DEFAULT_NAME;
+	app.add_option("NAME", name)
+		->description("The name of the ring, as configured for iptsd.")
+		->type_name("NAME")
+		->default_val(ring::DEFAULT_NAME);
+
+	bool quiet = false;
+	app.add_flag("-q,--quiet", quiet)->description("Only print a summary when exiting.");
+
+	CLI11_PARSE(app, argc, argv);
+
+	std::atomic_bool running = true;
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { running = false; });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { running = false; });
+
+	std::optional<ring::Reader> reader {};
+
+	// iptsd could still be creating the ring.
+	while (running && !reader.has_value()) {
+		try {
+			reader.emplace(name);
+		} catch (const ring::NotReady &) {
+			std::this_thread::sleep_for(10ms);
+		}
+	}
+
+	if (!reader.has_value())
+		return 0;
+
+	const ring::Header &header = reader->header();
+	spdlog::info("Connected to {:04X}:{:04X}", header.vendor, header.product);
+
+	ring::Frame frame {};
+
+	usize frames = 0;
+	usize lost = 0;
+	f64 delays = 0;
+
+	u64 expected = reader->head();
+
+	while (running && reader->active()) {
+		if (reader->next(frame) != ring::Status::Ok) {
+			std::this_thread::sleep_for(1ms);
+			continue;
+		}
+
+		using us = microseconds<f64>;
+		using ns = chrono::nanoseconds;
+
+		const ns now = chrono::steady_clock::now().time_since_epoch();
+		const ns published {casts::to_signed(frame.time)};
+
+		const f64 delay = chrono::duration_cast<us>(now - published).count();
+
+		frames++;
+		lost += frame.sequence - expected;
+		delays += delay;
+
+		expected = frame.sequence + 1;
+
+		if (!quiet)
+			print(frame, delay);
+	}
+
+	if (!reader->active())
+		spdlog::info("iptsd stopped publishing to the ring");
+
+	if (frames > 0) {
+		spdlog::info("Read {} frames, lost {}, average delay {:.1f}us",
+		             frames,
+		             lost,
+		             delays / casts::to<f64>(frames));
+	}
+
+	return 0;
+}
+
+} // namespace
+} // namespace iptsd::apps::monitor
+
+int main(const int argc, const char **argv)
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	try {
+		return iptsd::apps::monitor::run(argc, argv);
+	} catch (const std::exception &e) {
+		spdlog::error(e.what());
+		return EXIT_FAILURE;
+	}
+}
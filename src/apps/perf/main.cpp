@@ -1,11 +1,17 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "perf.hpp"
+#include "synthetic.hpp"
 
 #include <common/casts.hpp>
 #include <common/chrono.hpp>
+#include <common/cpu.hpp>
 #include <common/types.hpp>
+#include <contacts/contact.hpp>
+#include <core/generic/config.hpp>
+#include <core/linux/device-runner.hpp>
 #include <core/linux/file-runner.hpp>
+#include <core/linux/mock-device.hpp>
 #include <core/linux/signal-handler.hpp>
 
 #include <CLI/CLI.hpp>
@@ -13,24 +19,291 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace iptsd::apps::perf {
 namespace {
 
+/*!
+ * Compares the different ways of detecting contacts on synthetic heatmaps.
+ *
+ * @param[in] sizes The widths of the heatmaps that are tested.
+ * @param[in] runs How many times every set of heatmaps is processed.
+ */
+void run_synthetic(const std::vector<Eigen::Index> &sizes, const usize runs)
+{
+	using Engine = contacts::detection::Engine;
+
+	struct Mode {
+		const char *name;
+		std::optional<usize> pyramid_threshold;
+		std::optional<usize> parallel_threshold;
+		Engine engine;
+		bool batch;
+	};
+
+	const std::array<Mode, 7> modes {
+		Mode {"Full", std::nullopt, std::nullopt, Engine::GAUSSIAN, false},
+		Mode {"Pyramid", 0, std::nullopt, Engine::GAUSSIAN, false},
+		Mode {"Parallel", std::nullopt, 0, Engine::GAUSSIAN, false},
+		Mode {"Pyramid+Parallel", 0, 0, Engine::GAUSSIAN, false},
+		Mode {"Batch", std::nullopt, std::nullopt, Engine::GAUSSIAN, true},
+		Mode {"Moments", std::nullopt, std::nullopt, Engine::MOMENTS, false},
+		Mode {"Hybrid", std::nullopt, std::nullopt, Engine::HYBRID, false},
+	};
+
+	core::Config config {};
+	config.width = 26;
+	config.height = 17.3;
+
+	for (const Eigen::Index size : sizes) {
+		const Synthetic synthetic {size};
+
+		spdlog::info("{} pixels:", synthetic.pixels());
+
+		for (const Mode &mode : modes) {
+			contacts::Config<f64> cfg = config.contacts();
+			cfg.detection.pyramid_threshold = mode.pyramid_threshold;
+			cfg.detection.parallel_threshold = mode.parallel_threshold;
+			cfg.detection.engine = mode.engine;
+
+			SyntheticResult result {};
+
+			if (mode.batch)
+				result = synthetic.run_batch(cfg, runs);
+			else
+				result = synthetic.run(cfg, runs);
+
+			spdlog::info("  {:<16} {:8.2f}μs, {:.2f} contacts, {:.3f}px error",
+			             mode.name,
+			             result.mean.count(),
+			             result.contacts,
+			             result.error);
+		}
+	}
+}
+
+/*!
+ * Compares the contacts found by a detection engine to the ones found by gaussian fitting.
+ *
+ * @param[in] name The name of the engine.
+ * @param[in] perf The application that ran the engine and recorded its contacts.
+ * @param[in] reference The contacts found by gaussian fitting.
+ */
+void compare(const std::string &name,
+             const Perf &perf,
+             const std::vector<std::vector<contacts::Contact<f64>>> &reference)
+{
+	// The contacts are normalized, convert them back to millimeters.
+	const Vector2<f64> scale {perf.config().width * 10, perf.config().height * 10};
+
+	f64 sum = 0;
+	f64 max = 0;
+	f64 size = 0;
+
+	usize count = 0;
+	usize mismatched = 0;
+
+	const usize frames = std::min(reference.size(), perf.frames.size());
+
+	for (usize i = 0; i < frames; i++) {
+		const std::vector<contacts::Contact<f64>> &expected = reference[i];
+		const std::vector<contacts::Contact<f64>> &found = perf.frames[i];
+
+		if (expected.size() != found.size())
+			mismatched++;
+
+		for (const contacts::Contact<f64> &a : expected) {
+			const contacts::Contact<f64> *closest = nullptr;
+			f64 distance = std::numeric_limits<f64>::infinity();
+
+			for (const contacts::Contact<f64> &b : found) {
+				const f64 d = (a.mean - b.mean).cwiseProduct(scale).norm();
+
+				if (d >= distance)
+					continue;
+
+				closest = &b;
+				distance = d;
+			}
+
+			if (closest == nullptr)
+				continue;
+
+			sum += distance;
+			max = std::max(max, distance);
+			size += closest->size.x() / a.size.x();
+
+			count++;
+		}
+	}
+
+	const f64 n = casts::to<f64>(std::max(count, usize {1}));
+
+	spdlog::info("  {:<10} {:8.2f}μs, {:.3f}mm mean / {:.3f}mm max deviation, "
+	             "{:.3f}x size, {} frames with other contacts",
+	             name,
+	             casts::to<f64>(perf.total) / casts::to<f64>(std::max(perf.count, usize {1})),
+	             sum / n,
+	             max,
+	             size / n,
+	             mismatched);
+}
+
+/*!
+ * Processes the data with every contact detection engine, to compare their cost and accuracy.
+ *
+ * Gaussian fitting is used as the reference that the other engines are compared to.
+ *
+ * @param[in] path The binary data file containing touch reports.
+ * @param[in] runs How many times the data will be processed by every engine.
+ * @return Whether the run was interrupted.
+ */
+bool run_engines(const std::filesystem::path &path, const usize runs)
+{
+	const std::array<std::string, 3> engines {"gaussian", "moments", "hybrid"};
+
+	std::vector<std::vector<contacts::Contact<f64>>> reference {};
+
+	// The log of loading the data would hide the results.
+	const spdlog::level::level_enum level = spdlog::get_level();
+
+	spdlog::info("Engines:");
+
+	for (const std::string &engine : engines) {
+		spdlog::set_level(spdlog::level::warn);
+
+		core::linux::FileRunner<Perf> perf {path, std::optional<std::string> {engine}};
+		Perf &papp = perf.application();
+
+		usize total = 0;
+		usize count = 0;
+
+		for (usize i = 0; i < runs; i++) {
+			// Only the first run is recorded, the tracking is identical in all of them.
+			papp.record = i == 0;
+
+			if (perf.run()) {
+				spdlog::set_level(level);
+				return true;
+			}
+
+			total += papp.total;
+			count += papp.count;
+
+			papp.reset();
+		}
+
+		papp.total = total;
+		papp.count = count;
+
+		spdlog::set_level(level);
+
+		if (reference.empty())
+			reference = papp.frames;
+
+		compare(engine, papp, reference);
+	}
+
+	return false;
+}
+
+/*!
+ * Prints the timing statistics of processing the reports.
+ *
+ * @param[in] total The summed processing time in microseconds.
+ * @param[in] total_of_squares The summed squares of the processing times.
+ * @param[in] count How many reports were processed.
+ * @param[in] min The shortest processing time.
+ * @param[in] max The longest processing time.
+ */
+void print(const usize total,
+           const usize total_of_squares,
+           const usize count,
+           const chrono::steady_clock::duration min,
+           const chrono::steady_clock::duration max)
+{
+	const f64 n = casts::to<f64>(count);
+	const f64 mean = casts::to<f64>(total) / n;
+	const f64 stddev = std::sqrt(casts::to<f64>(total_of_squares) / n - mean * mean);
+
+	spdlog::info("Ran {} times", count);
+	spdlog::info("Total: {}μs", total);
+	spdlog::info("Mean: {:.2f}μs", mean);
+	spdlog::info("Standard Deviation: {:.2f}μs", stddev);
+	spdlog::info("Minimum: {:.3f}μs", chrono::duration_cast<microseconds<f64>>(min).count());
+	spdlog::info("Maximum: {:.3f}μs", chrono::duration_cast<microseconds<f64>>(max).count());
+}
+
+/*!
+ * Processes the data through a mock HID device and the same runner that is used for real devices.
+ *
+ * @param[in] path The binary data file containing touch reports.
+ * @param[in] runs How many times the data will be processed.
+ * @param[in] speed A factor for the replay speed. If it is not set, reports are not paced.
+ * @param[in] interval The fixed time between two reports, if set.
+ * @param[in] fail_every Every n-th read from the device fails. Zero disables failures.
+ * @return Whether the run was interrupted.
+ */
+bool run_device(const std::filesystem::path &path,
+                const usize runs,
+                const std::optional<f64> speed,
+                const std::optional<usize> interval,
+                const usize fail_every)
+{
+	const auto device = std::make_shared<core::linux::MockDevice>(path);
+	device->pace(speed);
+	device->fail_every(fail_every);
+
+	if (interval.has_value())
+		device->interval(chrono::microseconds {casts::to_signed(interval.value())});
+
+	core::linux::DeviceRunner<Perf> perf {device};
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { perf.stop(); });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { perf.stop(); });
+
+	usize passes = 0;
+	bool done = false;
+
+	device->on_wrap = [&]() {
+		if (++passes < runs)
+			return;
+
+		done = true;
+		perf.stop();
+	};
+
+	perf.run();
+
+	const Perf &papp = perf.application();
+	print(papp.total, papp.total_of_squares, papp.count, papp.min, papp.max);
+
+	if (papp.malformed() > 0)
+		spdlog::warn("Skipped {} malformed reports", papp.malformed());
+
+	spdlog::info("Read {} reports from the mock device", passes * device->size());
+
+	return !done;
+}
+
 int run(const int argc, const char **argv)
 {
 	CLI::App app {"Utility for performance testing of iptsd."};
 
 	std::filesystem::path path {};
-	app.add_option("DATA", path)
+	CLI::Option *data = app.add_option("DATA", path)
 		->description("A binary data file containing touch reports.")
-		->type_name("FILE")
-		->required();
+		->type_name("FILE");
 
 	usize runs {};
 	app.add_option("RUNS", runs)
@@ -38,10 +311,71 @@ int run(const int argc, const char **argv)
 		->check(CLI::PositiveNumber)
 		->default_val(10);
 
+	std::optional<f64> speed = std::nullopt;
+	app.add_option("-p,--pace", speed)
+		->description("Replay the data at the speed it was recorded at, times this factor.")
+		->type_name("SPEED")
+		->check(CLI::PositiveNumber);
+
+	std::vector<Eigen::Index> sizes {};
+	app.add_option("-s,--synthetic", sizes)
+		->description("Benchmark contact detection on synthetic heatmaps of these widths.")
+		->type_name("WIDTH")
+		->check(CLI::Range(16, 1024))
+		->excludes(data);
+
+	bool device = false;
+	app.add_flag("-d,--device", device)
+		->description("Read the data through a mock HID device, like from real hardware.");
+
+	std::optional<usize> interval = std::nullopt;
+	app.add_option("-i,--interval", interval)
+		->description("The time between two reports read from the mock device, in μs.")
+		->type_name("USEC")
+		->check(CLI::PositiveNumber);
+
+	usize fail_every = 0;
+	app.add_option("--fail-every", fail_every)
+		->description("Make every n-th read from the mock device fail.")
+		->type_name("N")
+		->check(CLI::PositiveNumber);
+
+	bool engines = false;
+	app.add_flag("-e,--engines", engines)
+		->description("Compare the cost and accuracy of the contact detection engines.");
+
 	CLI11_PARSE(app, argc, argv);
 
+	// The timings depend on which variant of the kernels is used.
+	spdlog::info("Running {} kernels", common::cpu::format_as(common::cpu::level()));
+
+	if (!sizes.empty()) {
+		run_synthetic(sizes, runs);
+		return 0;
+	}
+
+	if (path.empty()) {
+		spdlog::error("Either a data file or synthetic heatmaps are required");
+		return EXIT_FAILURE;
+	}
+
+	if (engines) {
+		if (run_engines(path, runs))
+			return EXIT_FAILURE;
+
+		return 0;
+	}
+
+	if (device) {
+		if (run_device(path, runs, speed, interval, fail_every))
+			return EXIT_FAILURE;
+
+		return 0;
+	}
+
 	// Create a performance testing application that reads from a file.
 	core::linux::FileRunner<Perf> perf {path};
+	perf.pace(speed);
 
 	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { perf.stop(); });
 	const auto _sigint = core::linux::signal<SIGINT>([&](int) { perf.stop(); });
@@ -55,6 +389,8 @@ int run(const int argc, const char **argv)
 	clock::duration min = clock::duration::max();
 	clock::duration max = clock::duration::min();
 
+	core::linux::Pacing pacing {};
+
 	bool should_stop = false;
 
 	for (usize i = 0; i < runs; i++) {
@@ -69,22 +405,34 @@ int run(const int argc, const char **argv)
 		min = std::min(min, papp.min);
 		max = std::max(max, papp.max);
 
+		pacing.count += perf.pacing().count;
+		pacing.total += perf.pacing().total;
+		pacing.max = std::max(pacing.max, perf.pacing().max);
+
 		if (should_stop)
 			break;
 
 		papp.reset();
 	}
 
-	const f64 n = casts::to<f64>(count);
-	const f64 mean = casts::to<f64>(total) / n;
-	const f64 stddev = std::sqrt(casts::to<f64>(total_of_squares) / n - mean * mean);
+	print(total, total_of_squares, count, min, max);
 
-	spdlog::info("Ran {} times", count);
-	spdlog::info("Total: {}μs", total);
-	spdlog::info("Mean: {:.2f}μs", mean);
-	spdlog::info("Standard Deviation: {:.2f}μs", stddev);
-	spdlog::info("Minimum: {:.3f}μs", chrono::duration_cast<microseconds<f64>>(min).count());
-	spdlog::info("Maximum: {:.3f}μs", chrono::duration_cast<microseconds<f64>>(max).count());
+	// The parser is not reset between runs, so this covers all of them.
+	const usize malformed = perf.application().malformed();
+
+	if (malformed > 0)
+		spdlog::warn("Skipped {} malformed reports", malformed);
+
+	if (speed.has_value()) {
+		using us = microseconds<f64>;
+
+		const f64 mean_delay = chrono::duration_cast<us>(pacing.mean()).count();
+		const f64 max_delay = chrono::duration_cast<us>(pacing.max).count();
+
+		spdlog::info("Paced {} reports at {}x speed", pacing.count, speed.value());
+		spdlog::info("Mean Scheduling Delay: {:.2f}μs", mean_delay);
+		spdlog::info("Maximum Scheduling Delay: {:.2f}μs", max_delay);
+	}
 
 	if (!should_stop)
 		return EXIT_FAILURE;
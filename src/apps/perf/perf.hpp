@@ -9,11 +9,13 @@
 #include <core/generic/application.hpp>
 #include <core/generic/config.hpp>
 #include <ipts/data.hpp>
+#include <ipts/parser.hpp>
 
 #include <gsl/gsl>
 
 #include <algorithm>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -31,18 +33,28 @@ public:
 	clock::duration min = clock::duration::max();
 	clock::duration max = clock::duration::min();
 
+	// Whether the contacts of every heatmap are stored.
+	bool record = false;
+
+	// The contacts of every heatmap, if they are recorded.
+	std::vector<std::vector<contacts::Contact<f64>>> frames {};
+
 private:
 	bool m_had_heatmap {};
 
 public:
 	Perf(const core::Config &config,
 	     const core::DeviceInfo &info,
-	     const std::optional<const ipts::Metadata> &metadata)
-		: core::Application(config, info, metadata) {};
+	     const std::optional<const ipts::Metadata> &metadata,
+	     const std::optional<std::string> &engine = std::nullopt)
+		: core::Application(with_engine(config, engine), info, metadata) {};
 
-	void on_contacts(const std::vector<contacts::Contact<f64>> & /* unused */) override
+	void on_contacts(const std::vector<contacts::Contact<f64>> &contacts) override
 	{
 		m_had_heatmap = true;
+
+		if (record)
+			frames.push_back(contacts);
 	}
 
 	void on_data(const gsl::span<u8> data) override
@@ -72,13 +84,31 @@ public:
 	}
 
 	/*!
-	 * Resets the contact finder.
+	 * How many reports were skipped because they were malformed.
+	 */
+	[[nodiscard]] usize malformed() const
+	{
+		return m_parser.count(ipts::ParseStatus::Truncated) +
+		       m_parser.count(ipts::ParseStatus::InvalidSize);
+	}
+
+	/*!
+	 * The configuration that the contacts are processed with.
+	 */
+	[[nodiscard]] const core::Config &config() const
+	{
+		return m_config;
+	}
+
+	/*!
+	 * Resets the contact finder, the heatmap filter and the statistics.
 	 *
 	 * This has to be done after every iteration to prevent
 	 * skewing the results due to finger tracking being different.
 	 */
 	void reset()
 	{
+		core::Application::reset();
 		m_finder.reset();
 
 		total = 0;
@@ -88,6 +118,23 @@ public:
 		min = clock::duration::max();
 		max = clock::duration::min();
 	}
+
+private:
+	/*!
+	 * Replaces the engine that is used for contact detection.
+	 *
+	 * @param[in] config The loaded configuration.
+	 * @param[in] engine The engine to use instead of the configured one, if set.
+	 * @return The modified configuration.
+	 */
+	[[nodiscard]] static core::Config with_engine(core::Config config,
+	                                              const std::optional<std::string> &engine)
+	{
+		if (engine.has_value())
+			config.contacts_engine = engine.value();
+
+		return config;
+	}
 };
 
 } // namespace iptsd::apps::perf
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_PERF_SYNTHETIC_HPP
+#define IPTSD_APPS_PERF_SYNTHETIC_HPP
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <contacts/config.hpp>
+#include <contacts/contact.hpp>
+#include <contacts/finder.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace iptsd::apps::perf {
+
+/*
+ * The result of running contact detection on synthetic heatmaps.
+ */
+struct SyntheticResult {
+	// The average time it took to process one heatmap.
+	microseconds<f64> mean {};
+
+	// The average number of contacts that were found per heatmap.
+	f64 contacts = 0;
+
+	// The average distance between the found contacts and the true position, in pixels.
+	f64 error = 0;
+};
+
+/*
+ * Generates heatmaps with a configurable resolution, to measure how the contact
+ * detection scales with the size of the input.
+ *
+ * The heatmaps contain a few moving fingers, whose size in pixels grows with the
+ * resolution, and random noise.
+ */
+class Synthetic {
+private:
+	struct Score {
+		// The number of found contacts.
+		usize contacts = 0;
+
+		// The summed distance between the found contacts and the closest finger.
+		f64 error = 0;
+	};
+
+public:
+	// How many fingers are placed on every heatmap.
+	static constexpr usize FINGERS = 5;
+
+	// How many different heatmaps are generated.
+	static constexpr usize FRAMES = 100;
+
+private:
+	Eigen::Index m_rows;
+	Eigen::Index m_cols;
+
+	// The generated heatmaps.
+	std::vector<Image<f64>> m_frames {};
+
+	// The position of the fingers on every heatmap.
+	std::vector<std::vector<Vector2<f64>>> m_positions {};
+
+public:
+	Synthetic(const Eigen::Index cols)
+		: m_rows {std::max<Eigen::Index>(cols * 2 / 3, 1)},
+		  m_cols {cols}
+	{
+		std::mt19937 rng {42};
+		std::normal_distribution<f64> noise {0, 0.01};
+
+		// Scale the fingers to the resolution, as if the screen size stays the same.
+		const f64 sigma = 1.2 * casts::to<f64>(m_cols) / 64;
+
+		for (usize i = 0; i < FRAMES; i++) {
+			const f64 t = casts::to<f64>(i) / FRAMES * 2 * M_PI;
+
+			std::vector<Vector2<f64>> positions {};
+			Image<f64> frame {m_rows, m_cols};
+
+			for (usize f = 0; f < FINGERS; f++) {
+				const f64 phase = casts::to<f64>(f) * 2 * M_PI / FINGERS;
+
+				const f64 x = 0.5 + 0.3 * std::cos(t + phase);
+				const f64 y = 0.5 + 0.3 * std::sin(t + phase);
+
+				positions.emplace_back(x * casts::to<f64>(m_cols - 1),
+				                       y * casts::to<f64>(m_rows - 1));
+			}
+
+			for (Eigen::Index y = 0; y < m_rows; y++) {
+				for (Eigen::Index x = 0; x < m_cols; x++) {
+					f64 value = noise(rng);
+
+					for (const Vector2<f64> &p : positions) {
+						const f64 px = casts::to<f64>(x) - p.x();
+						const f64 py = casts::to<f64>(y) - p.y();
+
+						const f64 dx = px / sigma;
+						const f64 dy = py / (sigma * 0.8);
+
+						value += 0.45 * std::exp(-(dx * dx + dy * dy) / 2);
+					}
+
+					frame(y, x) = std::clamp(value, 0.0, 1.0);
+				}
+			}
+
+			m_frames.push_back(std::move(frame));
+			m_positions.push_back(std::move(positions));
+		}
+	}
+
+	/*!
+	 * The number of pixels of the generated heatmaps.
+	 */
+	[[nodiscard]] usize pixels() const
+	{
+		return casts::to_unsigned(m_rows * m_cols);
+	}
+
+	/*!
+	 * Runs contact detection on all generated heatmaps, one after the other.
+	 *
+	 * @param[in] config The configuration of the contact finder.
+	 * @param[in] runs How many times all heatmaps are processed.
+	 * @return The timing and accuracy of the contact detection.
+	 */
+	[[nodiscard]] SyntheticResult run(const contacts::Config<f64> &config,
+	                                  const usize runs) const
+	{
+		using clock = chrono::steady_clock;
+
+		contacts::Finder<f64> finder {config};
+		std::vector<contacts::Contact<f64>> found {};
+
+		clock::duration total {};
+		Score score {};
+
+		for (usize r = 0; r < runs; r++) {
+			finder.reset();
+
+			for (usize i = 0; i < m_frames.size(); i++) {
+				const clock::time_point start = clock::now();
+				finder.find(m_frames[i], found);
+				total += clock::now() - start;
+
+				this->evaluate(found, i, score);
+			}
+		}
+
+		return this->result(total, runs, score);
+	}
+
+	/*!
+	 * Runs contact detection on all generated heatmaps at once.
+	 *
+	 * @param[in] config The configuration of the contact finder.
+	 * @param[in] runs How many times all heatmaps are processed.
+	 * @return The timing and accuracy of the contact detection.
+	 */
+	[[nodiscard]] SyntheticResult run_batch(const contacts::Config<f64> &config,
+	                                        const usize runs) const
+	{
+		using clock = chrono::steady_clock;
+
+		contacts::Finder<f64> finder {config};
+		std::vector<std::vector<contacts::Contact<f64>>> found {};
+
+		clock::duration total {};
+		Score score {};
+
+		for (usize r = 0; r < runs; r++) {
+			finder.reset();
+
+			const clock::time_point start = clock::now();
+			finder.find_batch(m_frames, found);
+			total += clock::now() - start;
+
+			for (usize i = 0; i < m_frames.size(); i++)
+				this->evaluate(found[i], i, score);
+		}
+
+		return this->result(total, runs, score);
+	}
+
+private:
+	/*!
+	 * Compares the contacts found on a heatmap to the true positions of the fingers.
+	 *
+	 * @param[in] found The contacts that were found.
+	 * @param[in] frame The index of the heatmap.
+	 * @param[in,out] score The score that is updated.
+	 */
+	void evaluate(const std::vector<contacts::Contact<f64>> &found,
+	              const usize frame,
+	              Score &score) const
+	{
+		const Vector2<f64> scale {casts::to<f64>(m_cols - 1), casts::to<f64>(m_rows - 1)};
+
+		for (const contacts::Contact<f64> &contact : found) {
+			const Vector2<f64> mean = contact.mean.cwiseProduct(scale);
+			score.error += this->distance(mean, m_positions[frame]);
+		}
+
+		score.contacts += found.size();
+	}
+
+	/*!
+	 * Calculates the averages of a benchmark.
+	 *
+	 * @param[in] total The time it took to process all heatmaps.
+	 * @param[in] runs How many times all heatmaps were processed.
+	 * @param[in] score The accumulated score of all heatmaps.
+	 * @return The timing and accuracy per heatmap.
+	 */
+	[[nodiscard]] SyntheticResult result(const chrono::steady_clock::duration total,
+	                                     const usize runs,
+	                                     const Score &score) const
+	{
+		const f64 frames = casts::to<f64>(runs * m_frames.size());
+		const f64 contacts = casts::to<f64>(score.contacts);
+
+		SyntheticResult result {};
+		result.mean = chrono::duration_cast<microseconds<f64>>(total) / frames;
+		result.contacts = contacts / frames;
+		result.error = score.contacts > 0 ? score.error / contacts : 0;
+
+		return result;
+	}
+
+	/*!
+	 * The distance from a point to the closest finger.
+	 *
+	 * @param[in] point The point to check.
+	 * @param[in] positions The positions of all fingers.
+	 * @return The distance to the closest finger, in pixels.
+	 */
+	[[nodiscard]] static f64 distance(const Vector2<f64> &point,
+	                                  const std::vector<Vector2<f64>> &positions)
+	{
+		f64 min = std::numeric_limits<f64>::infinity();
+
+		for (const Vector2<f64> &p : positions)
+			min = std::min(min, (p - point).norm());
+
+		return min;
+	}
+};
+
+} // namespace iptsd::apps::perf
+
+#endif // IPTSD_APPS_PERF_SYNTHETIC_HPP
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "prediction.hpp"
+
+#include <common/types.hpp>
+#include <core/linux/file-runner.hpp>
+#include <core/linux/signal-handler.hpp>
+
+#include <CLI/CLI.hpp>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace iptsd::apps::prediction {
+namespace {
+
+int run(const int argc, const char **argv)
+{
+	CLI::App app {"Utility for evaluating the stylus prediction on recorded data."};
+
+	std::filesystem::path path {};
+	app.add_option("DATA", path)
+		->description("A binary data file containing stylus reports.")
+		->type_name("FILE")
+		->required();
+
+	std::optional<f64> horizon {};
+	app.add_option("-H,--horizon", horizon)
+		->description("Overrides the PredictionHorizon option of the configuration.")
+		->check(CLI::PositiveNumber);
+
+	std::optional<f64> max_angle {};
+	app.add_option("--max-angle", max_angle)
+		->description("Overrides the PredictionMaxAngle option of the configuration.")
+		->check(CLI::PositiveNumber);
+
+	CLI11_PARSE(app, argc, argv);
+
+	// Create an evaluation application that reads from a file.
+	core::linux::FileRunner<Prediction> prediction {path, horizon, max_angle};
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { prediction.stop(); });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { prediction.stop(); });
+
+	const bool should_stop = prediction.run();
+
+	const Prediction &p = prediction.application();
+
+	spdlog::info("Horizon: {:.1f}ms", p.horizon);
+	spdlog::info("Evaluated: {}", p.predicted.count);
+	spdlog::info("Suppressed: {}", p.suppressed);
+
+	spdlog::info("{:<10} {:>10} {:>10} {:>10}", "", "Mean (mm)", "Max (mm)", "Pressure");
+
+	const auto print = [](const std::string &name, const Deviation &d) {
+		spdlog::info("{:<10} {:>10.3f} {:>10.3f} {:>10.4f}",
+		             name,
+		             d.position(),
+		             d.position_max,
+		             d.pressure());
+	};
+
+	print("Latest", p.latest);
+	print("Predicted", p.predicted);
+
+	if (should_stop)
+		return EXIT_FAILURE;
+
+	return 0;
+}
+
+} // namespace
+} // namespace iptsd::apps::prediction
+
+int main(const int argc, const char **argv)
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	try {
+		return iptsd::apps::prediction::run(argc, argv);
+	} catch (const std::exception &e) {
+		spdlog::error(e.what());
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_PREDICTION_PREDICTION_HPP
+#define IPTSD_APPS_PREDICTION_PREDICTION_HPP
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/generic/application.hpp>
+#include <core/generic/config.hpp>
+#include <core/generic/device.hpp>
+#include <core/generic/predictor.hpp>
+#include <ipts/data.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <utility>
+
+namespace iptsd::apps::prediction {
+
+/*
+ * Accumulates how far a guess of the stylus state was off from the observed state.
+ */
+class Deviation {
+public:
+	// The accumulated distance between guessed and observed position, in millimeters.
+	f64 position_sum = 0;
+	f64 position_max = 0;
+
+	// The accumulated difference between guessed and observed pressure.
+	f64 pressure_sum = 0;
+
+	usize count = 0;
+
+public:
+	/*!
+	 * Adds a guess to the statistics.
+	 *
+	 * @param[in] guess The guessed state of the stylus.
+	 * @param[in] observed The state of the stylus that was observed later.
+	 * @param[in] scale The physical size of the screen in millimeters.
+	 */
+	void add(const ipts::StylusData &guess,
+	         const ipts::StylusData &observed,
+	         const Vector2<f64> &scale)
+	{
+		const Vector2<f64> delta {guess.x - observed.x, guess.y - observed.y};
+		const f64 distance = delta.cwiseProduct(scale).norm();
+
+		position_sum += distance;
+		position_max = std::max(position_max, distance);
+
+		pressure_sum += std::abs(guess.pressure - observed.pressure);
+		count++;
+	}
+
+	/*!
+	 * The average distance between guessed and observed position, in millimeters.
+	 */
+	[[nodiscard]] f64 position() const
+	{
+		if (count == 0)
+			return 0;
+
+		return position_sum / casts::to<f64>(count);
+	}
+
+	/*!
+	 * The average difference between guessed and observed pressure.
+	 */
+	[[nodiscard]] f64 pressure() const
+	{
+		if (count == 0)
+			return 0;
+
+		return pressure_sum / casts::to<f64>(count);
+	}
+};
+
+/*
+ * Evaluates the stylus prediction on recorded data.
+ *
+ * Every prediction is compared against the observed state of the stylus at the time that
+ * was predicted, which is interpolated from the samples before and after it. As a baseline,
+ * the same is done for the unpredicted sample, which is what would be shown without prediction.
+ */
+class Prediction : public core::Application {
+public:
+	// The default horizon if neither the configuration nor the command line set one.
+	static constexpr f64 DEFAULT_HORIZON = 10;
+
+private:
+	struct Pending {
+		// The time that was predicted.
+		chrono::microseconds target {};
+
+		// The state of the stylus at the time of the prediction.
+		ipts::StylusData latest {};
+
+		// The predicted state, if the predictor made a prediction.
+		std::optional<ipts::StylusData> predicted = std::nullopt;
+	};
+
+	struct Sample {
+		chrono::microseconds time {};
+		ipts::StylusData data {};
+	};
+
+public:
+	// The deviation of the newest sample from the observed future state.
+	Deviation latest {};
+
+	// The deviation of the prediction from the observed future state.
+	Deviation predicted {};
+
+	// How many predictions were skipped because of a safeguard.
+	usize suppressed = 0;
+
+	// How far into the future the stylus is predicted, in milliseconds.
+	f64 horizon;
+
+private:
+	// The predictor that is being evaluated.
+	core::StylusPredictor m_evaluated;
+
+	// The predictions that can't be compared to the observed state yet.
+	std::deque<Pending> m_pending {};
+
+	// The newest sample of the current stroke.
+	std::optional<Sample> m_last = std::nullopt;
+
+public:
+	Prediction(const core::Config &config,
+	           const core::DeviceInfo &info,
+	           const std::optional<const ipts::Metadata> &metadata,
+	           const std::optional<f64> horizon_override,
+	           const std::optional<f64> max_angle_override)
+		: core::Application(without_prediction(config), info, metadata),
+		  horizon {select_horizon(config, horizon_override)},
+		  m_evaluated {with_prediction(config, horizon, max_angle_override)} {};
+
+	void on_stylus(const ipts::StylusData &data) override
+	{
+		const chrono::microseconds time = m_timeline.now();
+
+		if (!data.proximity || !data.contact) {
+			m_evaluated.reset();
+			m_pending.clear();
+			m_last = std::nullopt;
+
+			return;
+		}
+
+		const std::optional<ipts::StylusData> guess = m_evaluated.predict(data, time);
+
+		// Multiple DFT windows in one report update the same sample.
+		if (m_last.has_value() && m_last->time == time) {
+			m_last->data = data;
+
+			if (!m_pending.empty())
+				m_pending.back() = Pending {m_pending.back().target, data, guess};
+
+			return;
+		}
+
+		this->resolve(Sample {time, data});
+
+		const milliseconds<f64> h {this->horizon};
+		const auto target = time + chrono::duration_cast<chrono::microseconds>(h);
+
+		m_pending.push_back(Pending {target, data, guess});
+		m_last = Sample {time, data};
+	}
+
+private:
+	/*!
+	 * Compares all predictions for times up to the current sample to the observed state.
+	 *
+	 * @param[in] current The newest sample.
+	 */
+	void resolve(const Sample &current)
+	{
+		if (!m_last.has_value())
+			return;
+
+		const Sample &last = m_last.value();
+
+		// If there is a gap in the data, the state in between is unknown.
+		if (current.time - last.time > core::StylusPredictor::MAX_GAP) {
+			m_pending.clear();
+			return;
+		}
+
+		const Vector2<f64> scale {m_config.width * 10, m_config.height * 10};
+
+		while (!m_pending.empty() && m_pending.front().target <= current.time) {
+			const Pending &pending = m_pending.front();
+
+			const f64 span = milliseconds<f64> {current.time - last.time}.count();
+			const f64 offset = milliseconds<f64> {pending.target - last.time}.count();
+			const f64 f = std::clamp(offset / span, 0.0, 1.0);
+
+			const auto lerp = [&](const f64 a, const f64 b) { return a + (b - a) * f; };
+
+			ipts::StylusData observed = current.data;
+			observed.x = lerp(last.data.x, current.data.x);
+			observed.y = lerp(last.data.y, current.data.y);
+			observed.pressure = lerp(last.data.pressure, current.data.pressure);
+
+			latest.add(pending.latest, observed, scale);
+
+			if (pending.predicted.has_value()) {
+				predicted.add(pending.predicted.value(), observed, scale);
+			} else {
+				// Without a prediction, the newest sample is shown instead.
+				predicted.add(pending.latest, observed, scale);
+				suppressed++;
+			}
+
+			m_pending.pop_front();
+		}
+	}
+
+	/*!
+	 * Creates a configuration that disables prediction in the application itself.
+	 *
+	 * @param[in] config The loaded configuration.
+	 * @return A copy of the configuration without prediction.
+	 */
+	static core::Config without_prediction(core::Config config)
+	{
+		config.stylus_prediction_horizon = 0;
+		return config;
+	}
+
+	/*!
+	 * Determines the horizon that is evaluated.
+	 *
+	 * @param[in] config The loaded configuration.
+	 * @param[in] horizon_override The horizon from the command line.
+	 * @return The horizon in milliseconds.
+	 */
+	static f64 select_horizon(const core::Config &config,
+	                          const std::optional<f64> horizon_override)
+	{
+		const f64 horizon = horizon_override.value_or(config.stylus_prediction_horizon);
+
+		if (horizon <= 0)
+			return DEFAULT_HORIZON;
+
+		return horizon;
+	}
+
+	/*!
+	 * Creates the configuration for the predictor that is evaluated.
+	 *
+	 * @param[in] config The loaded configuration.
+	 * @param[in] horizon The horizon in milliseconds.
+	 * @param[in] max_angle_override The maximum angle from the command line.
+	 * @return A copy of the configuration with prediction enabled.
+	 */
+	static core::Config with_prediction(core::Config config,
+	                                    const f64 horizon,
+	                                    const std::optional<f64> max_angle_override)
+	{
+		config.stylus_prediction_horizon = horizon;
+
+		if (max_angle_override.has_value())
+			config.stylus_prediction_max_angle = max_angle_override.value();
+
+		return config;
+	}
+};
+
+} // namespace iptsd::apps::prediction
+
+#endif // IPTSD_APPS_PREDICTION_PREDICTION_HPP
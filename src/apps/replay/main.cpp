@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "uhid-device.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/linux/mock-device.hpp>
+#include <core/linux/signal-handler.hpp>
+#include <ipts/device.hpp>
+
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace iptsd::apps::replay {
+namespace {
+
+int run(const int argc, const char **argv)
+{
+	CLI::App app {"Utility for replaying touch reports through a virtual HID device."};
+
+	std::filesystem::path path {};
+	app.add_option("DATA", path)
+		->description("A binary data file containing touch reports.")
+		->type_name("FILE")
+		->required();
+
+	f64 speed {};
+	app.add_option("-p,--pace", speed)
+		->description("Replay the data at the speed it was recorded at, times this factor.")
+		->type_name("SPEED")
+		->check(CLI::PositiveNumber)
+		->default_val(1);
+
+	bool loop = false;
+	app.add_flag("-l,--loop", loop)->description("Replay the data until interrupted.");
+
+	CLI11_PARSE(app, argc, argv);
+
+	const auto device = std::make_shared<core::linux::MockDevice>(path);
+	device->pace(speed);
+
+	std::atomic_bool should_stop = false;
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { should_stop = true; });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { should_stop = true; });
+
+	bool done = false;
+
+	device->on_wrap = [&]() {
+		if (!loop)
+			done = true;
+	};
+
+	// Use the same name as the IPTS driver, so that the device is picked up automatically.
+	const std::string name =
+		fmt::format("IPTS {:04X}:{:04X}", device->vendor(), device->product());
+	UhidDevice uhid {device, name};
+
+	std::optional<std::filesystem::path> hidraw = std::nullopt;
+
+	// The hidraw node is created asynchronously after the device was started.
+	while (!should_stop && !hidraw.has_value()) {
+		uhid.process(10);
+
+		if (uhid.started())
+			hidraw = uhid.hidraw();
+	}
+
+	if (should_stop)
+		return EXIT_FAILURE;
+
+	spdlog::info("Created {} at {}", name, hidraw->string());
+	spdlog::info("Waiting for a process to enable multitouch mode");
+
+	using clock = chrono::steady_clock;
+	using ms = chrono::milliseconds;
+
+	usize reports = 0;
+	usize skipped = 0;
+
+	bool streaming = false;
+	const u8 multitouch = static_cast<u8>(ipts::Mode::Multitouch);
+
+	while (!should_stop && !done) {
+		try {
+			// Real devices only send touch data in multitouch mode.
+			const bool active = uhid.opened() && device->mode() == multitouch;
+
+			if (active && !streaming) {
+				spdlog::info("Replaying reports");
+
+				// Start pacing from the current report.
+				device->pace(speed);
+			}
+
+			if (!active && streaming)
+				spdlog::info("Paused replaying reports");
+
+			streaming = active;
+
+			if (!streaming) {
+				uhid.process(100);
+				continue;
+			}
+
+			/*
+			 * Recordings can contain long gaps between two reports. Requests of the
+			 * kernel have to be answered in the meantime, otherwise they time out.
+			 */
+			const clock::time_point now = clock::now();
+			const clock::time_point due = device->due().value_or(now);
+			const i64 left = chrono::duration_cast<ms>(due - now).count();
+
+			// The remaining time below one millisecond is waited for by the device.
+			if (left > 0) {
+				uhid.process(casts::to<int>(left));
+				continue;
+			}
+
+			if (uhid.forward().has_value())
+				reports++;
+			else
+				skipped++;
+		} catch (const std::exception &e) {
+			spdlog::warn(e.what());
+		}
+	}
+
+	spdlog::info("Replayed {} reports", reports);
+
+	if (skipped > 0)
+		spdlog::warn("Skipped {} reports that are too large for uhid", skipped);
+
+	if (should_stop)
+		return EXIT_FAILURE;
+
+	return 0;
+}
+
+} // namespace
+} // namespace iptsd::apps::replay
+
+int main(const int argc, const char **argv)
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	try {
+		return iptsd::apps::replay::run(argc, argv);
+	} catch (const std::exception &e) {
+		spdlog::error(e.what());
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_REPLAY_UHID_DEVICE_HPP
+#define IPTSD_APPS_REPLAY_UHID_DEVICE_HPP
+
+#include <common/casts.hpp>
+#include <common/error.hpp>
+#include <common/types.hpp>
+#include <core/linux/errors.hpp>
+#include <core/linux/syscalls.hpp>
+#include <hid/device.hpp>
+#include <hid/report.hpp>
+#include <hid/serializer.hpp>
+
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <linux/input.h>
+#include <linux/uhid.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <exception>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace syscalls = iptsd::core::linux::syscalls;
+
+namespace iptsd::apps::replay {
+
+/*
+ * Exposes a HID device to the kernel through /dev/uhid.
+ *
+ * The kernel creates a hidraw node for the virtual device, that behaves like the one of a real
+ * device: Input reports that are read from the source device are passed to the kernel, and
+ * feature reports that are requested through the hidraw node are forwarded to the source device.
+ */
+class UhidDevice {
+private:
+	// The device that provides the descriptor and all reports.
+	std::shared_ptr<hid::Device> m_source;
+
+	// The reports of the virtual device.
+	std::vector<hid::Report> m_reports {};
+
+	// A unique identifier of the virtual device, for finding its hidraw node.
+	std::string m_uniq;
+
+	// The target buffer for reading input reports from the source device.
+	std::vector<u8> m_buffer {};
+
+	// Whether the kernel has started the virtual device.
+	bool m_started = false;
+
+	// Whether the hidraw node of the virtual device is opened.
+	bool m_opened = false;
+
+	// The file descriptor of the open uhid node.
+	int m_fd;
+
+public:
+	UhidDevice(std::shared_ptr<hid::Device> source, const std::string &name)
+		: m_source {std::move(source)},
+		  m_uniq {fmt::format("iptsd-{}", getpid())},
+		  m_fd {syscalls::open("/dev/uhid", O_RDWR | O_CLOEXEC)}
+	{
+		bool created = false;
+
+		// The destructor doesn't run if the constructor throws, so the node is closed here.
+		const auto _close = gsl::finally([&]() {
+			if (!created)
+				::close(m_fd);
+		});
+
+		/*
+		 * The kernel can't receive input reports that are larger than UHID_DATA_MAX,
+		 * so the input reports are shrunk to that size. Reports that are actually
+		 * larger than that can't be replayed.
+		 */
+		for (const hid::Report &report : m_source->descriptor()) {
+			const u64 limit = (UHID_DATA_MAX - 1) * 8;
+
+			if (report.type() != hid::ReportType::Input || report.size() <= limit) {
+				m_reports.push_back(report);
+				continue;
+			}
+
+			m_reports.emplace_back(hid::ReportType::Input,
+			                       report.id(),
+			                       UHID_DATA_MAX - 1,
+			                       8,
+			                       report.usages());
+		}
+
+		const std::vector<u8> descriptor = hid::serialize(m_reports);
+
+		struct uhid_event event {};
+		event.type = UHID_CREATE2;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+		struct uhid_create2_req &create = event.u.create2;
+
+		if (descriptor.size() > sizeof(create.rd_data))
+			throw common::Error<core::linux::Error::UhidDescriptorTooLarge> {name};
+
+		const usize name_size = std::min(name.size(), sizeof(create.name) - 1);
+		const usize uniq_size = std::min(m_uniq.size(), sizeof(create.uniq) - 1);
+
+		std::copy_n(name.begin(), name_size, &create.name[0]);
+		std::copy_n(m_uniq.begin(), uniq_size, &create.uniq[0]);
+		std::copy(descriptor.begin(), descriptor.end(), &create.rd_data[0]);
+
+		create.rd_size = casts::to<u16>(descriptor.size());
+		create.bus = BUS_VIRTUAL;
+		create.vendor = m_source->vendor();
+		create.product = m_source->product();
+
+		syscalls::write(m_fd, event);
+
+		// One byte more than the kernel accepts, to detect reports that are too large.
+		m_buffer.resize(UHID_DATA_MAX + 1);
+
+		created = true;
+	}
+
+	~UhidDevice()
+	{
+		try {
+			struct uhid_event event {};
+			event.type = UHID_DESTROY;
+
+			syscalls::write(m_fd, event);
+			syscalls::close(m_fd);
+		} catch (const std::exception & /* unused */) {
+			// ignored
+		}
+	}
+
+	UhidDevice(const UhidDevice &) = delete;
+	UhidDevice &operator=(const UhidDevice &) = delete;
+
+	/*!
+	 * Whether the kernel has started the virtual device.
+	 */
+	[[nodiscard]] bool started() const
+	{
+		return m_started;
+	}
+
+	/*!
+	 * Whether the hidraw node of the virtual device is opened by any process.
+	 */
+	[[nodiscard]] bool opened() const
+	{
+		return m_opened;
+	}
+
+	/*!
+	 * Determines the hidraw node that the kernel created for the device.
+	 *
+	 * @return The path of the hidraw node (e.g. /dev/hidraw3), or nothing if there is none yet.
+	 */
+	[[nodiscard]] std::optional<std::filesystem::path> hidraw() const
+	{
+		const std::string uniq = "HID_UNIQ=" + m_uniq;
+
+		const std::filesystem::path sysfs {"/sys/class/hidraw"};
+
+		for (const auto &entry : std::filesystem::directory_iterator {sysfs}) {
+			std::ifstream uevent {entry.path() / "device" / "uevent"};
+
+			for (std::string line {}; std::getline(uevent, line);) {
+				if (line != uniq)
+					continue;
+
+				return std::filesystem::path {"/dev"} / entry.path().filename();
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	/*!
+	 * Handles the requests of the kernel.
+	 *
+	 * @param[in] timeout How long to wait for a request, in milliseconds.
+	 */
+	void process(const int timeout)
+	{
+		std::array<struct pollfd, 1> fds {pollfd {m_fd, POLLIN, 0}};
+
+		if (syscalls::poll(fds, timeout) == 0)
+			return;
+
+		struct uhid_event event {};
+		syscalls::read(m_fd, event);
+
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-union-access)
+
+		switch (event.type) {
+		case UHID_START:
+			m_started = true;
+			break;
+		case UHID_STOP:
+			m_started = false;
+			break;
+		case UHID_OPEN:
+			m_opened = true;
+			break;
+		case UHID_CLOSE:
+			m_opened = false;
+			break;
+		case UHID_GET_REPORT:
+			this->get_report(event.u.get_report);
+			break;
+		case UHID_SET_REPORT:
+			this->set_report(event.u.set_report);
+			break;
+		default:
+			break;
+		}
+
+		// NOLINTEND(cppcoreguidelines-pro-type-union-access)
+	}
+
+	/*!
+	 * Reads an input report from the source device and passes it to the kernel.
+	 *
+	 * @return The size of the report, or nothing if the report was too large to pass it on.
+	 */
+	std::optional<usize> forward()
+	{
+		const usize size = casts::to_unsigned(m_source->read(m_buffer));
+
+		if (size > UHID_DATA_MAX)
+			return std::nullopt;
+
+		struct uhid_event event {};
+		event.type = UHID_INPUT2;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+		struct uhid_input2_req &input = event.u.input2;
+
+		input.size = casts::to<u16>(size);
+		std::copy_n(m_buffer.begin(), size, &input.data[0]);
+
+		// Only write the part of the event that is used.
+		const usize length = sizeof(event.type) + sizeof(input.size) + size;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		const auto *bytes = reinterpret_cast<const u8 *>(&event);
+
+		syscalls::write(m_fd, gsl::span<const u8> {bytes, length});
+
+		return size;
+	}
+
+private:
+	/*!
+	 * Searches for a feature report of the virtual device.
+	 *
+	 * @param[in] id The ID of the report.
+	 * @return The size of the report including its ID, or nothing if there is no such report.
+	 */
+	[[nodiscard]] std::optional<usize> feature_size(const u8 id) const
+	{
+		for (const hid::Report &report : m_reports) {
+			if (report.type() != hid::ReportType::Feature || report.id() != id)
+				continue;
+
+			return casts::to<usize>(report.size() / 8) + 1;
+		}
+
+		return std::nullopt;
+	}
+
+	/*!
+	 * Answers a request of the kernel for the data of a feature report.
+	 *
+	 * @param[in] request The request of the kernel.
+	 */
+	void get_report(const struct uhid_get_report_req &request) const
+	{
+		struct uhid_event event {};
+		event.type = UHID_GET_REPORT_REPLY;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+		struct uhid_get_report_reply_req &reply = event.u.get_report_reply;
+
+		reply.id = request.id;
+		reply.err = EIO;
+
+		const std::optional<usize> size = this->feature_size(request.rnum);
+
+		if (request.rtype == UHID_FEATURE_REPORT && size.has_value() &&
+		    size.value() <= sizeof(reply.data)) {
+			const gsl::span<u8> data {&reply.data[0], size.value()};
+			data[0] = request.rnum;
+
+			try {
+				m_source->get_feature(data);
+
+				reply.err = 0;
+				reply.size = casts::to<u16>(size.value());
+			} catch (const std::exception &e) {
+				spdlog::warn(e.what());
+			}
+		}
+
+		syscalls::write(m_fd, event);
+	}
+
+	/*!
+	 * Answers a request of the kernel for changing the data of a feature report.
+	 *
+	 * @param[in] request The request of the kernel.
+	 */
+	void set_report(struct uhid_set_report_req &request) const
+	{
+		struct uhid_event event {};
+		event.type = UHID_SET_REPORT_REPLY;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-union-access)
+		struct uhid_set_report_reply_req &reply = event.u.set_report_reply;
+
+		reply.id = request.id;
+		reply.err = EIO;
+
+		const usize size = std::min(casts::to<usize>(request.size), sizeof(request.data));
+
+		if (request.rtype == UHID_FEATURE_REPORT) {
+			try {
+				m_source->set_feature(gsl::span<u8> {&request.data[0], size});
+				reply.err = 0;
+			} catch (const std::exception &e) {
+				spdlog::warn(e.what());
+			}
+		}
+
+		syscalls::write(m_fd, event);
+	}
+};
+
+} // namespace iptsd::apps::replay
+
+#endif // IPTSD_APPS_REPLAY_UHID_DEVICE_HPP
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "stability.hpp"
+
+#include <common/types.hpp>
+#include <core/linux/file-runner.hpp>
+#include <core/linux/signal-handler.hpp>
+
+#include <CLI/CLI.hpp>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+
+namespace iptsd::apps::stability {
+namespace {
+
+int run(const int argc, const char **argv)
+{
+	CLI::App app {"Utility for measuring the lag and jitter of the contact stabilizers."};
+
+	std::filesystem::path path {};
+	app.add_option("DATA", path)
+		->description("A binary data file containing touch reports.")
+		->type_name("FILE")
+		->required();
+
+	f64 speed {};
+	app.add_option("-s,--speed", speed)
+		->description("The distance in cm per frame above which a contact is moving.")
+		->check(CLI::PositiveNumber)
+		->default_val(0.02);
+
+	AdaptiveParameters parameters {};
+	app.add_option("--min-cutoff", parameters.min_cutoff)
+		->description("Overrides the AdaptiveMinCutoff option of the configuration.")
+		->check(CLI::PositiveNumber);
+	app.add_option("--position-beta", parameters.position_beta)
+		->description("Overrides the AdaptivePositionBeta option of the configuration.")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--size-beta", parameters.size_beta)
+		->description("Overrides the AdaptiveSizeBeta option of the configuration.")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--orientation-beta", parameters.orientation_beta)
+		->description("Overrides the AdaptiveOrientationBeta option of the configuration.")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--derivative-cutoff", parameters.derivative_cutoff)
+		->description("Overrides the AdaptiveDerivativeCutoff option of the configuration.")
+		->check(CLI::PositiveNumber);
+
+	CLI11_PARSE(app, argc, argv);
+
+	// Create a measurement application that reads from a file.
+	core::linux::FileRunner<Stability> stability {path, speed, parameters};
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { stability.stop(); });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { stability.stop(); });
+
+	const bool should_stop = stability.run();
+
+	spdlog::info("{:<12} {:>10} {:>12} {:>8} {:>8}",
+	             "Stabilizer",
+	             "Lag (cm)",
+	             "Jitter (cm)",
+	             "Moving",
+	             "Resting");
+
+	for (const Measurement &m : stability.application().measurements) {
+		spdlog::info("{:<12} {:>10.4f} {:>12.5f} {:>8} {:>8}",
+		             m.name,
+		             m.lag(),
+		             m.jitter(),
+		             m.lag_count,
+		             m.jitter_count);
+	}
+
+	if (should_stop)
+		return EXIT_FAILURE;
+
+	return 0;
+}
+
+} // namespace
+} // namespace iptsd::apps::stability
+
+int main(const int argc, const char **argv)
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	try {
+		return iptsd::apps::stability::run(argc, argv);
+	} catch (const std::exception &e) {
+		spdlog::error(e.what());
+		return EXIT_FAILURE;
+	}
+}
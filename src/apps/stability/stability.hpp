@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_STABILITY_STABILITY_HPP
+#define IPTSD_APPS_STABILITY_STABILITY_HPP
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+#include <contacts/config.hpp>
+#include <contacts/contact.hpp>
+#include <contacts/finder.hpp>
+#include <core/generic/application.hpp>
+#include <core/generic/config.hpp>
+#include <core/generic/device.hpp>
+#include <ipts/data.hpp>
+
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace iptsd::apps::stability {
+
+/*
+ * The unstabilized contacts of the last frames, which are used as the reference.
+ */
+class Reference {
+public:
+	/*
+	 * Over how many frames the speed of a contact is measured.
+	 * A longer window reduces the influence of noise.
+	 */
+	static constexpr usize WINDOW = 4;
+
+private:
+	contacts::Finder<f64> m_finder;
+
+	// The newest frame is at the front.
+	std::deque<std::vector<contacts::Contact<f64>>> m_frames {};
+
+public:
+	Reference(const contacts::Config<f64> &config) : m_finder {config} {};
+
+	/*!
+	 * Finds the unstabilized contacts in a new heatmap.
+	 *
+	 * @param[in] heatmap The normalized heatmap.
+	 */
+	void update(const Image<f64> &heatmap)
+	{
+		std::vector<contacts::Contact<f64>> frame {};
+
+		// Reuse the memory of the oldest frame.
+		if (m_frames.size() > WINDOW + 1) {
+			frame = std::move(m_frames.back());
+			m_frames.pop_back();
+		}
+
+		m_finder.find(heatmap, frame);
+		m_frames.push_front(std::move(frame));
+	}
+
+	/*!
+	 * The unstabilized version of a contact.
+	 *
+	 * @param[in] index The index of the contact.
+	 * @return The contact, if it exists in the current frame.
+	 */
+	[[nodiscard]] std::optional<contacts::Contact<f64>> find(const usize index) const
+	{
+		if (m_frames.empty())
+			return std::nullopt;
+
+		return contacts::Contact<f64>::find_in_frame(index, m_frames.front());
+	}
+
+	/*!
+	 * The velocity of a contact up until the last frame.
+	 *
+	 * The current frame is left out, so that the noise of the current unstabilized
+	 * position does not correlate with the direction of the movement.
+	 *
+	 * @param[in] index The index of the contact.
+	 * @return The movement of the contact per frame, if it has existed for long enough.
+	 */
+	[[nodiscard]] std::optional<Vector2<f64>> velocity(const usize index) const
+	{
+		if (m_frames.size() < WINDOW + 2)
+			return std::nullopt;
+
+		const auto &newest = m_frames[1];
+		const auto &oldest = m_frames[WINDOW + 1];
+
+		const auto to = contacts::Contact<f64>::find_in_frame(index, newest);
+		const auto from = contacts::Contact<f64>::find_in_frame(index, oldest);
+
+		if (!to.has_value() || !from.has_value())
+			return std::nullopt;
+
+		return (to->mean - from->mean) / casts::to<f64>(WINDOW);
+	}
+};
+
+/*
+ * Runs one stabilizer over the recorded data and measures how it changes the contacts.
+ */
+class Measurement {
+public:
+	// The name of the stabilizer.
+	std::string name;
+
+	// The accumulated distance that moving contacts are trailing behind the reference.
+	f64 lag_sum = 0;
+	usize lag_count = 0;
+
+	// The accumulated squared acceleration of contacts that are not moving.
+	f64 jitter_sum = 0;
+	usize jitter_count = 0;
+
+private:
+	contacts::Finder<f64> m_finder;
+
+	// The contacts of the current frame and the two frames before.
+	std::vector<contacts::Contact<f64>> m_current {};
+	std::vector<contacts::Contact<f64>> m_last {};
+	std::vector<contacts::Contact<f64>> m_before_last {};
+
+public:
+	Measurement(std::string name, const contacts::Config<f64> &config)
+		: name {std::move(name)},
+		  m_finder {config} {};
+
+	/*!
+	 * The lag of the stabilizer.
+	 *
+	 * @return How far moving contacts are trailing behind the reference
+	 * in the direction of the movement, on average in centimeters.
+	 */
+	[[nodiscard]] f64 lag() const
+	{
+		if (lag_count == 0)
+			return 0;
+
+		return lag_sum / casts::to<f64>(lag_count);
+	}
+
+	/*!
+	 * The residual jitter of the stabilizer.
+	 *
+	 * @return The root mean square of the frame to frame acceleration of contacts
+	 * that are not moving, in centimeters per frame squared.
+	 */
+	[[nodiscard]] f64 jitter() const
+	{
+		if (jitter_count == 0)
+			return 0;
+
+		return std::sqrt(jitter_sum / casts::to<f64>(jitter_count));
+	}
+
+	/*!
+	 * Processes a new heatmap.
+	 *
+	 * @param[in] heatmap The normalized heatmap.
+	 * @param[in] reference The unstabilized contacts.
+	 * @param[in] scale The physical size of the screen, for converting to centimeters.
+	 * @param[in] speed The distance in cm a contact must move per frame to count as moving.
+	 */
+	void update(const Image<f64> &heatmap,
+	            const Reference &reference,
+	            const Vector2<f64> &scale,
+	            const f64 speed)
+	{
+		std::swap(m_before_last, m_last);
+		std::swap(m_last, m_current);
+
+		m_finder.find(heatmap, m_current);
+
+		for (const contacts::Contact<f64> &contact : m_current) {
+			if (!contact.index.has_value())
+				continue;
+
+			const usize index = contact.index.value();
+
+			const auto raw = reference.find(index);
+			const auto velocity = reference.velocity(index);
+
+			if (!raw.has_value() || !velocity.has_value())
+				continue;
+
+			const Vector2<f64> v = velocity->cwiseProduct(scale);
+
+			if (v.norm() >= speed)
+				this->measure_lag(contact, raw.value(), v, scale);
+			else
+				this->measure_jitter(contact, scale);
+		}
+	}
+
+private:
+	/*!
+	 * Measures how far a moving contact is trailing behind the reference.
+	 *
+	 * @param[in] contact The stabilized contact.
+	 * @param[in] raw The unstabilized contact.
+	 * @param[in] velocity The velocity of the contact in centimeters per frame.
+	 * @param[in] scale The physical size of the screen, for converting to centimeters.
+	 */
+	void measure_lag(const contacts::Contact<f64> &contact,
+	                 const contacts::Contact<f64> &raw,
+	                 const Vector2<f64> &velocity,
+	                 const Vector2<f64> &scale)
+	{
+		const Vector2<f64> offset = (raw.mean - contact.mean).cwiseProduct(scale);
+
+		// Only count the part of the offset that is pointing along the movement.
+		lag_sum += offset.dot(velocity.normalized());
+		lag_count++;
+	}
+
+	/*!
+	 * Measures how much a contact that is not moving is jumping around.
+	 *
+	 * @param[in] contact The stabilized contact.
+	 * @param[in] scale The physical size of the screen, for converting to centimeters.
+	 */
+	void measure_jitter(const contacts::Contact<f64> &contact, const Vector2<f64> &scale)
+	{
+		const usize index = contact.index.value();
+
+		const auto last = contacts::Contact<f64>::find_in_frame(index, m_last);
+		const auto before = contacts::Contact<f64>::find_in_frame(index, m_before_last);
+
+		if (!last.has_value() || !before.has_value())
+			return;
+
+		const Vector2<f64> accel = contact.mean - 2 * last->mean + before->mean;
+
+		jitter_sum += accel.cwiseProduct(scale).squaredNorm();
+		jitter_count++;
+	}
+};
+
+/*
+ * Parameters of the adaptive stabilizer that override the ones from the configuration.
+ */
+struct AdaptiveParameters {
+	std::optional<f64> min_cutoff = std::nullopt;
+	std::optional<f64> position_beta = std::nullopt;
+	std::optional<f64> size_beta = std::nullopt;
+	std::optional<f64> orientation_beta = std::nullopt;
+	std::optional<f64> derivative_cutoff = std::nullopt;
+};
+
+/*
+ * Compares the lag and jitter of the available contact stabilizers on recorded data.
+ *
+ * The contacts found without any stabilization are used as the reference. Lag is measured as
+ * the distance that a moving contact trails behind the reference in the direction of movement.
+ * Jitter is measured as the acceleration of the stabilized position while it is not moving.
+ */
+class Stability : public core::Application {
+public:
+	// The measurements for every stabilizer.
+	std::vector<Measurement> measurements {};
+
+private:
+	// Finds the contacts without stabilization.
+	Reference m_reference;
+
+	// The distance in cm a contact must move per frame to count as moving.
+	f64 m_speed;
+
+public:
+	Stability(const core::Config &config,
+	          const core::DeviceInfo &info,
+	          const std::optional<const ipts::Metadata> &metadata,
+	          const f64 speed,
+	          const AdaptiveParameters &parameters)
+		: core::Application(config, info, metadata),
+		  m_reference {reference_config(config)},
+		  m_speed {speed}
+	{
+		contacts::Config<f64> threshold = config.contacts();
+		threshold.stability.algorithm = contacts::stability::Algorithm::THRESHOLD;
+
+		core::Config overridden = config;
+
+		if (parameters.min_cutoff.has_value())
+			overridden.contacts_adaptive_min_cutoff = parameters.min_cutoff.value();
+
+		if (parameters.position_beta.has_value()) {
+			const f64 beta = parameters.position_beta.value();
+			overridden.contacts_adaptive_position_beta = beta;
+		}
+
+		if (parameters.size_beta.has_value())
+			overridden.contacts_adaptive_size_beta = parameters.size_beta.value();
+
+		if (parameters.orientation_beta.has_value()) {
+			const f64 beta = parameters.orientation_beta.value();
+			overridden.contacts_adaptive_orientation_beta = beta;
+		}
+
+		if (parameters.derivative_cutoff.has_value()) {
+			const f64 dcutoff = parameters.derivative_cutoff.value();
+			overridden.contacts_adaptive_derivative_cutoff = dcutoff;
+		}
+
+		contacts::Config<f64> adaptive = overridden.contacts();
+		adaptive.stability.algorithm = contacts::stability::Algorithm::ADAPTIVE;
+
+		measurements.emplace_back("none", reference_config(config));
+		measurements.emplace_back("threshold", threshold);
+		measurements.emplace_back("adaptive", adaptive);
+	}
+
+	void on_contacts(const std::vector<contacts::Contact<f64>> & /* unused */) override
+	{
+		m_reference.update(m_heatmap);
+
+		const Vector2<f64> scale {m_config.width, m_config.height};
+
+		for (Measurement &measurement : measurements)
+			measurement.update(m_heatmap, m_reference, scale, m_speed);
+	}
+
+private:
+	/*!
+	 * Creates a contact finder configuration without any stabilization.
+	 *
+	 * @param[in] config The configuration of the application.
+	 * @return The configuration for the reference contact finder.
+	 */
+	static contacts::Config<f64> reference_config(const core::Config &config)
+	{
+		contacts::Config<f64> reference = config.contacts();
+
+		reference.stability.algorithm = contacts::stability::Algorithm::THRESHOLD;
+		reference.stability.size_threshold = std::nullopt;
+		reference.stability.position_threshold = std::nullopt;
+		reference.stability.orientation_threshold = std::nullopt;
+
+		return reference;
+	}
+};
+
+} // namespace iptsd::apps::stability
+
+#endif // IPTSD_APPS_STABILITY_STABILITY_HPP
@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_VISUALIZATION_AVI_WRITER_HPP
+#define IPTSD_APPS_VISUALIZATION_AVI_WRITER_HPP
+
+#include "video-writer.hpp"
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+
+namespace iptsd::apps::visualization {
+
+namespace avi {
+
+using FourCC = std::array<char, 4>;
+
+struct [[gnu::packed]] Chunk {
+	FourCC id;
+	u32 size;
+};
+static_assert(sizeof(Chunk) == 8);
+
+struct [[gnu::packed]] List {
+	FourCC id;
+	u32 size;
+	FourCC type;
+};
+static_assert(sizeof(List) == 12);
+
+struct [[gnu::packed]] MainHeader {
+	u32 us_per_frame;
+	u32 max_bytes_per_sec;
+	u32 padding_granularity;
+	u32 flags;
+	u32 total_frames;
+	u32 initial_frames;
+	u32 streams;
+	u32 suggested_buffer_size;
+	u32 width;
+	u32 height;
+	std::array<u32, 4> reserved;
+};
+static_assert(sizeof(MainHeader) == 56);
+
+struct [[gnu::packed]] StreamHeader {
+	FourCC type;
+	FourCC handler;
+	u32 flags;
+	u16 priority;
+	u16 language;
+	u32 initial_frames;
+	u32 scale;
+	u32 rate;
+	u32 start;
+	u32 length;
+	u32 suggested_buffer_size;
+	u32 quality;
+	u32 sample_size;
+	std::array<i16, 4> frame;
+};
+static_assert(sizeof(StreamHeader) == 56);
+
+struct [[gnu::packed]] BitmapInfoHeader {
+	u32 size;
+	i32 width;
+	i32 height;
+	u16 planes;
+	u16 bit_count;
+	u32 compression;
+	u32 size_image;
+	i32 x_pels_per_meter;
+	i32 y_pels_per_meter;
+	u32 clr_used;
+	u32 clr_important;
+};
+static_assert(sizeof(BitmapInfoHeader) == 40);
+
+struct [[gnu::packed]] IndexEntry {
+	FourCC id;
+	u32 flags;
+	u32 offset;
+	u32 size;
+};
+static_assert(sizeof(IndexEntry) == 16);
+
+/*
+ * The complete header of the file, up to and including the start of the frame list.
+ */
+struct [[gnu::packed]] Header {
+	List riff;
+	List hdrl;
+	Chunk avih_chunk;
+	MainHeader avih;
+	List strl;
+	Chunk strh_chunk;
+	StreamHeader strh;
+	Chunk strf_chunk;
+	BitmapInfoHeader strf;
+	List movi;
+};
+
+// The file has an index at the end.
+constexpr u32 AVIF_HASINDEX = 0x10;
+
+// Every frame can be decoded on its own.
+constexpr u32 AVIIF_KEYFRAME = 0x10;
+
+} // namespace avi
+
+/*
+ * Writes frames into an uncompressed AVI file.
+ *
+ * The header and the index can only be completed after all frames have been written,
+ * so this format requires a seekable output. Because of the 32 bit size fields of the
+ * format, files are limited to 4 GiB and frames that would exceed that are dropped.
+ */
+class AviWriter : public VideoWriter {
+private:
+	std::ostream &m_out;
+
+	// The header of the file. It is rewritten with the final sizes when the video is finished.
+	avi::Header m_header {};
+
+	// The size of the pixel data of one frame.
+	u32 m_frame_size;
+
+	// How many frames have been written.
+	u32 m_frames = 0;
+
+	// Whether a frame was dropped because the file got too big.
+	bool m_truncated = false;
+
+public:
+	AviWriter(std::ostream &out, const i32 width, const i32 height, const usize fps)
+		: m_out {out},
+		  m_frame_size {casts::to<u32>(width) * casts::to<u32>(height) * 4}
+	{
+		m_header.riff = avi::List {{'R', 'I', 'F', 'F'}, 0, {'A', 'V', 'I', ' '}};
+		m_header.hdrl = avi::List {{'L', 'I', 'S', 'T'}, 0, {'h', 'd', 'r', 'l'}};
+
+		m_header.hdrl.size = this->list_size(offsetof(avi::Header, hdrl.type));
+
+		m_header.avih_chunk = avi::Chunk {{'a', 'v', 'i', 'h'}, sizeof(avi::MainHeader)};
+		m_header.avih.us_per_frame = casts::to<u32>(1000000 / fps);
+		m_header.avih.max_bytes_per_sec = m_frame_size * casts::to<u32>(fps);
+		m_header.avih.flags = avi::AVIF_HASINDEX;
+		m_header.avih.streams = 1;
+		m_header.avih.suggested_buffer_size = m_frame_size;
+		m_header.avih.width = casts::to<u32>(width);
+		m_header.avih.height = casts::to<u32>(height);
+
+		m_header.strl = avi::List {{'L', 'I', 'S', 'T'}, 0, {'s', 't', 'r', 'l'}};
+		m_header.strl.size = this->list_size(offsetof(avi::Header, strl.type));
+
+		m_header.strh_chunk = avi::Chunk {{'s', 't', 'r', 'h'}, sizeof(avi::StreamHeader)};
+		m_header.strh.type = {'v', 'i', 'd', 's'};
+		m_header.strh.handler = {'D', 'I', 'B', ' '};
+		m_header.strh.scale = 1;
+		m_header.strh.rate = casts::to<u32>(fps);
+		m_header.strh.suggested_buffer_size = m_frame_size;
+		m_header.strh.quality = std::numeric_limits<u32>::max();
+		m_header.strh.frame = {0, 0, casts::to<i16>(width), casts::to<i16>(height)};
+
+		m_header.strf_chunk =
+			avi::Chunk {{'s', 't', 'r', 'f'}, sizeof(avi::BitmapInfoHeader)};
+		m_header.strf.size = sizeof(avi::BitmapInfoHeader);
+		m_header.strf.width = width;
+		m_header.strf.height = height;
+		m_header.strf.planes = 1;
+		m_header.strf.bit_count = 32;
+		m_header.strf.size_image = m_frame_size;
+
+		m_header.movi = avi::List {{'L', 'I', 'S', 'T'}, 0, {'m', 'o', 'v', 'i'}};
+
+		this->write_header();
+	}
+
+	void write(const gsl::span<const u32> frame) override
+	{
+		if (m_truncated)
+			return;
+
+		const u64 frames = m_frames + 1;
+
+		const u64 frame_size = sizeof(avi::Chunk) + m_frame_size;
+		const u64 index_size = sizeof(avi::Chunk) + frames * sizeof(avi::IndexEntry);
+		const u64 file_size = sizeof(avi::Header) + frames * frame_size + index_size;
+
+		if (file_size > std::numeric_limits<u32>::max()) {
+			spdlog::warn("AVI file size limit reached, dropping all further frames");
+
+			m_truncated = true;
+			return;
+		}
+
+		const avi::Chunk chunk {{'0', '0', 'd', 'b'}, m_frame_size};
+		this->write_struct(chunk);
+
+		const usize stride = m_header.avih.width;
+		const usize height = m_header.avih.height;
+
+		// Uncompressed bitmaps are stored bottom-up.
+		for (usize y = height; y > 0; y--) {
+			const gsl::span<const u32> row = frame.subspan((y - 1) * stride, stride);
+
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			m_out.write(reinterpret_cast<const char *>(row.data()),
+			            casts::to<std::streamsize>(row.size_bytes()));
+		}
+
+		m_frames++;
+	}
+
+	void finish() override
+	{
+		const usize frame_size = sizeof(avi::Chunk) + m_frame_size;
+
+		// Write the index.
+		const usize index_size = m_frames * sizeof(avi::IndexEntry);
+		this->write_struct(avi::Chunk {{'i', 'd', 'x', '1'}, casts::to<u32>(index_size)});
+
+		for (u32 i = 0; i < m_frames; i++) {
+			avi::IndexEntry entry {};
+
+			entry.id = {'0', '0', 'd', 'b'};
+			entry.flags = avi::AVIIF_KEYFRAME;
+			entry.size = m_frame_size;
+
+			// Offsets are relative to the type field of the movi list.
+			entry.offset = casts::to<u32>(sizeof(avi::FourCC) + i * frame_size);
+
+			this->write_struct(entry);
+		}
+
+		const usize movi_size = sizeof(avi::FourCC) + m_frames * frame_size;
+		const usize file_size = sizeof(avi::Header) + m_frames * frame_size +
+		                        sizeof(avi::Chunk) + index_size;
+
+		// Fill in the final sizes.
+		m_header.riff.size = casts::to<u32>(file_size - sizeof(avi::Chunk));
+		m_header.movi.size = casts::to<u32>(movi_size);
+		m_header.avih.total_frames = m_frames;
+		m_header.strh.length = m_frames;
+
+		m_out.seekp(0);
+		this->write_header();
+		m_out.flush();
+	}
+
+private:
+	template <class T>
+	void write_struct(const T &value)
+	{
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		m_out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	/*!
+	 * Calculates the size of a list in the header, that ends where the movi list starts.
+	 *
+	 * The size of a list includes its type, but not its id and size fields.
+	 *
+	 * @param[in] type The offset of the type field of the list.
+	 * @return The size of the list.
+	 */
+	static u32 list_size(const usize type)
+	{
+		return casts::to<u32>(offsetof(avi::Header, movi) - type);
+	}
+
+	void write_header()
+	{
+		this->write_struct(m_header);
+	}
+};
+
+} // namespace iptsd::apps::visualization
+
+#endif // IPTSD_APPS_VISUALIZATION_AVI_WRITER_HPP
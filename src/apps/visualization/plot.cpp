@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "visualize-png.hpp"
+#include "visualize-video.hpp"
 
 #include <common/types.hpp>
 #include <core/linux/file-runner.hpp>
@@ -8,6 +9,7 @@
 
 #include <CLI/CLI.hpp>
 #include <gsl/gsl>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
 #include <csignal>
@@ -19,9 +21,24 @@
 namespace iptsd::apps::visualization::plot {
 namespace {
 
+template <class T, class... Args>
+int render(const std::filesystem::path &path, Args... args)
+{
+	// Create a plotting application that reads from a file.
+	core::linux::FileRunner<T> visualize {path, args...};
+
+	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { visualize.stop(); });
+	const auto _sigint = core::linux::signal<SIGINT>([&](int) { visualize.stop(); });
+
+	if (!visualize.run())
+		return EXIT_FAILURE;
+
+	return 0;
+}
+
 int run(const int argc, const char **argv)
 {
-	CLI::App app {"Utility for rendering captured touchscreen inputs to PNG frames."};
+	CLI::App app {"Utility for rendering captured touchscreen inputs to PNG frames or videos."};
 
 	std::filesystem::path path {};
 	app.add_option("DATA", path)
@@ -31,22 +48,44 @@ int run(const int argc, const char **argv)
 
 	std::filesystem::path output {};
 	app.add_option("OUTPUT", output)
-		->description("The directory where the rendered frames are saved.")
-		->type_name("DIR")
+		->description("The directory where the rendered frames are saved, or the video "
+		              "file. Y4M videos can be written to stdout by passing \"-\".")
+		->type_name("PATH")
 		->required();
 
+	std::string format {};
+	app.add_option("-f,--format", format)
+		->description("The output format. PNG writes one file per report, "
+		              "Y4M and AVI write a single uncompressed video.")
+		->check(CLI::IsMember({"png", "y4m", "avi"}))
+		->default_val("png");
+
+	usize fps {};
+	app.add_option("--fps", fps)
+		->description("The frame rate of videos. Frames are timed using report timestamps.")
+		->check(CLI::PositiveNumber)
+		->default_val(60);
+
 	CLI11_PARSE(app, argc, argv);
 
-	// Create a plotting application that reads from a file.
-	core::linux::FileRunner<VisualizePNG> visualize {path, output};
+	if (output == "-") {
+		if (format != "y4m") {
+			spdlog::error("Only Y4M videos can be written to stdout");
+			return EXIT_FAILURE;
+		}
 
-	const auto _sigterm = core::linux::signal<SIGTERM>([&](int) { visualize.stop(); });
-	const auto _sigint = core::linux::signal<SIGINT>([&](int) { visualize.stop(); });
+		// Keep stdout free for the video data.
+		spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
+		spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+	}
 
-	if (!visualize.run())
-		return EXIT_FAILURE;
+	if (format == "y4m")
+		return render<VisualizeVideo>(path, output, VideoFormat::Y4M, fps);
 
-	return 0;
+	if (format == "avi")
+		return render<VisualizeVideo>(path, output, VideoFormat::AVI, fps);
+
+	return render<VisualizePNG>(path, output);
 }
 
 } // namespace
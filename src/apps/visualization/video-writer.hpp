@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_VISUALIZATION_VIDEO_WRITER_HPP
+#define IPTSD_APPS_VISUALIZATION_VIDEO_WRITER_HPP
+
+#include <common/types.hpp>
+
+#include <gsl/gsl>
+
+namespace iptsd::apps::visualization {
+
+/*
+ * Writes a stream of uncompressed frames into a video container.
+ */
+class VideoWriter {
+public:
+	virtual ~VideoWriter() = default;
+
+	/*!
+	 * Appends a frame to the video.
+	 *
+	 * @param[in] frame The pixels of the frame in native endian ARGB, row by row.
+	 */
+	virtual void write(gsl::span<const u32> frame) = 0;
+
+	/*!
+	 * Finishes writing the video, after all frames have been written.
+	 */
+	virtual void finish() {};
+};
+
+} // namespace iptsd::apps::visualization
+
+#endif // IPTSD_APPS_VISUALIZATION_VIDEO_WRITER_HPP
@@ -25,6 +25,9 @@ private:
 	std::filesystem::path m_output;
 	Cairo::RefPtr<Cairo::ImageSurface> m_tex {};
 
+	// The state that is drawn to the texture.
+	Snapshot m_snapshot {};
+
 	usize m_counter = 0;
 
 public:
@@ -37,20 +40,7 @@ public:
 
 	void on_start() override
 	{
-		const f64 aspect = m_config.width / m_config.height;
-
-		// Determine output resolution.
-		const f64 y = 1000;
-		const f64 x = y * aspect;
-
-		m_size.x() = casts::to<i32>(std::round(x));
-		m_size.y() = casts::to<i32>(std::round(y));
-
-		// Create a texture for drawing.
-		m_tex = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_size.x(), m_size.y());
-
-		// Create context for issuing draw commands.
-		m_cairo = Cairo::Context::create(m_tex);
+		m_tex = this->create_texture(1000);
 
 		std::filesystem::create_directories(m_output);
 	}
@@ -59,7 +49,8 @@ public:
 	{
 		Visualize::on_data(data);
 
-		this->draw();
+		this->snapshot(m_snapshot);
+		this->draw(m_snapshot);
 
 		// Save the texture to a png file
 		m_tex->write_to_png(m_output / fmt::format("{:05}.png", m_counter++));
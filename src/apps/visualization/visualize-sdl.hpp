@@ -7,6 +7,7 @@
 
 #include <common/casts.hpp>
 #include <common/chrono.hpp>
+#include <common/triple-buffer.hpp>
 #include <common/types.hpp>
 #include <core/generic/config.hpp>
 #include <core/generic/device.hpp>
@@ -16,15 +17,27 @@
 #include <cairomm/cairomm.h>
 #include <gsl/gsl>
 
+#include <atomic>
 #include <cstring>
 #include <optional>
+#include <thread>
 
 namespace iptsd::apps::visualization {
 
+/*
+ * Draws the touchscreen inputs to an SDL window.
+ *
+ * Drawing happens on a separate thread, so that rendering doesn't delay the processing
+ * of incoming data. The processing thread hands snapshots of its state to the render
+ * thread, which only picks up the newest one whenever it draws a frame.
+ */
 class VisualizeSDL : public Visualize {
 private:
 	using clock = std::chrono::steady_clock;
 
+	// How many times per second the screen is redrawn.
+	static constexpr usize FPS = 60;
+
 private:
 	SDL_Window *m_window = nullptr;
 	SDL_Renderer *m_renderer = nullptr;
@@ -32,19 +45,68 @@ private:
 	SDL_Texture *m_rtex = nullptr;
 	Cairo::RefPtr<Cairo::ImageSurface> m_tex {};
 
-	clock::time_point m_last_draw {};
+	// Passes the state of the application to the render thread.
+	common::TripleBuffer<Snapshot> m_snapshots {};
+
+	// The thread that is drawing the window.
+	std::thread m_thread {};
+
+	// Whether the render thread should keep running.
+	std::atomic_bool m_running = false;
 
 public:
 	VisualizeSDL(const core::Config &config,
 	             const core::DeviceInfo &info,
 	             const std::optional<const ipts::Metadata> &metadata)
-		: Visualize(config, info, metadata)
+		: Visualize(config, info, metadata) {};
+
+	~VisualizeSDL() override
 	{
-		SDL_Init(SDL_INIT_VIDEO);
+		this->stop_rendering();
 	}
 
 	void on_start() override
 	{
+		m_running = true;
+		m_thread = std::thread {[&]() { this->render(); }};
+	}
+
+	void on_data(const gsl::span<u8> data) override
+	{
+		Visualize::on_data(data);
+
+		// Hand the new state off to the render thread.
+		this->snapshot(m_snapshots.back());
+		m_snapshots.publish();
+	}
+
+	void on_stop() override
+	{
+		this->stop_rendering();
+	}
+
+private:
+	/*!
+	 * Signals the render thread to exit and waits for it.
+	 */
+	void stop_rendering()
+	{
+		m_running = false;
+
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	/*!
+	 * The main loop of the render thread.
+	 *
+	 * All SDL calls happen on this thread, since SDL requires the window to be
+	 * drawn and its events to be handled by the thread that has created it.
+	 */
+	void render()
+	{
+		SDL_Init(SDL_INIT_VIDEO);
+
 		// Create an SDL window
 		constexpr u32 flags = SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_ALLOW_HIGHDPI;
 		SDL_CreateWindowAndRenderer(0, 0, flags, &m_window, &m_renderer);
@@ -64,45 +126,40 @@ public:
 
 		// Create context for issuing draw commands.
 		m_cairo = Cairo::Context::create(m_tex);
-	}
-
-	void on_data(const gsl::span<u8> data) override
-	{
-		Visualize::on_data(data);
 
-		// Handle window events, such as the X11_NET_WM_PING
-		// event that is used to detect stuck programs.
-		SDL_PumpEvents();
+		clock::time_point last = clock::now();
 
-		constexpr usize FPS = 60;
+		while (m_running) {
+			// Handle window events, such as the X11_NET_WM_PING
+			// event that is used to detect stuck programs.
+			SDL_PumpEvents();
 
-		// Limit how many times per seconds the screen is redrawn.
-		const clock::time_point now = clock::now();
-		const clock::time_point next = m_last_draw + (1000ms / FPS);
+			// Limit how many times per seconds the screen is redrawn.
+			std::this_thread::sleep_until(last + (1000ms / FPS));
+			last = clock::now();
 
-		if (now < next)
-			return;
+			// Only redraw if there is new data.
+			if (!m_snapshots.update())
+				continue;
 
-		this->draw();
+			this->draw(m_snapshots.front());
 
-		void *pixels = nullptr;
-		int pitch = 0;
+			void *pixels = nullptr;
+			int pitch = 0;
 
-		// Copy drawtex to rendertex
-		SDL_LockTexture(m_rtex, nullptr, &pixels, &pitch);
-		std::memcpy(pixels, m_tex->get_data(), casts::to_unsigned(m_size.prod() * 4L));
-		SDL_UnlockTexture(m_rtex);
+			const usize size = casts::to_unsigned(m_size.prod() * 4L);
 
-		// Display rendertex
-		SDL_RenderClear(m_renderer);
-		SDL_RenderCopy(m_renderer, m_rtex, nullptr, nullptr);
-		SDL_RenderPresent(m_renderer);
+			// Copy drawtex to rendertex
+			SDL_LockTexture(m_rtex, nullptr, &pixels, &pitch);
+			std::memcpy(pixels, m_tex->get_data(), size);
+			SDL_UnlockTexture(m_rtex);
 
-		m_last_draw = now;
-	}
+			// Display rendertex
+			SDL_RenderClear(m_renderer);
+			SDL_RenderCopy(m_renderer, m_rtex, nullptr, nullptr);
+			SDL_RenderPresent(m_renderer);
+		}
 
-	void on_stop() override
-	{
 		SDL_DestroyTexture(m_rtex);
 		SDL_DestroyRenderer(m_renderer);
 		SDL_DestroyWindow(m_window);
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_VISUALIZATION_VISUALIZE_VIDEO_HPP
+#define IPTSD_APPS_VISUALIZATION_VISUALIZE_VIDEO_HPP
+
+#include "avi-writer.hpp"
+#include "video-writer.hpp"
+#include "visualize.hpp"
+#include "y4m-writer.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <core/generic/config.hpp>
+#include <core/generic/device.hpp>
+#include <ipts/data.hpp>
+
+#include <cairomm/cairomm.h>
+#include <gsl/gsl>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace iptsd::apps::visualization {
+
+enum class VideoFormat : u8 {
+	Y4M,
+	AVI,
+};
+
+/*
+ * Renders the captured inputs into a single video stream with a constant frame rate.
+ *
+ * The timing of the frames is derived from the timestamps of the reports, so the video
+ * plays back at the speed the data was captured with. If multiple reports fall into the
+ * same frame only the last state is shown, if no report falls into a frame the previous
+ * one is repeated.
+ */
+class VisualizeVideo : public Visualize {
+private:
+	// The output file. If this is "-", the video is written to stdout.
+	std::filesystem::path m_output;
+
+	VideoFormat m_format;
+
+	// The frame rate of the video.
+	usize m_fps;
+
+	std::ofstream m_file {};
+	std::unique_ptr<VideoWriter> m_writer {};
+
+	Cairo::RefPtr<Cairo::ImageSurface> m_tex {};
+
+	// The state that is drawn to the texture.
+	Snapshot m_snapshot {};
+
+	// How many frames have been written.
+	usize m_frames = 0;
+
+	// Whether the state has changed since the texture was last drawn.
+	bool m_dirty = true;
+
+public:
+	VisualizeVideo(const core::Config &config,
+	               const core::DeviceInfo &info,
+	               const std::optional<const ipts::Metadata> &metadata,
+	               std::filesystem::path output,
+	               const VideoFormat format,
+	               const usize fps)
+		: Visualize(config, info, metadata),
+		  m_output {std::move(output)},
+		  m_format {format},
+		  m_fps {fps} {};
+
+	void on_start() override
+	{
+		// Frames are stored uncompressed, so don't make them bigger than necessary.
+		m_tex = this->create_texture(720);
+
+		std::ostream *out = &std::cout;
+
+		if (m_output != "-") {
+			m_file.exceptions(std::ios::badbit | std::ios::failbit);
+			m_file.open(m_output, std::ios::out | std::ios::binary);
+
+			out = &m_file;
+		}
+
+		switch (m_format) {
+		case VideoFormat::Y4M:
+			m_writer = std::make_unique<Y4MWriter>(*out, m_size.x(), m_size.y(), m_fps);
+			break;
+		case VideoFormat::AVI:
+			m_writer = std::make_unique<AviWriter>(*out, m_size.x(), m_size.y(), m_fps);
+			break;
+		}
+
+		m_timeline.reset();
+		m_frames = 0;
+		m_dirty = true;
+	}
+
+	void on_data(const gsl::span<u8> data) override
+	{
+		const chrono::microseconds time = m_timeline.now();
+		const usize frame = casts::to_unsigned(time.count()) * m_fps / 1000000;
+
+		// Write all frames that ended before this report arrived.
+		while (m_frames < frame)
+			this->write_frame();
+
+		Visualize::on_data(data);
+		m_dirty = true;
+	}
+
+	void on_stop() override
+	{
+		if (!m_writer)
+			return;
+
+		// Write the frame that contains the last report.
+		this->write_frame();
+
+		m_writer->finish();
+		m_writer.reset();
+
+		if (m_file.is_open())
+			m_file.close();
+	}
+
+private:
+	/*!
+	 * Writes the current state as the next frame of the video.
+	 *
+	 * The texture is only redrawn if the state has changed since the last frame.
+	 */
+	void write_frame()
+	{
+		if (m_dirty) {
+			this->snapshot(m_snapshot);
+			this->draw(m_snapshot);
+
+			m_tex->flush();
+			m_dirty = false;
+		}
+
+		const usize pixels = casts::to_unsigned(m_size.prod());
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		const auto *data = reinterpret_cast<const u32 *>(m_tex->get_data());
+
+		m_writer->write(gsl::span<const u32> {data, pixels});
+		m_frames++;
+	}
+};
+
+} // namespace iptsd::apps::visualization
+
+#endif // IPTSD_APPS_VISUALIZATION_VISUALIZE_VIDEO_HPP
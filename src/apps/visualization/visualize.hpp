@@ -24,6 +24,22 @@
 
 namespace iptsd::apps::visualization {
 
+/*
+ * A copy of everything that is needed for drawing a frame.
+ *
+ * This allows the drawing code to run independently from the processing of new data.
+ */
+struct Snapshot {
+	// The normalized heatmap.
+	Image<f64> heatmap {};
+
+	// The contacts that were found in the heatmap.
+	std::vector<contacts::Contact<f64>> contacts {};
+
+	// The last known states of the stylus.
+	std::deque<ipts::StylusData> history {};
+};
+
 class Visualize : public core::Application {
 private:
 	Image<u32> m_argb {};
@@ -44,30 +60,30 @@ public:
 	          const std::optional<const ipts::Metadata> &metadata)
 		: core::Application(config, info, metadata) {};
 
-	void on_contacts(const std::vector<contacts::Contact<f64>> & /* unused */) override
+	/*!
+	 * Creates a texture with the aspect ratio of the screen and prepares it for drawing.
+	 *
+	 * @param[in] height The height of the texture in pixels.
+	 * @return The texture that is drawn to.
+	 */
+	Cairo::RefPtr<Cairo::ImageSurface> create_texture(const f64 height)
 	{
-		const Eigen::Index cols = m_heatmap.cols();
-		const Eigen::Index rows = m_heatmap.rows();
+		const f64 aspect = m_config.width / m_config.height;
 
-		if (m_argb.rows() != rows || m_argb.cols() != cols)
-			m_argb.conservativeResize(rows, cols);
+		// Determine output resolution.
+		const f64 x = height * aspect;
 
-		// Convert floating point values of range [0, 1] to greyscale ARGB.
-		for (Eigen::Index y = 0; y < rows; y++) {
-			for (Eigen::Index x = 0; x < cols; x++) {
-				const f64 value = m_heatmap(y, x);
+		m_size.x() = casts::to<i32>(std::round(x));
+		m_size.y() = casts::to<i32>(std::round(height));
 
-				constexpr u8 max = std::numeric_limits<u8>::max();
-				const u8 v = casts::to<u8>(std::round(value * max));
+		// Create a texture for drawing.
+		auto texture =
+			Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_size.x(), m_size.y());
 
-				constexpr u32 a = max;
-				const u32 r = v;
-				const u32 g = v;
-				const u32 b = v;
+		// Create context for issuing draw commands.
+		m_cairo = Cairo::Context::create(texture);
 
-				m_argb(y, x) = (a << 24) + (r << 16) + (g << 8) + b;
-			}
-		}
+		return texture;
 	}
 
 	void on_stylus(const ipts::StylusData &data) override
@@ -85,63 +101,87 @@ public:
 		m_history.pop_front();
 	}
 
-	void draw()
+	/*!
+	 * Copies the current state of the application into a snapshot.
+	 *
+	 * The snapshot is reused, so that its memory doesn't have to be reallocated.
+	 *
+	 * @param[out] snapshot The snapshot to fill.
+	 */
+	void snapshot(Snapshot &snapshot) const
+	{
+		snapshot.heatmap = m_heatmap;
+		snapshot.contacts = m_contacts;
+		snapshot.history = m_history;
+	}
+
+	void draw(const Snapshot &snapshot)
 	{
 		// Draw the raw heatmap
-		this->draw_heatmap();
+		this->draw_heatmap(snapshot.heatmap);
 
 		// Draw the contacts
-		this->draw_contacts();
+		this->draw_contacts(snapshot.contacts);
 
 		// Draw the position of the stylus
-		this->draw_stylus();
+		this->draw_stylus(snapshot.history);
 
 		// Draw a line through the last 50 positions of the stylus
-		this->draw_stylus_stroke();
+		this->draw_stylus_stroke(snapshot.history);
 	}
 
-	void draw_heatmap()
+	void draw_heatmap(const Image<f64> &heatmap)
 	{
-		if (m_argb.size() == 0) {
+		if (heatmap.size() == 0) {
 			m_cairo->set_source_rgb(0, 0, 0);
 			m_cairo->paint();
 			return;
 		}
 
-		const i32 cols = casts::to<i32>(m_argb.cols());
-		const i32 rows = casts::to<i32>(m_argb.rows());
+		const Eigen::Index cols = heatmap.cols();
+		const Eigen::Index rows = heatmap.rows();
+
+		if (m_argb.rows() != rows || m_argb.cols() != cols)
+			m_argb.conservativeResize(rows, cols);
+
+		// Convert floating point values of range [0, 1] to greyscale ARGB.
+		for (Eigen::Index y = 0; y < rows; y++) {
+			for (Eigen::Index x = 0; x < cols; x++) {
+				const f64 value = heatmap(y, x);
+
+				constexpr u8 max = std::numeric_limits<u8>::max();
+				const u8 v = casts::to<u8>(std::round(value * max));
+
+				constexpr u32 a = max;
+				const u32 r = v;
+				const u32 g = v;
+				const u32 b = v;
+
+				m_argb(y, x) = (a << 24) + (r << 16) + (g << 8) + b;
+			}
+		}
+
+		const i32 width = casts::to<i32>(cols);
+		const i32 height = casts::to<i32>(rows);
 
 		constexpr auto format = Cairo::FORMAT_ARGB32;
-		const auto stride = Cairo::ImageSurface::format_stride_for_width(format, cols);
+		const auto stride = Cairo::ImageSurface::format_stride_for_width(format, width);
 
 		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
 		auto *data = reinterpret_cast<u8 *>(m_argb.data());
 
 		// Create Cairo surface based on data buffer.
 		const Cairo::RefPtr<Cairo::ImageSurface> source =
-			Cairo::ImageSurface::create(data, format, cols, rows, stride);
+			Cairo::ImageSurface::create(data, format, width, height, stride);
 
 		const f64 wx = casts::to<f64>(m_size.x());
 		const f64 wy = casts::to<f64>(m_size.y());
 
-		f64 sx = casts::to<f64>(cols) / wx;
-		f64 sy = casts::to<f64>(rows) / wy;
-
-		f64 tx = 0;
-		f64 ty = 0;
-
-		if (m_config.invert_x) {
-			sx = -sx;
-			tx = cols;
-		}
-
-		if (m_config.invert_y) {
-			sy = -sy;
-			ty = rows;
-		}
+		const f64 sx = casts::to<f64>(cols) / wx;
+		const f64 sy = casts::to<f64>(rows) / wy;
 
+		// The heatmap has already been mirrored by the application
 		Cairo::Matrix matrix = Cairo::identity_matrix();
-		matrix.translate(tx, ty);
 		matrix.scale(sx, sy);
 
 		// Upscale surface to window dimensions
@@ -155,7 +195,7 @@ public:
 		m_cairo->fill();
 	}
 
-	void draw_contacts() const
+	void draw_contacts(const std::vector<contacts::Contact<f64>> &contacts) const
 	{
 		const f64 diag = m_size.cast<f64>().hypotNorm();
 
@@ -165,7 +205,7 @@ public:
 		                          Cairo::FONT_WEIGHT_NORMAL);
 		m_cairo->set_font_size(24.0);
 
-		for (const auto &contact : m_contacts) {
+		for (const auto &contact : contacts) {
 			/*
 			 * Red: Invalid
 			 * Yellow: Unstable
@@ -211,12 +251,12 @@ public:
 		}
 	}
 
-	void draw_stylus()
+	void draw_stylus(const std::deque<ipts::StylusData> &history) const
 	{
-		if (m_history.empty())
+		if (history.empty())
 			return;
 
-		const ipts::StylusData &stylus = m_history.back();
+		const ipts::StylusData &stylus = history.back();
 
 		if (!stylus.proximity)
 			return;
@@ -283,14 +323,14 @@ public:
 		m_cairo->stroke();
 	}
 
-	void draw_stylus_stroke()
+	void draw_stylus_stroke(const std::deque<ipts::StylusData> &history) const
 	{
-		if (m_history.empty())
+		if (history.empty())
 			return;
 
-		for (usize i = 0; i < m_history.size() - 1; i++) {
-			const ipts::StylusData &from = m_history[i];
-			const ipts::StylusData &to = m_history[i + 1];
+		for (usize i = 0; i < history.size() - 1; i++) {
+			const ipts::StylusData &from = history[i];
+			const ipts::StylusData &to = history[i + 1];
 
 			if (!from.proximity || !to.proximity)
 				continue;
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_APPS_VISUALIZATION_Y4M_WRITER_HPP
+#define IPTSD_APPS_VISUALIZATION_Y4M_WRITER_HPP
+
+#include "video-writer.hpp"
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <fmt/format.h>
+#include <gsl/gsl>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace iptsd::apps::visualization {
+
+/*
+ * Writes frames into a YUV4MPEG2 stream.
+ *
+ * The format is a simple header followed by raw YCbCr planes for every frame. It doesn't
+ * require seeking, so it can be piped directly into another program (e.g. ffmpeg or mpv).
+ */
+class Y4MWriter : public VideoWriter {
+private:
+	std::ostream &m_out;
+
+	// The size of one plane.
+	usize m_pixels;
+
+	// Storage for converting a frame to YCbCr.
+	std::vector<u8> m_planes {};
+
+public:
+	Y4MWriter(std::ostream &out, const i32 width, const i32 height, const usize fps)
+		: m_out {out},
+		  m_pixels {casts::to<usize>(width) * casts::to<usize>(height)},
+		  m_planes(m_pixels * 3)
+	{
+		// Full resolution chroma, because the drawn lines are only one pixel wide.
+		m_out << fmt::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", width, height, fps);
+	}
+
+	void write(const gsl::span<const u32> frame) override
+	{
+		const gsl::span<u8> planes {m_planes};
+
+		const gsl::span<u8> py = planes.subspan(0, m_pixels);
+		const gsl::span<u8> pu = planes.subspan(m_pixels, m_pixels);
+		const gsl::span<u8> pv = planes.subspan(m_pixels * 2, m_pixels);
+
+		// Convert to YCbCr using integer BT.601 coefficients (limited range).
+		for (usize i = 0; i < m_pixels; i++) {
+			const i32 r = casts::to<i32>((frame[i] >> 16) & 0xFF);
+			const i32 g = casts::to<i32>((frame[i] >> 8) & 0xFF);
+			const i32 b = casts::to<i32>(frame[i] & 0xFF);
+
+			py[i] = casts::to<u8>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			pu[i] = casts::to<u8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			pv[i] = casts::to<u8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+
+		m_out << "FRAME\n";
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		m_out.write(reinterpret_cast<const char *>(m_planes.data()),
+		            casts::to<std::streamsize>(m_planes.size()));
+	}
+
+	void finish() override
+	{
+		m_out.flush();
+	}
+};
+
+} // namespace iptsd::apps::visualization
+
+#endif // IPTSD_APPS_VISUALIZATION_Y4M_WRITER_HPP
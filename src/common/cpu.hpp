@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_COMMON_CPU_HPP
+#define IPTSD_COMMON_CPU_HPP
+
+#include "types.hpp"
+
+#include <string_view>
+
+/*
+ * Multiple variants of a function can only be compiled with GCC and clang on x86-64.
+ * Everywhere else, the code is compiled once for the target of the build.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define IPTSD_CPU_DISPATCH 1
+#else
+#define IPTSD_CPU_DISPATCH 0
+#endif
+
+namespace iptsd::common::cpu {
+
+/*
+ * The instruction sets that the hot kernels are compiled for.
+ */
+enum class Level : u8 {
+	// Whatever the rest of the binary is compiled for. On x86-64 this is SSE2.
+	Baseline,
+
+	// AVX2 and FMA (x86-64-v3).
+	AVX2,
+
+	/*
+	 * AVX-512 F, VL, BW and DQ (x86-64-v4).
+	 *
+	 * The vectors of common/simd.hpp stay 256 bits wide. The hand-written kernels only use
+	 * the AVX-512VL encodings of 256 bit instructions, never 512 bit vectors.
+	 */
+	AVX512,
+};
+
+[[nodiscard]] inline std::string_view format_as(const Level level)
+{
+	switch (level) {
+	case Level::Baseline:
+		return "Baseline";
+	case Level::AVX2:
+		return "AVX2";
+	case Level::AVX512:
+		return "AVX-512";
+	default:
+		return "<Unknown>";
+	}
+}
+
+namespace impl {
+
+/*!
+ * Queries the instruction sets supported by the CPU.
+ *
+ * @return The best variant of the kernels that can run on the CPU.
+ */
+inline Level detect()
+{
+#if IPTSD_CPU_DISPATCH
+	__builtin_cpu_init();
+
+	const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+	const bool avx512 = avx2 && __builtin_cpu_supports("avx512f") &&
+	                    __builtin_cpu_supports("avx512vl") &&
+	                    __builtin_cpu_supports("avx512bw") &&
+	                    __builtin_cpu_supports("avx512dq");
+
+	if (avx512)
+		return Level::AVX512;
+
+	if (avx2)
+		return Level::AVX2;
+#endif
+
+	return Level::Baseline;
+}
+
+#if IPTSD_CPU_DISPATCH
+
+/*
+ * The variants are created by inlining everything that the kernel calls into a function
+ * that is compiled for a different instruction set. Because the inlined code is only
+ * reachable through that function, nothing compiled for a newer CPU can leak into the
+ * rest of the binary.
+ */
+
+template <class Func>
+[[gnu::flatten, gnu::target("avx2,fma")]] void run_avx2(const Func &func)
+{
+	func();
+}
+
+template <class Func>
+[[gnu::flatten, gnu::target("avx2,fma,avx512f,avx512vl,avx512bw,avx512dq")]] void
+run_avx512(const Func &func)
+{
+	func();
+}
+
+#endif
+
+} // namespace impl
+
+/*!
+ * The best variant of the kernels that can run on the CPU.
+ *
+ * The CPU is only queried the first time this is called.
+ */
+inline Level level()
+{
+	static const Level level = impl::detect();
+	return level;
+}
+
+/*!
+ * Runs a kernel in the variant that fits the CPU best.
+ *
+ * Everything that the kernel calls is compiled into every variant, so the kernel
+ * should be small and not call into large parts of the program.
+ *
+ * @param[in] func The kernel.
+ */
+template <class Func>
+void dispatch(const Func &func)
+{
+#if IPTSD_CPU_DISPATCH
+	switch (level()) {
+	case Level::AVX512:
+		impl::run_avx512(func);
+		return;
+	case Level::AVX2:
+		impl::run_avx2(func);
+		return;
+	default:
+		break;
+	}
+#endif
+
+	func();
+}
+
+} // namespace iptsd::common::cpu
+
+#endif // IPTSD_COMMON_CPU_HPP
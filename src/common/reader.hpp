@@ -9,6 +9,7 @@
 #include <gsl/gsl>
 
 #include <algorithm>
+#include <cstring>
 
 namespace iptsd {
 namespace impl {
@@ -129,6 +130,68 @@ public:
 
 		return value;
 	}
+
+	/*
+	 * The following functions don't check if enough data is left.
+	 *
+	 * They are meant for walking data whose structure has already been validated,
+	 * so that the same bounds don't have to be checked twice.
+	 */
+
+	/*!
+	 * Moves the current position forward without checking the bounds.
+	 *
+	 * @param[in] size How many bytes to skip.
+	 */
+	void skip_unchecked(const usize size)
+	{
+		m_index += size;
+	}
+
+	/*!
+	 * Takes a chunk of bytes from the current position without checking the bounds.
+	 *
+	 * @param[in] size How many objects of type T to take.
+	 * @return The raw chunk of data.
+	 */
+	template <class T>
+	gsl::span<T> subspan_unchecked(const usize size)
+	{
+		u8 *data = m_data.data() + m_index;
+		this->skip_unchecked(size * sizeof(T));
+
+		// We have to break type safety here, since all we have is a bytestream.
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return gsl::span<T> {reinterpret_cast<T *>(data), size};
+	}
+
+	/*!
+	 * Splits off a chunk of bytes from the current position without checking the bounds.
+	 *
+	 * @param[in] size How many bytes to take.
+	 * @return A new reader instance for the chunk of data.
+	 */
+	Reader sub_unchecked(const usize size)
+	{
+		return Reader {this->subspan_unchecked<u8>(size)};
+	}
+
+	/*!
+	 * Reads an object from the current position without checking the bounds.
+	 *
+	 * @tparam T The type (and size) of the object to read.
+	 * @return The object that was read.
+	 */
+	template <class T>
+	T read_unchecked()
+	{
+		T value {};
+
+		std::memcpy(&value, m_data.data() + m_index, sizeof(value));
+		this->skip_unchecked(sizeof(value));
+
+		return value;
+	}
 };
 
 } // namespace iptsd
@@ -0,0 +1,522 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_COMMON_SIMD_HPP
+#define IPTSD_COMMON_SIMD_HPP
+
+#include "types.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+/*
+ * GCC and clang provide generic vector types, that are mapped to the vector instructions of
+ * the target (SSE and AVX on x86-64, NEON on aarch64). Inside the variants of the hot kernels
+ * (see common/cpu.hpp) the same code is compiled for AVX2 and AVX-512. The vectors are always
+ * 256 bits wide, so the AVX-512 variant uses the 256 bit forms of its instructions.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define IPTSD_SIMD_VECTORS 1
+#else
+#define IPTSD_SIMD_VECTORS 0
+#endif
+
+namespace iptsd::common::simd {
+
+/*
+ * A vector with a single lane.
+ *
+ * This is the fallback for compilers without vector types, and it processes the remaining
+ * elements of a loop that don't fill a whole vector. Because it follows the exact order of
+ * operations of a plain loop, it is also the reference implementation of every kernel.
+ */
+template <class T>
+class Scalar {
+public:
+	static_assert(std::is_arithmetic_v<T>);
+
+	using Type = T;
+
+	// The number of elements in the vector.
+	static constexpr Eigen::Index Size = 1;
+
+	/*
+	 * The result of comparing two vectors.
+	 */
+	class Mask {
+	public:
+		bool value = false;
+
+	public:
+		/*!
+		 * Whether the comparison was true for a lane.
+		 */
+		[[nodiscard]] bool test(const Eigen::Index /* unused */) const
+		{
+			return value;
+		}
+
+		/*!
+		 * Whether the comparison was true for any lane.
+		 */
+		[[nodiscard]] bool any() const
+		{
+			return value;
+		}
+
+		friend Mask operator&(const Mask &a, const Mask &b)
+		{
+			return Mask {a.value && b.value};
+		}
+
+		friend Mask operator|(const Mask &a, const Mask &b)
+		{
+			return Mask {a.value || b.value};
+		}
+	};
+
+public:
+	T value {};
+
+public:
+	/*!
+	 * Loads a vector from memory, that doesn't need to be aligned.
+	 */
+	[[nodiscard]] static Scalar load(const T *ptr)
+	{
+		return Scalar {*ptr};
+	}
+
+	/*!
+	 * Loads a vector from memory and converts the elements to the type of the vector.
+	 */
+	template <class U>
+	[[nodiscard]] static Scalar convert(const U *ptr)
+	{
+		return Scalar {static_cast<T>(*ptr)};
+	}
+
+	/*!
+	 * Creates a vector with the same value in all lanes.
+	 */
+	[[nodiscard]] static Scalar broadcast(const T value)
+	{
+		return Scalar {value};
+	}
+
+	/*!
+	 * Creates a vector whose lanes count up from first, in steps of step.
+	 */
+	[[nodiscard]] static Scalar linear(const T first, const T /* unused */)
+	{
+		return Scalar {first};
+	}
+
+	/*!
+	 * Stores the vector in memory, that doesn't need to be aligned.
+	 */
+	void store(T *ptr) const
+	{
+		*ptr = value;
+	}
+
+	/*!
+	 * Reads the value of a single lane.
+	 */
+	[[nodiscard]] T lane(const Eigen::Index /* unused */) const
+	{
+		return value;
+	}
+
+	/*!
+	 * Applies a function to every lane. This is not vectorized.
+	 */
+	template <class Func>
+	[[nodiscard]] Scalar apply(const Func &func) const
+	{
+		return Scalar {func(value)};
+	}
+
+	friend Scalar operator+(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {a.value + b.value};
+	}
+
+	friend Scalar operator-(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {a.value - b.value};
+	}
+
+	friend Scalar operator*(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {a.value * b.value};
+	}
+
+	friend Scalar operator/(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {a.value / b.value};
+	}
+
+	friend Mask operator<(const Scalar &a, const Scalar &b)
+	{
+		return Mask {a.value < b.value};
+	}
+
+	friend Mask operator<=(const Scalar &a, const Scalar &b)
+	{
+		return Mask {a.value <= b.value};
+	}
+
+	friend Mask operator>(const Scalar &a, const Scalar &b)
+	{
+		return Mask {a.value > b.value};
+	}
+
+	friend Mask operator>=(const Scalar &a, const Scalar &b)
+	{
+		return Mask {a.value >= b.value};
+	}
+
+	/*!
+	 * Picks the lanes of a where the mask is set, and the lanes of b everywhere else.
+	 */
+	friend Scalar select(const Mask &mask, const Scalar &a, const Scalar &b)
+	{
+		return mask.value ? a : b;
+	}
+
+	/*!
+	 * Calculates a * b + c. Where the hardware supports it, the compiler fuses the operations.
+	 */
+	friend Scalar fma(const Scalar &a, const Scalar &b, const Scalar &c)
+	{
+		return Scalar {a.value * b.value + c.value};
+	}
+
+	friend Scalar min(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {b.value < a.value ? b.value : a.value};
+	}
+
+	friend Scalar max(const Scalar &a, const Scalar &b)
+	{
+		return Scalar {a.value < b.value ? b.value : a.value};
+	}
+
+	/*!
+	 * Adds up all lanes of the vector.
+	 */
+	friend T sum(const Scalar &a)
+	{
+		return a.value;
+	}
+
+	/*!
+	 * The largest value of all lanes of the vector.
+	 */
+	friend T hmax(const Scalar &a)
+	{
+		return a.value;
+	}
+};
+
+#if IPTSD_SIMD_VECTORS
+
+namespace impl {
+
+/*!
+ * Reinterprets the bits of a vector as a different vector type of the same size.
+ */
+template <class To, class From>
+To bit_cast(const From &from)
+{
+	static_assert(sizeof(To) == sizeof(From));
+
+	To to {};
+	std::memcpy(&to, &from, sizeof(To));
+	return to;
+}
+
+} // namespace impl
+
+/*
+ * A vector with as many lanes as fit into a 256 bit register.
+ *
+ * With SSE and NEON, the compiler splits every operation into two 128 bit instructions.
+ * The vectors are always passed by reference, because their calling convention depends on
+ * the instruction set. Since all functions are inlined that doesn't cost anything.
+ */
+template <class T>
+class Native {
+public:
+	static_assert(std::is_arithmetic_v<T>);
+
+	using Type = T;
+
+	// The size of the vector in bytes.
+	static constexpr usize Bytes = 32;
+
+	// The number of elements in the vector.
+	static constexpr Eigen::Index Size = Bytes / sizeof(T);
+
+	using Lanes [[gnu::vector_size(Bytes)]] = T;
+
+	// A comparison sets all bits of a lane if it is true, and clears them if it is false.
+	using Bit = std::conditional_t<sizeof(T) == 8, i64, i32>;
+	using Bits [[gnu::vector_size(Bytes)]] = Bit;
+
+	static_assert(sizeof(T) == sizeof(Bit));
+
+	/*
+	 * The result of comparing two vectors.
+	 */
+	class Mask {
+	public:
+		Bits value {};
+
+	public:
+		/*!
+		 * Whether the comparison was true for a lane.
+		 */
+		[[nodiscard]] bool test(const Eigen::Index i) const
+		{
+			return value[i] != 0;
+		}
+
+		/*!
+		 * Whether the comparison was true for any lane.
+		 */
+		[[nodiscard]] bool any() const
+		{
+			Bit bits = 0;
+
+			for (Eigen::Index i = 0; i < Size; i++)
+				bits |= value[i];
+
+			return bits != 0;
+		}
+
+		friend Mask operator&(const Mask &a, const Mask &b)
+		{
+			return Mask {a.value & b.value};
+		}
+
+		friend Mask operator|(const Mask &a, const Mask &b)
+		{
+			return Mask {a.value | b.value};
+		}
+	};
+
+public:
+	Lanes value {};
+
+public:
+	/*!
+	 * Loads a vector from memory, that doesn't need to be aligned.
+	 */
+	[[nodiscard]] static Native load(const T *ptr)
+	{
+		Native v {};
+		std::memcpy(&v.value, ptr, Bytes);
+		return v;
+	}
+
+	/*!
+	 * Loads a vector from memory and converts the elements to the type of the vector.
+	 */
+	template <class U>
+	[[nodiscard]] static Native convert(const U *ptr)
+	{
+		if constexpr (std::is_same_v<T, U>) {
+			return load(ptr);
+		} else {
+			Native v {};
+
+			for (Eigen::Index i = 0; i < Size; i++)
+				v.value[i] = static_cast<T>(ptr[i]);
+
+			return v;
+		}
+	}
+
+	/*!
+	 * Creates a vector with the same value in all lanes.
+	 */
+	[[nodiscard]] static Native broadcast(const T value)
+	{
+		// Subtracting zero keeps the value as it is, even if it is negative zero.
+		return Native {value - Lanes {}};
+	}
+
+	/*!
+	 * Creates a vector whose lanes count up from first, in steps of step.
+	 */
+	[[nodiscard]] static Native linear(const T first, const T step)
+	{
+		Native v {};
+
+		for (Eigen::Index i = 0; i < Size; i++)
+			v.value[i] = first + static_cast<T>(i) * step;
+
+		return v;
+	}
+
+	/*!
+	 * Stores the vector in memory, that doesn't need to be aligned.
+	 */
+	void store(T *ptr) const
+	{
+		std::memcpy(ptr, &value, Bytes);
+	}
+
+	/*!
+	 * Reads the value of a single lane.
+	 */
+	[[nodiscard]] T lane(const Eigen::Index i) const
+	{
+		return value[i];
+	}
+
+	/*!
+	 * Applies a function to every lane. This is not vectorized.
+	 */
+	template <class Func>
+	[[nodiscard]] Native apply(const Func &func) const
+	{
+		Native v {};
+
+		for (Eigen::Index i = 0; i < Size; i++)
+			v.value[i] = func(value[i]);
+
+		return v;
+	}
+
+	friend Native operator+(const Native &a, const Native &b)
+	{
+		return Native {a.value + b.value};
+	}
+
+	friend Native operator-(const Native &a, const Native &b)
+	{
+		return Native {a.value - b.value};
+	}
+
+	friend Native operator*(const Native &a, const Native &b)
+	{
+		return Native {a.value * b.value};
+	}
+
+	friend Native operator/(const Native &a, const Native &b)
+	{
+		return Native {a.value / b.value};
+	}
+
+	friend Mask operator<(const Native &a, const Native &b)
+	{
+		return Mask {a.value < b.value};
+	}
+
+	friend Mask operator<=(const Native &a, const Native &b)
+	{
+		return Mask {a.value <= b.value};
+	}
+
+	friend Mask operator>(const Native &a, const Native &b)
+	{
+		return Mask {a.value > b.value};
+	}
+
+	friend Mask operator>=(const Native &a, const Native &b)
+	{
+		return Mask {a.value >= b.value};
+	}
+
+	/*!
+	 * Picks the lanes of a where the mask is set, and the lanes of b everywhere else.
+	 */
+	friend Native select(const Mask &mask, const Native &a, const Native &b)
+	{
+		const Bits bits = (mask.value & impl::bit_cast<Bits>(a.value)) |
+		                  (~mask.value & impl::bit_cast<Bits>(b.value));
+
+		return Native {impl::bit_cast<Lanes>(bits)};
+	}
+
+	/*!
+	 * Calculates a * b + c. Where the hardware supports it, the compiler fuses the operations.
+	 */
+	friend Native fma(const Native &a, const Native &b, const Native &c)
+	{
+		return Native {a.value * b.value + c.value};
+	}
+
+	friend Native min(const Native &a, const Native &b)
+	{
+		return select(b < a, b, a);
+	}
+
+	friend Native max(const Native &a, const Native &b)
+	{
+		return select(a < b, b, a);
+	}
+
+	/*!
+	 * Adds up all lanes of the vector.
+	 */
+	friend T sum(const Native &a)
+	{
+		T value = a.value[0];
+
+		for (Eigen::Index i = 1; i < Size; i++)
+			value += a.value[i];
+
+		return value;
+	}
+
+	/*!
+	 * The largest value of all lanes of the vector.
+	 */
+	friend T hmax(const Native &a)
+	{
+		T value = a.value[0];
+
+		for (Eigen::Index i = 1; i < Size; i++)
+			value = value < a.value[i] ? a.value[i] : value;
+
+		return value;
+	}
+};
+
+#else
+
+template <class T>
+using Native = Scalar<T>;
+
+#endif
+
+/*!
+ * Runs a kernel over a range of elements, one vector at a time.
+ *
+ * The elements at the end of the range that don't fill a whole vector are processed
+ * with @ref Scalar. The kernel gets an empty vector of the type that it should use,
+ * and the index of the first element.
+ *
+ * @tparam V The vector type that is used for the bulk of the range.
+ * @param[in] begin The first element of the range.
+ * @param[in] end The element after the last element of the range.
+ * @param[in] func The kernel.
+ */
+template <class V, class Func>
+void loop(const Eigen::Index begin, const Eigen::Index end, const Func &func)
+{
+	Eigen::Index i = begin;
+
+	for (; i + V::Size <= end; i += V::Size)
+		func(V {}, i);
+
+	for (; i < end; i++)
+		func(Scalar<typename V::Type> {}, i);
+}
+
+} // namespace iptsd::common::simd
+
+#endif // IPTSD_COMMON_SIMD_HPP
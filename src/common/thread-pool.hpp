@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_COMMON_THREAD_POOL_HPP
+#define IPTSD_COMMON_THREAD_POOL_HPP
+
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace iptsd::common {
+
+/*
+ * A fixed set of worker threads that process batches of tasks.
+ *
+ * The threads are started once and then sleep until a batch is submitted, so that the cost
+ * of creating threads is not paid for every batch. The thread submitting the batch takes part
+ * in processing it, and only returns once all tasks of the batch are done.
+ */
+class ThreadPool {
+private:
+	std::vector<std::thread> m_threads {};
+
+	std::mutex m_mutex {};
+
+	// Signals the workers that a new batch was submitted, or that they should stop.
+	std::condition_variable m_start {};
+
+	// Signals the submitting thread that all workers are done with the batch.
+	std::condition_variable m_done {};
+
+	// The current batch, a type erased function and the number of tasks.
+	void (*m_func)(const void *, usize) = nullptr;
+	const void *m_context = nullptr;
+	usize m_tasks = 0;
+
+	// The index of the next task that has not been started.
+	std::atomic<usize> m_next = 0;
+
+	// How many workers are still processing the current batch.
+	usize m_active = 0;
+
+	// Incremented for every batch, so that workers can tell if they have seen it.
+	usize m_generation = 0;
+
+	bool m_stop = false;
+
+public:
+	/*!
+	 * Starts the worker threads.
+	 *
+	 * @param[in] threads The number of threads that process a batch, including the caller.
+	 */
+	ThreadPool(const usize threads)
+	{
+		for (usize i = 1; i < threads; i++)
+			m_threads.emplace_back([&]() { this->worker(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			const std::lock_guard lock {m_mutex};
+			m_stop = true;
+		}
+
+		m_start.notify_all();
+
+		for (std::thread &thread : m_threads)
+			thread.join();
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/*!
+	 * The number of threads that process a batch, including the caller.
+	 */
+	[[nodiscard]] usize size() const
+	{
+		return m_threads.size() + 1;
+	}
+
+	/*!
+	 * Runs a batch of tasks and waits for all of them to finish.
+	 *
+	 * The tasks are distributed over all threads in no particular order.
+	 * They must not throw exceptions.
+	 *
+	 * @param[in] tasks The number of tasks.
+	 * @param[in] func The function that processes a task. It receives the index of the task.
+	 */
+	template <class Func>
+	void run(const usize tasks, const Func &func)
+	{
+		if (tasks == 0)
+			return;
+
+		if (m_threads.empty() || tasks == 1) {
+			for (usize i = 0; i < tasks; i++)
+				func(i);
+
+			return;
+		}
+
+		{
+			const std::lock_guard lock {m_mutex};
+
+			m_func = [](const void *context, const usize i) {
+				(*static_cast<const Func *>(context))(i);
+			};
+
+			m_context = &func;
+			m_tasks = tasks;
+			m_next = 0;
+			m_active = m_threads.size();
+			m_generation++;
+		}
+
+		m_start.notify_all();
+		this->work();
+
+		std::unique_lock lock {m_mutex};
+		m_done.wait(lock, [&]() { return m_active == 0; });
+	}
+
+private:
+	/*!
+	 * Processes tasks of the current batch until none are left.
+	 */
+	void work()
+	{
+		for (usize i = m_next++; i < m_tasks; i = m_next++)
+			m_func(m_context, i);
+	}
+
+	/*!
+	 * The main loop of a worker thread.
+	 */
+	void worker()
+	{
+		usize seen = 0;
+
+		while (true) {
+			{
+				std::unique_lock lock {m_mutex};
+				m_start.wait(lock, [&]() {
+					return m_stop || m_generation != seen;
+				});
+
+				if (m_stop)
+					return;
+
+				seen = m_generation;
+			}
+
+			this->work();
+
+			const std::lock_guard lock {m_mutex};
+
+			if (--m_active == 0)
+				m_done.notify_one();
+		}
+	}
+};
+
+} // namespace iptsd::common
+
+#endif // IPTSD_COMMON_THREAD_POOL_HPP
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_COMMON_TRIPLE_BUFFER_HPP
+#define IPTSD_COMMON_TRIPLE_BUFFER_HPP
+
+#include "types.hpp"
+
+#include <array>
+#include <atomic>
+
+namespace iptsd::common {
+
+/*
+ * A lock-free triple buffer for passing data from one producer thread to one consumer thread.
+ *
+ * The producer always has a buffer to write to and the consumer always has a buffer to
+ * read from, without ever waiting for each other. If the producer publishes faster than
+ * the consumer reads, older values are dropped and the consumer only sees the newest one.
+ */
+template <class T>
+class TripleBuffer {
+private:
+	// The lower bits of the shared state hold the index of the middle buffer.
+	static constexpr u8 INDEX_MASK = 0b011;
+
+	// This bit is set when the middle buffer holds data that the consumer hasn't seen yet.
+	static constexpr u8 FRESH_BIT = 0b100;
+
+	std::array<T, 3> m_buffers {};
+
+	// The buffer that is currently owned by the producer.
+	u8 m_back = 0;
+
+	// The buffer that is currently owned by the consumer.
+	u8 m_front = 1;
+
+	// The buffer that is exchanged between producer and consumer.
+	std::atomic<u8> m_middle = 2;
+
+public:
+	/*!
+	 * The buffer that the producer can write into.
+	 *
+	 * Its previous contents are undefined, since it can be a buffer the consumer has read.
+	 * Must only be called from the producer thread.
+	 *
+	 * @return A reference to the back buffer.
+	 */
+	T &back()
+	{
+		return m_buffers.at(m_back);
+	}
+
+	/*!
+	 * Makes the contents of the back buffer available to the consumer.
+	 *
+	 * Must only be called from the producer thread.
+	 */
+	void publish()
+	{
+		const u8 old = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel);
+		m_back = old & INDEX_MASK;
+	}
+
+	/*!
+	 * Fetches the newest data that was published by the producer, if there is any.
+	 *
+	 * Must only be called from the consumer thread.
+	 *
+	 * @return Whether the front buffer has changed.
+	 */
+	bool update()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+			return false;
+
+		const u8 old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+		m_front = old & INDEX_MASK;
+
+		return true;
+	}
+
+	/*!
+	 * The buffer that the consumer can read from.
+	 *
+	 * Must only be called from the consumer thread.
+	 *
+	 * @return A reference to the front buffer.
+	 */
+	const T &front() const
+	{
+		return m_buffers.at(m_front);
+	}
+};
+
+} // namespace iptsd::common
+
+#endif // IPTSD_COMMON_TRIPLE_BUFFER_HPP
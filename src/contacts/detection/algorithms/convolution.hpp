@@ -3,10 +3,11 @@
 #ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_CONVOLUTION_HPP
 #define IPTSD_CONTACTS_DETECTION_ALGORITHMS_CONVOLUTION_HPP
 
-#include "optimized/convolution.3x3-extend.hpp"
-#include "optimized/convolution.5x5-extend.hpp"
+#include "optimized/convolution.square-extend.hpp"
 
 #include <common/casts.hpp>
+#include <common/cpu.hpp>
+#include <common/simd.hpp>
 #include <common/types.hpp>
 
 namespace iptsd::contacts::detection::convolution {
@@ -66,6 +67,38 @@ void run_generic(const DenseBase<DerivedData> &in,
 	}
 }
 
+/*!
+ * Runs a 2D convolution of a collection and a kernel, with the routine that fits the kernel.
+ *
+ * Do not call this directly, use iptsd::contacts::detection::convolution::run.
+ *
+ * @tparam V The vector type, @ref common::simd::Scalar gives the reference implementation.
+ * @param[in] in The input data.
+ * @param[in] kernel The kernel that is applied to the input data.
+ * @param[out] out A reference to the matrix where the results of the convolution are stored.
+ */
+template <class V, class DerivedData, class DerivedKernel>
+inline void run_any(const DenseBase<DerivedData> &in,
+                    const DenseBase<DerivedKernel> &kernel,
+                    DenseBase<DerivedData> &out)
+{
+	constexpr usize Rows = DerivedKernel::RowsAtCompileTime;
+	constexpr usize Cols = DerivedKernel::ColsAtCompileTime;
+
+	if constexpr (Rows == 3 && Cols == 3) {
+		run_square<V, 1>(in, kernel, out);
+	} else if constexpr (Rows == 5 && Cols == 5) {
+		run_square<V, 2>(in, kernel, out);
+	} else {
+		if (kernel.rows() == 3 && kernel.cols() == 3)
+			run_square<V, 1>(in, kernel, out);
+		else if (kernel.rows() == 5 && kernel.cols() == 5)
+			run_square<V, 2>(in, kernel, out);
+		else
+			run_generic(in, kernel, out);
+	}
+}
+
 } // namespace impl
 
 /*!
@@ -75,6 +108,7 @@ void run_generic(const DenseBase<DerivedData> &in,
  * will be used. Otherwise a generic implementation gets used.
  *
  * The borders of the input data will be extended to prevent overflowing indices.
+ * The convolution is compiled for multiple instruction sets, see @ref common::cpu::dispatch.
  *
  * @param[in] in The input data.
  * @param[in] kernel The kernel that is applied to the input data.
@@ -85,21 +119,9 @@ inline void run(const DenseBase<DerivedData> &in,
                 const DenseBase<DerivedKernel> &kernel,
                 DenseBase<DerivedData> &out)
 {
-	constexpr usize Rows = DerivedKernel::RowsAtCompileTime;
-	constexpr usize Cols = DerivedKernel::ColsAtCompileTime;
+	using V = common::simd::Native<typename DenseBase<DerivedData>::Scalar>;
 
-	if constexpr (Rows == 3 && Cols == 3) {
-		impl::run_3x3(in, kernel, out);
-	} else if constexpr (Rows == 5 && Cols == 5) {
-		impl::run_5x5(in, kernel, out);
-	} else {
-		if (kernel.rows() == 3 && kernel.cols() == 3)
-			impl::run_3x3(in, kernel, out);
-		else if (kernel.rows() == 5 && kernel.cols() == 5)
-			impl::run_5x5(in, kernel, out);
-		else
-			impl::run_generic(in, kernel, out);
-	}
+	common::cpu::dispatch([&]() { impl::run_any<V>(in, kernel, out); });
 }
 
 } // namespace iptsd::contacts::detection::convolution
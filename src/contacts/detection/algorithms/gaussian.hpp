@@ -3,13 +3,20 @@
 #ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_GAUSSIAN_HPP
 #define IPTSD_CONTACTS_DETECTION_ALGORITHMS_GAUSSIAN_HPP
 
+#include <common/buildopts.hpp>
 #include <common/casts.hpp>
+#include <common/cpu.hpp>
+#include <common/simd.hpp>
 #include <common/types.hpp>
 
 #include <gsl/gsl>
 #include <gsl/util>
 
+#include <array>
+#include <cmath>
+#include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace iptsd::contacts::detection::gaussian {
 
@@ -39,29 +46,65 @@ namespace impl {
 template <class T>
 constexpr T EPS = std::is_same_v<T, f32> ? gsl::narrow_cast<T>(1E-20) : gsl::narrow_cast<T>(1E-40);
 
-/*!
- * 2D Gaussian probability density function without normalization.
- *
- * @param[in] x Position at which to evaluate the function.
- * @param[in] mean Mean of the Gaussian.
- * @param[in] prec Precision matrix, i.e. the invariance of the covariance matrix.
+/*
+ * The sums of the powers of x, weighted by the data, along one row of a sample window.
  */
-template <class T>
-T gaussian_like(const Vector2<T> &x, const Vector2<T> &mean, const Matrix2<T> &prec)
-{
-	const Vector2<T> vec = x - mean;
-	const T vtmv = vec.transpose() * prec * vec;
+template <class V>
+struct Moments {
+	// The sums of d^2 * x^a for a = 0..4.
+	std::array<V, 5> s {};
 
-	return std::exp(-vtmv) / casts::to<T>(2);
-}
+	// The sums of log(d) * d^2 * x^a for a = 0..2.
+	std::array<V, 3> r {};
+
+	void add(const V &x, const V &d)
+	{
+		using T = typename V::Type;
+
+		const auto ln = [](const T v) { return std::log(v); };
+		const V log = (d + V::broadcast(EPS<T>)).apply(ln);
+
+		V ds = d * d;
+		V dr = log * ds;
+
+		for (usize a = 0; a < s.size(); a++) {
+			s[a] = s[a] + ds;
+			ds = ds * x;
+		}
 
-template <class T, class DerivedData>
+		for (usize a = 0; a < r.size(); a++) {
+			r[a] = r[a] + dr;
+			dr = dr * x;
+		}
+	}
+};
+
+/*!
+ * Assembles the system of linear equations that fits a Gaussian to the data in its window.
+ *
+ * Every entry of the system is a sum of d^2 * x^a * y^b (or log(d) * d^2 * x^a * y^b) over
+ * the window, and only 15 (or 6) of these sums are different. They are accumulated one row
+ * and one vector at a time, and then spread out into the system.
+ *
+ * @tparam V The vector type, @ref common::simd::Scalar gives the reference implementation.
+ * @param[out] m The system matrix.
+ * @param[out] rhs The right hand side of the system.
+ * @param[in] b The sample window of the Gaussian.
+ * @param[in] data The data that the Gaussian is fitted to.
+ * @param[in] w The weights of the pixels in the sample window.
+ */
+template <class V, class T, class DerivedData>
 void assemble_system(Matrix6<T> &m,
                      Vector6<T> &rhs,
                      const Box &b,
                      const DenseBase<DerivedData> &data,
                      const Matrix<T> &w)
 {
+	using S = common::simd::Scalar<T>;
+
+	static_assert(DerivedData::IsRowMajor);
+	static_assert(std::is_same_v<typename V::Type, T>);
+
 	const Eigen::Index cols = data.cols();
 	const Eigen::Index rows = data.rows();
 
@@ -70,8 +113,9 @@ void assemble_system(Matrix6<T> &m,
 		casts::to<T>(2) / casts::to<T>(rows),
 	};
 
-	m.setZero();
-	rhs.setZero();
+	// The sums of d^2 * x^a * y^b and log(d) * d^2 * x^a * y^b, indexed by a and b.
+	std::array<std::array<T, 5>, 5> sm {};
+	std::array<std::array<T, 3>, 3> sr {};
 
 	const Point &bmin = b.min();
 	const Point &bmax = b.max();
@@ -79,64 +123,65 @@ void assemble_system(Matrix6<T> &m,
 	for (Eigen::Index iy = bmin.y(); iy <= bmax.y(); iy++) {
 		const T y = casts::to<T>(iy) * scale.y() - 1;
 
-		for (Eigen::Index ix = bmin.x(); ix <= bmax.x(); ix++) {
-			const T x = casts::to<T>(ix) * scale.x() - 1;
-
-			const T d =
-				w(iy - bmin.y(), ix - bmin.x()) * gsl::narrow_cast<T>(data(iy, ix));
-			const T v = std::log(d + EPS<T>) * d * d;
-
-			rhs(0) += v * x * x;
-			rhs(1) += v * x * y;
-			rhs(2) += v * y * y;
-			rhs(3) += v * x;
-			rhs(4) += v * y;
-			rhs(5) += v;
-
-			m(0, 0) += d * d * x * x * x * x;
-			m(0, 1) += d * d * x * x * x * y;
-			m(0, 2) += d * d * x * x * y * y;
-			m(0, 3) += d * d * x * x * x;
-			m(0, 4) += d * d * x * x * y;
-			m(0, 5) += d * d * x * x;
-
-			m(1, 0) += d * d * x * x * x * y;
-			m(1, 1) += d * d * x * x * y * y;
-			m(1, 2) += d * d * x * y * y * y;
-			m(1, 3) += d * d * x * x * y;
-			m(1, 4) += d * d * x * y * y;
-			m(1, 5) += d * d * x * y;
-
-			m(2, 0) += d * d * x * x * y * y;
-			m(2, 1) += d * d * x * y * y * y;
-			m(2, 2) += d * d * y * y * y * y;
-			m(2, 3) += d * d * x * y * y;
-			m(2, 4) += d * d * y * y * y;
-			m(2, 5) += d * d * y * y;
-
-			m(3, 0) += d * d * x * x * x;
-			m(3, 1) += d * d * x * x * y;
-			m(3, 2) += d * d * x * y * y;
-			m(3, 3) += d * d * x * x;
-			m(3, 4) += d * d * x * y;
-			m(3, 5) += d * d * x;
-
-			m(4, 0) += d * d * x * x * y;
-			m(4, 1) += d * d * x * y * y;
-			m(4, 2) += d * d * y * y * y;
-			m(4, 3) += d * d * x * y;
-			m(4, 4) += d * d * y * y;
-			m(4, 5) += d * d * y;
-
-			m(5, 0) += d * d * x * x;
-			m(5, 1) += d * d * x * y;
-			m(5, 2) += d * d * y * y;
-			m(5, 3) += d * d * x;
-			m(5, 4) += d * d * y;
-			m(5, 5) += d * d;
+		const auto *drow = data.derived().data() + iy * data.derived().outerStride();
+		const auto *wrow = w.data() + (iy - bmin.y()) * w.outerStride();
+
+		Moments<V> vector {};
+		Moments<S> tail {};
+
+		const auto kernel = [&](const auto &lanes, const Eigen::Index ix) {
+			using W = std::decay_t<decltype(lanes)>;
+
+			if constexpr (common::buildopts::ForceAccessChecks)
+				eigen_assert(ix >= bmin.x() && ix + W::Size <= bmax.x() + 1);
+
+			const W px = W::linear(casts::to<T>(ix), casts::to<T>(1));
+			const W x = px * W::broadcast(scale.x()) - W::broadcast(casts::to<T>(1));
+
+			const W d = W::load(wrow + (ix - bmin.x())) * W::convert(drow + ix);
+
+			if constexpr (std::is_same_v<W, V>)
+				vector.add(x, d);
+			else
+				tail.add(x, d);
+		};
+
+		common::simd::loop<V>(bmin.x(), bmax.x() + 1, kernel);
+
+		T ys = casts::to<T>(1);
+
+		for (usize j = 0; j < sm.size(); j++) {
+			for (usize i = 0; i + j < sm.size(); i++)
+				sm[i][j] += (sum(vector.s[i]) + sum(tail.s[i])) * ys;
+
+			for (usize i = 0; i + j < sr.size(); i++)
+				sr[i][j] += (sum(vector.r[i]) + sum(tail.r[i])) * ys;
+
+			ys *= y;
 		}
 	}
 
+	// The powers of x and y that make up the parameters of the fit.
+	constexpr std::array<std::array<usize, 2>, 6> powers {{
+		{2, 0},
+		{1, 1},
+		{0, 2},
+		{1, 0},
+		{0, 1},
+		{0, 0},
+	}};
+
+	for (usize r = 0; r < powers.size(); r++) {
+		const auto [rx, ry] = powers[r];
+
+		for (usize c = 0; c < powers.size(); c++) {
+			const auto [cx, cy] = powers[c];
+			m(casts::to_eigen(r), casts::to_eigen(c)) = sm[rx + cx][ry + cy];
+		}
+
+		rhs(casts::to_eigen(r)) = sr[rx][ry];
+	}
+
 	m.row(1) *= 2;
 }
 
@@ -159,6 +204,61 @@ bool extract_params(const Vector6<T> &chi, T &scale, Vector2<T> &mean, Matrix2<T
 	return true;
 }
 
+/*!
+ * Checks if the sample windows of any two valid Gaussians overlap.
+ *
+ * @param[in] params The parameters of all Gaussians.
+ * @return Whether at least one pixel is sampled by more than one Gaussian.
+ */
+template <class T>
+bool windows_overlap(const std::vector<Parameters<T>> &params)
+{
+	for (usize i = 0; i < params.size(); i++) {
+		if (!params[i].valid)
+			continue;
+
+		for (usize j = i + 1; j < params.size(); j++) {
+			if (params[j].valid && params[i].bounds.intersects(params[j].bounds))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Evaluates the quadratic form of a 2D Gaussian in its sample window.
+ *
+ * Along a row, the quadratic form only depends on the distance to the mean on the x axis,
+ * so it is evaluated for a whole row at once.
+ *
+ * @param[in,out] p The parameters of the Gaussian. The result is stored in its weights.
+ * @param[in] scale The factor that scales the sample positions to the range [-1, 1].
+ */
+template <class T>
+void evaluate_form(Parameters<T> &p, const Vector2<T> &scale)
+{
+	const Point bmin = p.bounds.min();
+	const Point bmax = p.bounds.max();
+
+	const Eigen::Index width = bmax.x() - bmin.x() + 1;
+
+	const T a = p.prec(0, 0);
+	const T b = p.prec(0, 1) + p.prec(1, 0);
+	const T c = p.prec(1, 1);
+
+	// The distances of all columns of the window to the mean.
+	const T xmin = casts::to<T>(bmin.x());
+	const T xmax = casts::to<T>(bmax.x());
+	const auto dx = (Array<T>::LinSpaced(width, xmin, xmax) * scale.x() - 1) - p.mean.x();
+
+	// vec^T * prec * vec for every pixel
+	for (Eigen::Index iy = bmin.y(); iy <= bmax.y(); iy++) {
+		const T dy = (casts::to<T>(iy) * scale.y() - 1) - p.mean.y();
+		p.weights.row(iy - bmin.y()).array() = (a * dx + b * dy) * dx + c * dy * dy;
+	}
+}
+
 template <class Derived>
 void update_weight_maps(std::vector<Parameters<typename DenseBase<Derived>::Scalar>> &params,
                         DenseBase<Derived> &total)
@@ -173,58 +273,58 @@ void update_weight_maps(std::vector<Parameters<typename DenseBase<Derived>::Scal
 		casts::to<T>(2) / casts::to<T>(rows),
 	};
 
-	total.setZero();
+	/*
+	 * The clusters are merged before fitting, so usually no pixel is sampled by more
+	 * than one Gaussian. Then normalizing only divides every weight by itself.
+	 */
+	const bool overlap = windows_overlap(params);
+
+	if (overlap)
+		total.setZero();
 
-	// compute individual Gaussians in sample windows
+	// compute individual Gaussians in sample windows and sum up total
 	for (auto &p : params) {
 		if (!p.valid)
 			continue;
 
-		const Point bmin = p.bounds.min();
-		const Point bmax = p.bounds.max();
+		evaluate_form(p, scale);
 
-		for (Eigen::Index iy = bmin.y(); iy <= bmax.y(); iy++) {
-			const T y = casts::to<T>(iy) * scale.y() - 1;
+		auto weights = p.weights.array();
 
-			for (Eigen::Index ix = bmin.x(); ix <= bmax.x(); ix++) {
-				const T x = casts::to<T>(ix) * scale.x() - 1;
+		/*
+		 * Without overlap, only the pixels where the Gaussian is positive get a weight
+		 * of one, and the others are zero. The Gaussian is positive until the exponential
+		 * function underflows, so the quadratic form only has to be compared to that limit.
+		 */
+		if (!overlap) {
+			const T min = std::log(std::numeric_limits<T>::denorm_min());
+			const T limit = std::log(p.scale / casts::to<T>(2)) - min;
 
-				const T v = p.scale * gaussian_like({x, y}, p.mean, p.prec);
-				p.weights(iy - bmin.y(), ix - bmin.x()) = v;
-			}
+			weights = (weights < limit).template cast<T>();
+			continue;
 		}
-	}
 
-	// sum up total
-	for (auto &p : params) {
-		if (!p.valid)
-			continue;
+		// The Gaussian without normalization, applied to the whole window in one pass.
+		weights = p.scale * ((-weights).exp() / casts::to<T>(2));
 
 		const Point bmin = p.bounds.min();
-		const Point bmax = p.bounds.max();
-
-		for (Eigen::Index y = bmin.y(); y <= bmax.y(); y++) {
-			for (Eigen::Index x = bmin.x(); x <= bmax.x(); x++)
-				total(y, x) += p.weights(y - bmin.y(), x - bmin.x());
-		}
+		total.block(bmin.y(), bmin.x(), weights.rows(), weights.cols()) += weights;
 	}
 
+	if (!overlap)
+		return;
+
 	// normalize weights
 	for (auto &p : params) {
 		if (!p.valid)
 			continue;
 
-		const Point bmin = p.bounds.min();
-		const Point bmax = p.bounds.max();
+		auto weights = p.weights.array();
 
-		for (Eigen::Index y = bmin.y(); y <= bmax.y(); y++) {
-			for (Eigen::Index x = bmin.x(); x <= bmax.x(); x++) {
-				const T t = total(y, x);
+		const Point bmin = p.bounds.min();
+		const auto t = total.block(bmin.y(), bmin.x(), weights.rows(), weights.cols());
 
-				if (t > casts::to<T>(0))
-					p.weights(y - bmin.y(), x - bmin.x()) /= t;
-			}
-		}
+		weights = (t > casts::to<T>(0)).select(weights / t, weights);
 	}
 }
 
@@ -322,6 +422,7 @@ void fit(std::vector<Parameters<typename DenseBase<Derived>::Scalar>> &params,
          const usize iterations)
 {
 	using T = typename DenseBase<Derived>::Scalar;
+	using V = common::simd::Native<T>;
 
 	const Eigen::Index cols = data.cols();
 	const Eigen::Index rows = data.rows();
@@ -349,7 +450,7 @@ void fit(std::vector<Parameters<typename DenseBase<Derived>::Scalar>> &params,
 	// perform iterations
 	for (usize i = 0; i < iterations; ++i) {
 		// update weights
-		impl::update_weight_maps(params, tmp);
+		common::cpu::dispatch([&]() { impl::update_weight_maps(params, tmp); });
 
 		// fit individual parameters
 		for (auto &p : params) {
@@ -361,7 +462,9 @@ void fit(std::vector<Parameters<typename DenseBase<Derived>::Scalar>> &params,
 				continue;
 
 			// assemble system of linear equations
-			impl::assemble_system(sys, rhs, p.bounds, data, p.weights);
+			common::cpu::dispatch([&]() {
+				impl::assemble_system<V>(sys, rhs, p.bounds, data, p.weights);
+			});
 
 			// solve systems
 			p.valid = impl::ge_solve(sys, rhs, chi);
@@ -3,26 +3,46 @@
 #ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_MAXIMAS_HPP
 #define IPTSD_CONTACTS_DETECTION_ALGORITHMS_MAXIMAS_HPP
 
+#include <common/buildopts.hpp>
+#include <common/cpu.hpp>
+#include <common/simd.hpp>
 #include <common/types.hpp>
 
+#include <algorithm>
+#include <type_traits>
 #include <vector>
 
 namespace iptsd::contacts::detection::maximas {
 
+namespace impl {
+
 /*!
- * Searches for all local maxima in the given data.
+ * Searches for local maxima in a range of rows of the given data.
+ *
+ * The pixels that have all of their neighbours inside of the image are compared one vector
+ * at a time, only the pixels at the border of the image are compared one by one.
+ *
+ * Do not call this directly, use iptsd::contacts::detection::maximas::find_rows.
  *
+ * @tparam V The vector type, @ref common::simd::Scalar gives the reference implementation.
  * @param[in] data The data to process.
  * @param[in] threshold Only return local maxima whose value is above this threshold.
- * @param[out] maximas A reference to the vector where the found points will be stored.
+ * @param[in] begin The first row that is searched.
+ * @param[in] end The row after the last row that is searched.
+ * @param[out] maximas A reference to the vector where the found points will be appended.
  */
-template <class Derived>
-void find(const DenseBase<Derived> &data,
-          typename DenseBase<Derived>::Scalar threshold,
-          std::vector<Point> &maximas)
+template <class V, class Derived>
+void find_rows(const DenseBase<Derived> &data,
+               typename DenseBase<Derived>::Scalar threshold,
+               const Eigen::Index begin,
+               const Eigen::Index end,
+               std::vector<Point> &maximas)
 {
 	using T = typename DenseBase<Derived>::Scalar;
 
+	static_assert(Derived::IsRowMajor);
+	static_assert(std::is_same_v<typename V::Type, T>);
+
 	/*
 	 * We use the following kernel to compare entries:
 	 *
@@ -38,17 +58,21 @@ void find(const DenseBase<Derived> &data,
 	const Eigen::Index cols = data.cols();
 	const Eigen::Index rows = data.rows();
 
-	maximas.clear();
+	const Eigen::Index stride = data.derived().outerStride();
 
-	for (Eigen::Index y = 0; y < rows; y++) {
+	// The first and the last pixel of a row whose neighbours are all inside of the image.
+	const Eigen::Index first = std::min(Eigen::Index {1}, cols);
+	const Eigen::Index last = std::max(first, cols - 1);
+
+	for (Eigen::Index y = begin; y < end; y++) {
 		const bool can_up = y > 0;
 		const bool can_down = y < rows - 1;
 
-		for (Eigen::Index x = 0; x < cols; x++) {
+		const auto border = [&](const Eigen::Index x) {
 			const T value = data(y, x);
 
 			if (value <= threshold)
-				continue;
+				return;
 
 			bool max = true;
 
@@ -83,10 +107,103 @@ void find(const DenseBase<Derived> &data,
 
 			if (max)
 				maximas.emplace_back(x, y);
+		};
+
+		if (!can_up || !can_down) {
+			for (Eigen::Index x = 0; x < cols; x++)
+				border(x);
+
+			continue;
 		}
+
+		const T *up = data.derived().data() + (y - 1) * stride;
+		const T *row = up + stride;
+		const T *down = row + stride;
+
+		const auto inner = [&](const auto &lanes, const Eigen::Index x) {
+			using W = std::decay_t<decltype(lanes)>;
+
+			if constexpr (common::buildopts::ForceAccessChecks)
+				eigen_assert(x - 1 >= 0 && x + 1 + W::Size <= cols);
+
+			const W value = W::load(row + x);
+			auto max = value > W::broadcast(threshold);
+
+			// Most of the image is below the threshold.
+			if (!max.any())
+				return;
+
+			max = max & (W::load(row + x - 1) < value);
+			max = max & (W::load(row + x + 1) <= value);
+
+			max = max & (W::load(up + x - 1) < value);
+			max = max & (W::load(up + x) < value);
+			max = max & (W::load(up + x + 1) <= value);
+
+			max = max & (W::load(down + x - 1) < value);
+			max = max & (W::load(down + x) <= value);
+			max = max & (W::load(down + x + 1) <= value);
+
+			for (Eigen::Index i = 0; i < W::Size; i++) {
+				if (max.test(i))
+					maximas.emplace_back(x + i, y);
+			}
+		};
+
+		for (Eigen::Index x = 0; x < first; x++)
+			border(x);
+
+		common::simd::loop<V>(first, last, inner);
+
+		for (Eigen::Index x = last; x < cols; x++)
+			border(x);
 	}
 }
 
+} // namespace impl
+
+/*!
+ * Searches for local maxima in a range of rows of the given data.
+ *
+ * The rows outside of the range are still used as neighbours, so searching all rows in
+ * multiple ranges finds the same points as searching them at once.
+ *
+ * The search is compiled for multiple instruction sets, see @ref common::cpu::dispatch.
+ *
+ * @param[in] data The data to process.
+ * @param[in] threshold Only return local maxima whose value is above this threshold.
+ * @param[in] begin The first row that is searched.
+ * @param[in] end The row after the last row that is searched.
+ * @param[out] maximas A reference to the vector where the found points will be appended.
+ */
+template <class Derived>
+void find_rows(const DenseBase<Derived> &data,
+               typename DenseBase<Derived>::Scalar threshold,
+               const Eigen::Index begin,
+               const Eigen::Index end,
+               std::vector<Point> &maximas)
+{
+	using V = common::simd::Native<typename DenseBase<Derived>::Scalar>;
+
+	common::cpu::dispatch([&]() { impl::find_rows<V>(data, threshold, begin, end, maximas); });
+}
+
+/*!
+ * Searches for all local maxima in the given data.
+ *
+ * @param[in] data The data to process.
+ * @param[in] threshold Only return local maxima whose value is above this threshold.
+ * @param[out] maximas A reference to the vector where the found points will be stored.
+ */
+template <class Derived>
+void find(const DenseBase<Derived> &data,
+          typename DenseBase<Derived>::Scalar threshold,
+          std::vector<Point> &maximas)
+{
+	maximas.clear();
+	find_rows(data, threshold, 0, data.rows(), maximas);
+}
+
 } // namespace iptsd::contacts::detection::maximas
 
 #endif // IPTSD_CONTACTS_DETECTION_ALGORITHMS_MAXIMAS_HPP
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_MOMENTS_HPP
+#define IPTSD_CONTACTS_DETECTION_ALGORITHMS_MOMENTS_HPP
+
+#include <common/buildopts.hpp>
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <gsl/gsl>
+
+#include <type_traits>
+
+namespace iptsd::contacts::detection::moments {
+
+template <class T>
+struct Parameters {
+	// Whether the cluster contained enough data to describe an ellipse.
+	bool valid = false;
+
+	// The weighted centroid of the cluster.
+	Vector2<T> mean = Vector2<T>::Zero();
+
+	// The weighted covariance of the cluster.
+	Matrix2<T> cov = Matrix2<T>::Zero();
+};
+
+namespace impl {
+
+template <class T>
+constexpr T EPS = std::is_same_v<T, f32> ? gsl::narrow_cast<T>(1E-20) : gsl::narrow_cast<T>(1E-40);
+
+} // namespace impl
+
+/*!
+ * Describes a cluster by the first and second moments of its data.
+ *
+ * The data is used as the weight of every pixel, so the mean is the weighted centroid and
+ * the covariance describes the shape of an ellipse, like the one found by gaussian fitting.
+ * This only needs one pass over the cluster, but the result is only accurate if the cluster
+ * contains a single contact that is not cut off by the edge of the heatmap.
+ *
+ * @tparam T The type that is used for the calculation.
+ * @param[in] data The data that is sampled, e.g. the blurred heatmap.
+ * @param[in] bounds The area of the data that belongs to the cluster.
+ * @return The moments of the cluster.
+ */
+template <class T, class Derived>
+Parameters<T> fit(const DenseBase<Derived> &data, const Box &bounds)
+{
+	const Point min = bounds.min();
+	const Point max = bounds.max();
+
+	// Sampling relative to the center of the cluster keeps the sums small.
+	const Vector2<T> center = bounds.cast<T>().center();
+
+	T s0 = casts::to<T>(0);
+	T sx = casts::to<T>(0);
+	T sy = casts::to<T>(0);
+	T sxx = casts::to<T>(0);
+	T sxy = casts::to<T>(0);
+	T syy = casts::to<T>(0);
+
+	for (Eigen::Index y = min.y(); y <= max.y(); y++) {
+		const T dy = casts::to<T>(y) - center.y();
+
+		T r0 = casts::to<T>(0);
+		T rx = casts::to<T>(0);
+		T rxx = casts::to<T>(0);
+
+		for (Eigen::Index x = min.x(); x <= max.x(); x++) {
+			const T dx = casts::to<T>(x) - center.x();
+
+			T w {};
+
+			if constexpr (common::buildopts::ForceAccessChecks)
+				w = casts::to<T>(data(y, x));
+			else
+				w = casts::to<T>(data.coeff(y, x));
+
+			r0 += w;
+			rx += w * dx;
+			rxx += w * dx * dx;
+		}
+
+		s0 += r0;
+		sx += rx;
+		sy += r0 * dy;
+		sxx += rxx;
+		sxy += rx * dy;
+		syy += r0 * dy * dy;
+	}
+
+	Parameters<T> p {};
+
+	if (s0 <= impl::EPS<T>)
+		return p;
+
+	const Vector2<T> mean {sx / s0, sy / s0};
+
+	p.cov(0, 0) = sxx / s0 - mean.x() * mean.x();
+	p.cov(0, 1) = sxy / s0 - mean.x() * mean.y();
+	p.cov(1, 0) = p.cov(0, 1);
+	p.cov(1, 1) = syy / s0 - mean.y() * mean.y();
+
+	p.mean = mean + center;
+	p.valid = p.cov.determinant() > impl::EPS<T>;
+
+	return p;
+}
+
+} // namespace iptsd::contacts::detection::moments
+
+#endif // IPTSD_CONTACTS_DETECTION_ALGORITHMS_MOMENTS_HPP
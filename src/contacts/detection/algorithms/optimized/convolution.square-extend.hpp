@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_OPTIMIZED_CONVOLUTION_SQUARE_EXTEND_HPP
+#define IPTSD_CONTACTS_DETECTION_ALGORITHMS_OPTIMIZED_CONVOLUTION_SQUARE_EXTEND_HPP
+
+#include <common/buildopts.hpp>
+#include <common/casts.hpp>
+#include <common/simd.hpp>
+#include <common/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+namespace iptsd::contacts::detection::convolution::impl {
+
+/*!
+ * Runs a 2D convolution of a matrix and a square kernel with a fixed size.
+ *
+ * This is the optimized implementation for 3x3 and 5x5 kernels. The pixels that have all
+ * of their neighbours inside of the image are processed one vector at a time, only the
+ * columns at the left and right border are processed one by one.
+ *
+ * Do not call this directly, use @ref iptsd::contacts::detection::convolution::run().
+ *
+ * @tparam V The vector type, @ref common::simd::Scalar gives the reference implementation.
+ * @tparam Radius How many neighbours in every direction the kernel covers.
+ * @param[in] in The input data.
+ * @param[in] kernel The kernel that is applied to the input data.
+ * @param[out] out A reference to the matrix where the results of the convolution are stored.
+ */
+template <class V, Eigen::Index Radius, class DerivedData, class DerivedKernel>
+void run_square(const DenseBase<DerivedData> &in,
+                const DenseBase<DerivedKernel> &kernel,
+                DenseBase<DerivedData> &out)
+{
+	using T = typename DenseBase<DerivedData>::Scalar;
+
+	static_assert(DerivedData::IsRowMajor);
+	static_assert(std::is_same_v<typename V::Type, T>);
+
+	constexpr Eigen::Index Size = Radius * 2 + 1;
+
+	const Eigen::Index cols = in.cols();
+	const Eigen::Index rows = in.rows();
+
+	const Eigen::Index stride = in.derived().outerStride();
+	const Eigen::Index zero = 0;
+
+	const T *data = in.derived().data();
+	T *result = out.derived().data();
+
+	// The weights of the kernel, copied out so that they can be kept in registers.
+	std::array<T, Size * Size> weights {};
+
+	for (Eigen::Index dy = 0; dy < Size; dy++) {
+		for (Eigen::Index dx = 0; dx < Size; dx++) {
+			const usize i = casts::to_unsigned(dy * Size + dx);
+
+			if constexpr (common::buildopts::ForceAccessChecks)
+				weights[i] = casts::to<T>(kernel(dy, dx));
+			else
+				weights[i] = casts::to<T>(kernel.coeff(dy, dx));
+		}
+	}
+
+	const auto k = [&](const Eigen::Index dx, const Eigen::Index dy) -> T {
+		return weights[casts::to_unsigned((dy + Radius) * Size + dx + Radius)];
+	};
+
+	// The rows above and below of the current row. Rows outside of the image are extended.
+	std::array<const T *, Size> neighbours {};
+
+	// The first and the last pixel of a row whose neighbours are all inside of the image.
+	const Eigen::Index first = std::min(Radius, cols);
+	const Eigen::Index last = std::max(first, cols - Radius);
+
+	for (Eigen::Index y = 0; y < rows; y++) {
+		for (Eigen::Index dy = -Radius; dy <= Radius; dy++) {
+			const Eigen::Index ny = std::clamp(y + dy, zero, rows - 1);
+			neighbours[casts::to_unsigned(dy + Radius)] = data + ny * stride;
+		}
+
+		T *row = result + y * out.derived().outerStride();
+
+		const auto border = [&](const Eigen::Index x) {
+			T v = casts::to<T>(0);
+
+			for (Eigen::Index dy = -Radius; dy <= Radius; dy++) {
+				const T *src = neighbours[casts::to_unsigned(dy + Radius)];
+
+				for (Eigen::Index dx = -Radius; dx <= Radius; dx++) {
+					const Eigen::Index nx = std::clamp(x + dx, zero, cols - 1);
+					v = src[nx] * k(dx, dy) + v;
+				}
+			}
+
+			row[x] = v;
+		};
+
+		const auto inner = [&](const auto &lanes, const Eigen::Index x) {
+			using W = std::decay_t<decltype(lanes)>;
+
+			if constexpr (common::buildopts::ForceAccessChecks)
+				eigen_assert(x - Radius >= 0 && x + Radius + W::Size <= cols);
+
+			W v = W::broadcast(casts::to<T>(0));
+
+			/*
+			 * The loops have to be unrolled, otherwise the accumulator can't be kept
+			 * in registers. At -O2 GCC doesn't do that by itself.
+			 */
+#pragma GCC unroll 5
+			for (Eigen::Index dy = -Radius; dy <= Radius; dy++) {
+				const T *src = neighbours[casts::to_unsigned(dy + Radius)] + x;
+
+#pragma GCC unroll 5
+				for (Eigen::Index dx = -Radius; dx <= Radius; dx++)
+					v = fma(W::load(src + dx), W::broadcast(k(dx, dy)), v);
+			}
+
+			v.store(row + x);
+		};
+
+		for (Eigen::Index x = 0; x < first; x++)
+			border(x);
+
+		common::simd::loop<V>(first, last, inner);
+
+		for (Eigen::Index x = last; x < cols; x++)
+			border(x);
+	}
+}
+
+} // namespace iptsd::contacts::detection::convolution::impl
+
+#endif // IPTSD_CONTACTS_DETECTION_ALGORITHMS_OPTIMIZED_CONVOLUTION_SQUARE_EXTEND_HPP
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CONTACTS_DETECTION_ALGORITHMS_PYRAMID_HPP
+#define IPTSD_CONTACTS_DETECTION_ALGORITHMS_PYRAMID_HPP
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <algorithm>
+
+namespace iptsd::contacts::detection::pyramid {
+
+/*!
+ * Subtracts the neutral value from a heatmap and reduces it to half of its resolution.
+ *
+ * Every pixel of the output is the average of a 2x2 block of the input. If the input has
+ * an odd size, the last row or column is repeated. Averaging acts as a light blur, so the
+ * output can be searched for maximas and clusters directly.
+ *
+ * @param[in] in The heatmap to downsample.
+ * @param[in] neutral The neutral value of the heatmap.
+ * @param[out] out The downsampled heatmap.
+ */
+template <class Derived, class DerivedOut>
+void downsample(const DenseBase<Derived> &in,
+                const typename DenseBase<Derived>::Scalar neutral,
+                DenseBase<DerivedOut> &out)
+{
+	using T = typename DenseBase<Derived>::Scalar;
+
+	const Eigen::Index cols = in.cols();
+	const Eigen::Index rows = in.rows();
+
+	const Eigen::Index ocols = out.cols();
+	const Eigen::Index orows = out.rows();
+
+	const T zero = casts::to<T>(0);
+	const T quarter = casts::to<T>(1) / casts::to<T>(4);
+
+	for (Eigen::Index y = 0; y < orows; y++) {
+		const Eigen::Index y0 = y * 2;
+		const Eigen::Index y1 = std::min(y0 + 1, rows - 1);
+
+		for (Eigen::Index x = 0; x < ocols; x++) {
+			const Eigen::Index x0 = x * 2;
+			const Eigen::Index x1 = std::min(x0 + 1, cols - 1);
+
+			const T sum = in(y0, x0) + in(y0, x1) + in(y1, x0) + in(y1, x1);
+			out(y, x) = std::max(sum * quarter - neutral, zero);
+		}
+	}
+}
+
+/*!
+ * Calculates the size of a heatmap after downsampling.
+ *
+ * @param[in] size The size of the full resolution heatmap.
+ * @return The size of the downsampled heatmap.
+ */
+inline Eigen::Index reduce(const Eigen::Index size)
+{
+	return (size + 1) / 2;
+}
+
+/*!
+ * Converts a box on the downsampled heatmap to the full resolution heatmap.
+ *
+ * @param[in] box The box on the downsampled heatmap.
+ * @param[in] dimensions The largest valid coordinates of the full resolution heatmap.
+ * @return The area of the full resolution heatmap that is covered by the box.
+ */
+inline Box expand(const Box &box, const Vector2<Eigen::Index> &dimensions)
+{
+	const Vector2<Eigen::Index> one = Vector2<Eigen::Index>::Ones();
+
+	const Vector2<Eigen::Index> min = box.min() * 2;
+	const Vector2<Eigen::Index> max = box.max() * 2 + one;
+
+	return Box {min.cwiseMax(0), max.cwiseMin(dimensions)};
+}
+
+} // namespace iptsd::contacts::detection::pyramid
+
+#endif // IPTSD_CONTACTS_DETECTION_ALGORITHMS_PYRAMID_HPP
@@ -8,8 +8,21 @@
 #include <common/casts.hpp>
 #include <common/types.hpp>
 
+#include <optional>
+
 namespace iptsd::contacts::detection {
 
+enum class Engine : u8 {
+	// Fits a gaussian distribution onto every cluster.
+	GAUSSIAN,
+
+	// Calculates the weighted centroid and covariance of every cluster.
+	MOMENTS,
+
+	// Uses the moments, and only fits clusters that could contain multiple contacts.
+	HYBRID,
+};
+
 template <class T>
 struct Config {
 public:
@@ -49,6 +62,24 @@ public:
 	 * the recursive cluster search will stop once it reaches it.
 	 */
 	T deactivation_threshold = casts::to<T>(20);
+
+	/*
+	 * If the heatmap has more pixels than this, maximas and clusters are searched in a
+	 * heatmap with half of the resolution. Only the areas around the found clusters are
+	 * processed in full resolution.
+	 */
+	std::optional<usize> pyramid_threshold = std::nullopt;
+
+	/*
+	 * If the processed heatmap has more pixels than this, it is split into horizontal bands
+	 * that are preprocessed on multiple threads. The found contacts are the same.
+	 */
+	std::optional<usize> parallel_threshold = std::nullopt;
+
+	/*
+	 * How the position, size and orientation of the contacts are calculated from the clusters.
+	 */
+	Engine engine = Engine::GAUSSIAN;
 };
 
 } // namespace iptsd::contacts::detection
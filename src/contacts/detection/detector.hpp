@@ -10,16 +10,22 @@
 #include "algorithms/gaussian.hpp"
 #include "algorithms/kernels.hpp"
 #include "algorithms/maximas.hpp"
+#include "algorithms/moments.hpp"
 #include "algorithms/neutral.hpp"
 #include "algorithms/overlaps.hpp"
+#include "algorithms/pyramid.hpp"
 #include "config.hpp"
 
 #include <common/casts.hpp>
+#include <common/thread-pool.hpp>
 #include <common/types.hpp>
 
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -31,6 +37,33 @@ public:
 	static_assert(std::is_floating_point_v<T>);
 	static_assert(std::is_floating_point_v<TFit>);
 
+	// Bands with less rows than this are not worth the synchronization between threads.
+	static constexpr Eigen::Index MIN_BAND_ROWS = 8;
+
+	// Bands with less pixels than this are not worth the synchronization between threads.
+	static constexpr usize MIN_BAND_PIXELS = 2048;
+
+private:
+	/*
+	 * A horizontal band of the heatmap that is processed on its own thread.
+	 */
+	struct Band {
+		// The first row of the band.
+		Eigen::Index begin = 0;
+
+		// The row after the last row of the band.
+		Eigen::Index end = 0;
+
+		// The rows of the band and their neighbours, with the neutral value subtracted.
+		Image<T> neutral {};
+
+		// The rows of the band and their neighbours, blurred.
+		Image<T> blurred {};
+
+		// The local maximas inside of the band.
+		std::vector<Point> maximas {};
+	};
+
 private:
 	Config<T> m_config;
 
@@ -43,6 +76,15 @@ private:
 	// The blurred heatmap.
 	Image<T> m_img_blurred {};
 
+	// The heatmap at half resolution, with the neutral value subtracted.
+	Image<T> m_img_coarse {};
+
+	// A region of the heatmap with the neutral value subtracted.
+	Image<T> m_roi_neutral {};
+
+	// A blurred region of the heatmap.
+	Image<T> m_roi_blurred {};
+
 	// The kernel that is used for blurring.
 	Matrix3<T> m_kernel_blur = kernels::gaussian<T, 3, 3>(gsl::narrow_cast<T>(0.75));
 
@@ -61,12 +103,27 @@ private:
 	// Temporary storage for gaussian fitting.
 	Image<TFit> m_fitting_temp {};
 
+	// The shape of every cluster, from either of the detection engines.
+	std::vector<moments::Parameters<TFit>> m_shapes {};
+
+	// The clusters that are described by the gaussian fitting parameters.
+	std::vector<usize> m_fitted {};
+
 	// How many frames are left before the neutral value has to be recalculated.
 	usize m_counter = 0;
 
 	// The cached neutral value of the heatmap.
+	T m_cached_neutral = casts::to<T>(0);
+
+	// The neutral value of the heatmap that is being processed.
 	T m_neutral = casts::to<T>(0);
 
+	// The bands that the heatmap is split into.
+	std::vector<Band> m_bands {};
+
+	// The threads that process the bands. Only created once a heatmap is large enough.
+	std::unique_ptr<common::ThreadPool> m_pool = nullptr;
+
 public:
 	Detector(Config<T> config) : m_config {std::move(config)} {};
 
@@ -75,13 +132,57 @@ public:
 	 *
 	 * This function uses a threshold based recursive descent to build
 	 * a list of connected clusters based on the (pre-processed) heatmap,
-	 * and then uses gaussian fitting to fit an ellipse onto these clusters.
+	 * and then describes these clusters as ellipses, using the configured engine.
 	 *
 	 * @param[in] heatmap The heatmap to process.
 	 * @param[out] contacts The list of detected contacts.
 	 */
 	template <int Rows, int Cols>
 	void detect(const ImageBase<T, Rows, Cols> &heatmap, std::vector<Contact<T>> &contacts)
+	{
+		const T neutral = this->update_neutral(heatmap);
+		this->detect(heatmap, neutral, contacts);
+	}
+
+	/*!
+	 * Determines the neutral value of the next heatmap.
+	 *
+	 * Calculating the neutral value is expensive, so it is only done every few heatmaps.
+	 * In between, the cached value is returned. Call this for every heatmap, in order.
+	 *
+	 * @param[in] heatmap The next heatmap.
+	 * @return The neutral value that should be used for the heatmap.
+	 */
+	template <int Rows, int Cols>
+	T update_neutral(const ImageBase<T, Rows, Cols> &heatmap)
+	{
+		// Recalculate the neutral value if neccessary
+		if (m_counter == 0) {
+			m_cached_neutral = neutral::calculate(heatmap,
+			                                      m_config.neutral_value_algorithm,
+			                                      m_config.neutral_value_offset);
+		}
+
+		// Update counter
+		m_counter = (m_counter + 1) % m_config.neutral_value_backoff;
+
+		return m_cached_neutral;
+	}
+
+	/*!
+	 * Search for contacts in a capacitive heatmap with a known neutral value.
+	 *
+	 * This does not depend on previous heatmaps, so multiple detectors can process
+	 * the heatmaps of a recording in any order.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 * @param[in] neutral The neutral value of the heatmap, see @ref update_neutral.
+	 * @param[out] contacts The list of detected contacts.
+	 */
+	template <int Rows, int Cols>
+	void detect(const ImageBase<T, Rows, Cols> &heatmap,
+	            const T neutral,
+	            std::vector<Contact<T>> &contacts)
 	{
 		const Vector2<Eigen::Index> one = Vector2<Eigen::Index>::Ones();
 
@@ -106,55 +207,44 @@ public:
 		contacts.clear();
 		m_clusters.clear();
 		m_fitting_params.clear();
+		m_shapes.clear();
+		m_fitted.clear();
 
-		// Recalculate the neutral value if neccessary
-		if (m_counter == 0) {
-			m_neutral = neutral::calculate(heatmap,
-			                               m_config.neutral_value_algorithm,
-			                               m_config.neutral_value_offset);
-		}
-
-		// Update counter
-		m_counter = (m_counter + 1) % m_config.neutral_value_backoff;
-
-		// Subtract the neutral value from the whole heatmap
-		m_img_neutral = (heatmap - m_neutral).max(casts::to<T>(0));
-
-		// Blur the heatmap slightly
-		convolution::run(m_img_neutral, m_kernel_blur, m_img_blurred);
+		m_neutral = neutral;
 
-		const T athresh = m_config.activation_threshold;
-		const T dthresh = m_config.deactivation_threshold;
+		const usize pixels = casts::to_unsigned(rows * cols);
+		const auto &threshold = m_config.pyramid_threshold;
 
-		// Search for local maximas
-		maximas::find(m_img_blurred, athresh, m_maximas);
+		// Large heatmaps are searched at half of the resolution.
+		const bool pyramid = threshold.has_value() && pixels > threshold.value();
 
-		// Iterate over the maximas and start building clusters
-		for (const Point &point : m_maximas) {
-			Box cluster = cluster::span(m_img_blurred, point, athresh, dthresh);
+		if (pyramid)
+			this->search_coarse(heatmap);
+		else
+			this->search(heatmap);
 
-			if (cluster.isEmpty())
-				continue;
+		// Merge overlapping clusters
+		overlaps::merge(m_clusters, m_clusters_temp, 5);
 
-			// Extend the sides of the cluster by one pixel
-			cluster.min() = (cluster.min() - one).cwiseMax(0);
-			cluster.max() = (cluster.max() + one).cwiseMin(dimensions);
+		/*
+		 * If the heatmap was searched at half of the resolution, the blurred image at full
+		 * resolution does not exist yet. Only the areas around the clusters are blurred,
+		 * because the moments and the fitting below don't read anything else.
+		 */
+		if (pyramid) {
+			for (const Box &cluster : m_clusters)
+				this->blur_region(heatmap, cluster);
+		}
 
-			// min() and max() are inclusive so we need to add one
-			const Vector2<Eigen::Index> size = cluster.sizes() + one;
+		// Prepare clusters for gaussian fitting, or describe them by their moments
+		for (usize i = 0; i < m_clusters.size(); i++) {
+			const Box &cluster = m_clusters[i];
 
-			// For gaussian fitting, the clusters should have at least 3x3 pixels
-			if (size.x() < 3 || size.y() < 3)
+			if (!this->needs_fitting(cluster, dimensions, pyramid)) {
+				m_shapes.push_back(moments::fit<TFit>(m_img_blurred, cluster));
 				continue;
+			}
 
-			m_clusters.push_back(std::move(cluster));
-		}
-
-		// Merge overlapping clusters
-		overlaps::merge(m_clusters, m_clusters_temp, 5);
-
-		// Prepare clusters for gaussian fitting
-		for (const Box &cluster : m_clusters) {
 			const Vector2<TFit> mean = cluster.cast<TFit>().center();
 			const Matrix2<TFit> prec = Matrix2<TFit>::Identity();
 
@@ -171,20 +261,32 @@ public:
 			};
 
 			m_fitting_params.push_back(std::move(params));
+			m_fitted.push_back(i);
+			m_shapes.emplace_back();
 		}
 
 		// Run gaussian fitting
 		gaussian::fit(m_fitting_params, m_img_blurred, m_fitting_temp, 3);
 
-		// Create a contact from every gaussian fitting parameter
-		for (const auto &p : m_fitting_params) {
+		for (usize i = 0; i < m_fitting_params.size(); i++) {
+			const gaussian::Parameters<TFit> &p = m_fitting_params[i];
+			moments::Parameters<TFit> &shape = m_shapes[m_fitted[i]];
+
 			if (!p.valid)
 				continue;
 
-			const Matrix2<TFit> cov = p.prec.inverse();
+			shape.valid = true;
+			shape.mean = p.mean;
+			shape.cov = p.prec.inverse();
+		}
+
+		// Create a contact from the shape of every cluster
+		for (const moments::Parameters<TFit> &p : m_shapes) {
+			if (!p.valid)
+				continue;
 
 			Eigen::SelfAdjointEigenSolver<Matrix2<TFit>> solver {};
-			solver.computeDirect(cov);
+			solver.computeDirect(p.cov);
 
 			Vector2<TFit> mean = p.mean;
 			Vector2<TFit> size = ellipse::size(solver.eigenvalues());
@@ -203,6 +305,333 @@ public:
 			                               m_config.normalize});
 		}
 	}
+
+private:
+	/*!
+	 * Searches for clusters in the full resolution heatmap.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 */
+	template <int Rows, int Cols>
+	void search(const ImageBase<T, Rows, Cols> &heatmap)
+	{
+		const T athresh = m_config.activation_threshold;
+		const T dthresh = m_config.deactivation_threshold;
+
+		const usize bands = this->split(heatmap.rows(), heatmap.cols());
+
+		if (bands > 1) {
+			this->run_bands(bands, [&](Band &band) { this->blur_band(heatmap, band); });
+			this->find_maximas(bands, m_img_blurred);
+		} else {
+			// Subtract the neutral value from the whole heatmap
+			m_img_neutral = (heatmap - m_neutral).max(casts::to<T>(0));
+
+			// Blur the heatmap slightly
+			convolution::run(m_img_neutral, m_kernel_blur, m_img_blurred);
+
+			// Search for local maximas
+			maximas::find(m_img_blurred, athresh, m_maximas);
+		}
+
+		const Vector2<Eigen::Index> dimensions {heatmap.cols() - 1, heatmap.rows() - 1};
+
+		// Iterate over the maximas and start building clusters
+		for (const Point &point : m_maximas) {
+			const Box cluster = cluster::span(m_img_blurred, point, athresh, dthresh);
+
+			if (cluster.isEmpty())
+				continue;
+
+			this->add_cluster(cluster, dimensions);
+		}
+	}
+
+	/*!
+	 * Searches for clusters in a heatmap with half of the resolution.
+	 *
+	 * Finding maximas and spanning clusters touches every pixel, which gets expensive
+	 * for large heatmaps. Instead, this is done at half of the resolution, and the
+	 * found clusters are scaled up to the full resolution.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 */
+	template <int Rows, int Cols>
+	void search_coarse(const ImageBase<T, Rows, Cols> &heatmap)
+	{
+		const Eigen::Index rows = pyramid::reduce(heatmap.rows());
+		const Eigen::Index cols = pyramid::reduce(heatmap.cols());
+
+		if (m_img_coarse.rows() != rows || m_img_coarse.cols() != cols)
+			m_img_coarse.conservativeResize(rows, cols);
+
+		const T athresh = m_config.activation_threshold;
+		const T dthresh = m_config.deactivation_threshold;
+
+		const usize bands = this->split(rows, cols);
+
+		if (bands > 1) {
+			this->run_bands(bands, [&](Band &band) {
+				this->downsample_band(heatmap, band);
+			});
+
+			this->find_maximas(bands, m_img_coarse);
+		} else {
+			pyramid::downsample(heatmap, m_neutral, m_img_coarse);
+
+			// Search for local maximas
+			maximas::find(m_img_coarse, athresh, m_maximas);
+		}
+
+		const Vector2<Eigen::Index> dimensions {heatmap.cols() - 1, heatmap.rows() - 1};
+
+		// Iterate over the maximas and start building clusters
+		for (const Point &point : m_maximas) {
+			const Box cluster = cluster::span(m_img_coarse, point, athresh, dthresh);
+
+			if (cluster.isEmpty())
+				continue;
+
+			this->add_cluster(pyramid::expand(cluster, dimensions), dimensions);
+		}
+	}
+
+	/*!
+	 * Splits an image into horizontal bands that can be processed in parallel.
+	 *
+	 * The number of bands depends on the size of the image and the number of CPU cores.
+	 * Images below the configured threshold are not split.
+	 *
+	 * @param[in] rows The number of rows of the image.
+	 * @param[in] cols The number of columns of the image.
+	 * @return The number of bands. If it is one, the image should be processed serially.
+	 */
+	usize split(const Eigen::Index rows, const Eigen::Index cols)
+	{
+		const usize pixels = casts::to_unsigned(rows * cols);
+		const auto &threshold = m_config.parallel_threshold;
+
+		if (!threshold.has_value() || pixels <= threshold.value())
+			return 1;
+
+		if (!m_pool) {
+			const usize cores = std::thread::hardware_concurrency();
+			m_pool = std::make_unique<common::ThreadPool>(std::max(cores, usize {1}));
+		}
+
+		const usize by_rows = casts::to_unsigned(rows / MIN_BAND_ROWS);
+		const usize by_pixels = pixels / MIN_BAND_PIXELS;
+
+		const usize count = std::min({m_pool->size(), by_rows, by_pixels});
+
+		if (count <= 1)
+			return 1;
+
+		if (m_bands.size() < count)
+			m_bands.resize(count);
+
+		const Eigen::Index n = casts::to_eigen(count);
+
+		// Spread the rows evenly over the bands.
+		for (Eigen::Index i = 0; i < n; i++) {
+			Band &band = m_bands[casts::to_unsigned(i)];
+
+			band.begin = i * rows / n;
+			band.end = (i + 1) * rows / n;
+		}
+
+		return count;
+	}
+
+	/*!
+	 * Processes the first bands on the thread pool, and waits until all are done.
+	 *
+	 * @param[in] count The number of bands.
+	 * @param[in] func The function that processes one band.
+	 */
+	template <class Func>
+	void run_bands(const usize count, const Func &func)
+	{
+		m_pool->run(count, [&](const usize i) { func(m_bands[i]); });
+	}
+
+	/*!
+	 * Searches for local maximas in all bands, and merges them in the order of the rows.
+	 *
+	 * This finds the same maximas in the same order as searching the whole image at once.
+	 *
+	 * @param[in] count The number of bands.
+	 * @param[in] image The image to search.
+	 */
+	void find_maximas(const usize count, const Image<T> &image)
+	{
+		const T athresh = m_config.activation_threshold;
+
+		this->run_bands(count, [&](Band &band) {
+			band.maximas.clear();
+			maximas::find_rows(image, athresh, band.begin, band.end, band.maximas);
+		});
+
+		m_maximas.clear();
+
+		for (usize i = 0; i < count; i++) {
+			const std::vector<Point> &found = m_bands[i].maximas;
+			m_maximas.insert(m_maximas.end(), found.begin(), found.end());
+		}
+	}
+
+	/*!
+	 * Subtracts the neutral value from one band of the heatmap and blurs it.
+	 *
+	 * The band is processed together with one row above and below it, so that the blur sees
+	 * the same pixels as when blurring the whole heatmap. Only the rows of the band itself
+	 * are written to the blurred heatmap.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 * @param[in,out] band The band to process.
+	 */
+	template <int Rows, int Cols>
+	void blur_band(const ImageBase<T, Rows, Cols> &heatmap, Band &band)
+	{
+		const Eigen::Index top = std::max<Eigen::Index>(band.begin - 1, 0);
+		const Eigen::Index bottom = std::min(band.end + 1, heatmap.rows());
+
+		const Eigen::Index rows = bottom - top;
+		const Eigen::Index inner = band.end - band.begin;
+
+		band.blurred.resize(rows, heatmap.cols());
+		band.neutral = (heatmap.middleRows(top, rows) - m_neutral).max(casts::to<T>(0));
+
+		convolution::run(band.neutral, m_kernel_blur, band.blurred);
+
+		// Every band writes to different rows, so this is safe to do from multiple threads.
+		m_img_blurred.middleRows(band.begin, inner) =
+			band.blurred.middleRows(band.begin - top, inner);
+	}
+
+	/*!
+	 * Downsamples one band of the heatmap.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 * @param[in,out] band The band of the downsampled heatmap that is written.
+	 */
+	template <int Rows, int Cols>
+	void downsample_band(const ImageBase<T, Rows, Cols> &heatmap, Band &band)
+	{
+		const Eigen::Index top = band.begin * 2;
+		const Eigen::Index bottom = std::min(band.end * 2, heatmap.rows());
+
+		// Every band writes to different rows, so this is safe to do from multiple threads.
+		auto out = m_img_coarse.middleRows(band.begin, band.end - band.begin);
+
+		pyramid::downsample(heatmap.middleRows(top, bottom - top), m_neutral, out);
+	}
+
+	/*!
+	 * Extends a cluster and adds it to the list of clusters, if it is large enough.
+	 *
+	 * @param[in] cluster The cluster to add.
+	 * @param[in] dimensions The largest valid coordinates of the heatmap.
+	 */
+	void add_cluster(Box cluster, const Vector2<Eigen::Index> &dimensions)
+	{
+		const Vector2<Eigen::Index> one = Vector2<Eigen::Index>::Ones();
+
+		// Extend the sides of the cluster by one pixel
+		cluster.min() = (cluster.min() - one).cwiseMax(0);
+		cluster.max() = (cluster.max() + one).cwiseMin(dimensions);
+
+		// min() and max() are inclusive so we need to add one
+		const Vector2<Eigen::Index> size = cluster.sizes() + one;
+
+		// For gaussian fitting, the clusters should have at least 3x3 pixels
+		if (size.x() < 3 || size.y() < 3)
+			return;
+
+		m_clusters.push_back(std::move(cluster));
+	}
+
+	/*!
+	 * Checks if a cluster has to be processed with gaussian fitting.
+	 *
+	 * The hybrid engine only fits clusters that could contain more than one contact, or whose
+	 * contact could be cut off by the edge of the heatmap. Clusters that were merged always
+	 * contain multiple maximas, because every cluster is spanned from a different maxima.
+	 * For all other clusters, the moments are close enough to the fitted distribution.
+	 *
+	 * @param[in] cluster The cluster to check.
+	 * @param[in] dimensions The largest valid coordinates of the heatmap.
+	 * @param[in] pyramid Whether the maximas were searched at half of the resolution.
+	 * @return Whether the cluster should be processed with gaussian fitting.
+	 */
+	[[nodiscard]] bool needs_fitting(const Box &cluster,
+	                                 const Vector2<Eigen::Index> &dimensions,
+	                                 const bool pyramid) const
+	{
+		switch (m_config.engine) {
+		case Engine::GAUSSIAN:
+			return true;
+		case Engine::MOMENTS:
+			return false;
+		case Engine::HYBRID:
+			break;
+		}
+
+		const bool min_edge = (cluster.min().array() == 0).any();
+		const bool max_edge = (cluster.max().array() == dimensions.array()).any();
+
+		if (min_edge || max_edge)
+			return true;
+
+		usize count = 0;
+
+		for (const Point &point : m_maximas) {
+			const Point p = pyramid ? Point {point * 2} : point;
+
+			if (cluster.contains(p))
+				count++;
+
+			if (count > 1)
+				return true;
+		}
+
+		return false;
+	}
+
+	/*!
+	 * Subtracts the neutral value from a region of the heatmap and blurs it.
+	 *
+	 * The result is stored in the same region of the blurred heatmap, which is identical
+	 * to blurring the whole heatmap and only looking at that region.
+	 *
+	 * @param[in] heatmap The heatmap to process.
+	 * @param[in] region The region of the heatmap that will be blurred.
+	 */
+	template <int Rows, int Cols>
+	void blur_region(const ImageBase<T, Rows, Cols> &heatmap, const Box &region)
+	{
+		const Vector2<Eigen::Index> one = Vector2<Eigen::Index>::Ones();
+		const Vector2<Eigen::Index> dimensions {heatmap.cols() - 1, heatmap.rows() - 1};
+
+		// Include the neighbours of the region, so the blur sees the same pixels.
+		const Point min = (region.min() - one).cwiseMax(0);
+		const Point max = (region.max() + one).cwiseMin(dimensions);
+
+		const Point size = max - min + one;
+		const Point offset = region.min() - min;
+		const Point inner = region.sizes() + one;
+
+		m_roi_neutral.resize(size.y(), size.x());
+		m_roi_blurred.resize(size.y(), size.x());
+
+		const auto block = heatmap.block(min.y(), min.x(), size.y(), size.x());
+		m_roi_neutral = (block - m_neutral).max(casts::to<T>(0));
+
+		convolution::run(m_roi_neutral, m_kernel_blur, m_roi_blurred);
+
+		m_img_blurred.block(region.min().y(), region.min().x(), inner.y(), inner.x()) =
+			m_roi_blurred.block(offset.y(), offset.x(), inner.y(), inner.x());
+	}
 };
 
 } // namespace iptsd::contacts::detection
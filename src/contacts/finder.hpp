@@ -10,8 +10,16 @@
 #include "tracking/tracker.hpp"
 #include "validation/validator.hpp"
 
+#include <common/thread-pool.hpp>
 #include <common/types.hpp>
 
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -36,11 +44,27 @@ private:
 	// Validates size and aspect ratio of contacts.
 	validation::Validator<T> m_validator;
 
+	// The configuration of the detectors that process batches on multiple threads.
+	detection::Config<T> m_batch_config;
+
+	// One detector for every thread that processes batches.
+	std::vector<detection::Detector<T, TFit>> m_batch_detectors {};
+
+	// The threads that process batches. Only created once a batch is processed.
+	std::unique_ptr<common::ThreadPool> m_batch_pool = nullptr;
+
+	// The neutral value of every heatmap in the current batch.
+	std::vector<T> m_batch_neutrals {};
+
+	// The exception that every thread of the current batch stopped with, if any.
+	std::vector<std::exception_ptr> m_batch_errors {};
+
 public:
 	Finder(Config<T> config)
 		: m_detector {config.detection},
 		  m_stabilizer {config.stability},
-		  m_validator {config.validation} {};
+		  m_validator {config.validation},
+		  m_batch_config {without_parallel(config.detection)} {};
 
 	/*!
 	 * Resets the contact finder by clearing all stored previous frames.
@@ -72,6 +96,87 @@ public:
 		m_stabilizer.stabilize(contacts);
 		m_validator.validate(contacts);
 	}
+
+	/*!
+	 * Extracts contacts from many consecutive capacitive heatmaps.
+	 *
+	 * The result is the same as calling @ref find for every heatmap in order, but it is
+	 * faster when processing recordings. Detection does not depend on previous heatmaps,
+	 * so the heatmaps are distributed over multiple threads. Tracking, stabilization and
+	 * validation do, so they run afterwards, one heatmap after the other.
+	 *
+	 * @param[in] heatmaps The capacitive heatmaps to process, in the order they were received.
+	 * @param[out] contacts The list of found contacts for every heatmap.
+	 */
+	void find_batch(const gsl::span<const Image<T>> heatmaps,
+	                std::vector<std::vector<Contact<T>>> &contacts)
+	{
+		const usize size = heatmaps.size();
+
+		contacts.resize(size);
+		m_batch_neutrals.resize(size);
+
+		// The neutral value is cached over multiple heatmaps, so it is determined in order.
+		for (usize i = 0; i < size; i++)
+			m_batch_neutrals[i] = m_detector.update_neutral(heatmaps[i]);
+
+		if (!m_batch_pool) {
+			const usize cores = std::max(std::thread::hardware_concurrency(), 1U);
+
+			m_batch_pool = std::make_unique<common::ThreadPool>(cores);
+
+			for (usize i = 0; i < cores; i++)
+				m_batch_detectors.emplace_back(m_batch_config);
+		}
+
+		const usize threads = std::min(m_batch_pool->size(), size);
+
+		m_batch_errors.assign(threads, nullptr);
+
+		// Every thread processes a consecutive range of heatmaps with its own detector.
+		m_batch_pool->run(threads, [&](const usize thread) {
+			detection::Detector<T, TFit> &detector = m_batch_detectors[thread];
+
+			const usize begin = thread * size / threads;
+			const usize end = (thread + 1) * size / threads;
+
+			// Tasks of the pool must not throw, so errors are passed on to the caller.
+			try {
+				for (usize i = begin; i < end; i++) {
+					const T neutral = m_batch_neutrals[i];
+					detector.detect(heatmaps[i], neutral, contacts[i]);
+				}
+			} catch (...) {
+				m_batch_errors[thread] = std::current_exception();
+			}
+		});
+
+		for (const std::exception_ptr &error : m_batch_errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		for (std::vector<Contact<T>> &frame : contacts) {
+			m_tracker.track(frame);
+			m_stabilizer.stabilize(frame);
+			m_validator.validate(frame);
+		}
+	}
+
+private:
+	/*!
+	 * Creates a detection configuration that processes every heatmap on a single thread.
+	 *
+	 * When processing batches, the heatmaps are already distributed over all threads.
+	 *
+	 * @param[in] config The configuration of the detector.
+	 * @return A copy of the configuration without parallel preprocessing.
+	 */
+	static detection::Config<T> without_parallel(detection::Config<T> config)
+	{
+		config.parallel_threshold = std::nullopt;
+		return config;
+	}
 };
 
 } // namespace iptsd::contacts
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CONTACTS_FRAME_HPP
+#define IPTSD_CONTACTS_FRAME_HPP
+
+#include "contact.hpp"
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace iptsd::contacts {
+
+/*
+ * The contacts of a frame, stored as a structure of arrays.
+ *
+ * Every property is stored in its own contiguous array, so that the processing stages
+ * can operate on all contacts of the frame at once instead of one contact after the other.
+ * Flags and optional values are stored as masks with one entry per contact.
+ *
+ * The arrays only grow, so storing a new frame usually doesn't allocate.
+ */
+template <class T>
+class ContactFrame {
+public:
+	static_assert(std::is_floating_point_v<T>);
+
+private:
+	// The number of contacts in the frame.
+	usize m_size = 0;
+
+	// The center position of the contacts.
+	Array<T> m_mean_x {};
+	Array<T> m_mean_y {};
+
+	// The size of the contacts.
+	Array<T> m_size_x {};
+	Array<T> m_size_y {};
+
+	// The orientation of the contacts.
+	Array<T> m_orientation {};
+
+	// The tracking index of the contacts. Only set where m_has_index is true.
+	Array<usize> m_index {};
+
+	// Whether the values of a contact are normalized.
+	Array<bool> m_normalized {};
+
+	// Whether a contact has a tracking index.
+	Array<bool> m_has_index {};
+
+	// Whether a contact is valid. Only set where m_has_valid is true.
+	Array<bool> m_valid {};
+	Array<bool> m_has_valid {};
+
+	// Whether a contact is stable. Only set where m_has_stable is true.
+	Array<bool> m_stable {};
+	Array<bool> m_has_stable {};
+
+public:
+	/*!
+	 * The number of contacts in the frame.
+	 */
+	[[nodiscard]] usize size() const
+	{
+		return m_size;
+	}
+
+	/*!
+	 * Whether the frame contains no contacts.
+	 */
+	[[nodiscard]] bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	/*!
+	 * Removes all contacts from the frame.
+	 */
+	void clear()
+	{
+		m_size = 0;
+	}
+
+	/*!
+	 * Replaces the contents of the frame with a list of contacts.
+	 *
+	 * @param[in] contacts The contacts to store.
+	 */
+	void assign(const std::vector<Contact<T>> &contacts)
+	{
+		this->reserve(contacts.size());
+		m_size = contacts.size();
+
+		for (Eigen::Index i = 0; i < casts::to_eigen(m_size); i++) {
+			const Contact<T> &contact = contacts[casts::to_unsigned(i)];
+
+			m_mean_x(i) = contact.mean.x();
+			m_mean_y(i) = contact.mean.y();
+			m_size_x(i) = contact.size.x();
+			m_size_y(i) = contact.size.y();
+			m_orientation(i) = contact.orientation;
+			m_normalized(i) = contact.normalized;
+
+			m_has_index(i) = contact.index.has_value();
+			m_index(i) = contact.index.value_or(0);
+
+			m_has_valid(i) = contact.valid.has_value();
+			m_valid(i) = contact.valid.value_or(false);
+
+			m_has_stable(i) = contact.stable.has_value();
+			m_stable(i) = contact.stable.value_or(false);
+		}
+	}
+
+	/*!
+	 * Returns a copy of a single contact.
+	 *
+	 * This allows using the frame with code that operates on @ref Contact objects.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @return The contact at the given position.
+	 */
+	[[nodiscard]] Contact<T> contact(const usize i) const
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		Contact<T> contact {};
+		contact.mean = Vector2<T> {m_mean_x(n), m_mean_y(n)};
+		contact.size = Vector2<T> {m_size_x(n), m_size_y(n)};
+		contact.orientation = m_orientation(n);
+		contact.normalized = m_normalized(n);
+		contact.index = this->index(i);
+		contact.valid = this->valid(i);
+		contact.stable = this->stable(i);
+
+		return contact;
+	}
+
+	/*!
+	 * Searches for a contact by its tracking index.
+	 *
+	 * @param[in] index The tracking index of the contact.
+	 * @return The position of the contact in the frame, or nothing if it doesn't exist.
+	 */
+	[[nodiscard]] std::optional<usize> find(const usize index) const
+	{
+		for (Eigen::Index i = 0; i < casts::to_eigen(m_size); i++) {
+			if (m_has_index(i) && m_index(i) == index)
+				return casts::to_unsigned(i);
+		}
+
+		return std::nullopt;
+	}
+
+	/*!
+	 * The x coordinates of the center positions of all contacts.
+	 */
+	[[nodiscard]] auto mean_x() const
+	{
+		return m_mean_x.head(casts::to_eigen(m_size));
+	}
+
+	/*!
+	 * The y coordinates of the center positions of all contacts.
+	 */
+	[[nodiscard]] auto mean_y() const
+	{
+		return m_mean_y.head(casts::to_eigen(m_size));
+	}
+
+	/*!
+	 * The first component of the size of all contacts.
+	 */
+	[[nodiscard]] auto size_x() const
+	{
+		return m_size_x.head(casts::to_eigen(m_size));
+	}
+
+	/*!
+	 * The second component of the size of all contacts.
+	 */
+	[[nodiscard]] auto size_y() const
+	{
+		return m_size_y.head(casts::to_eigen(m_size));
+	}
+
+	/*!
+	 * The orientation of all contacts.
+	 */
+	[[nodiscard]] auto orientation() const
+	{
+		return m_orientation.head(casts::to_eigen(m_size));
+	}
+
+	/*!
+	 * The tracking index of a contact.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @return The tracking index, or nothing if the contact is not tracked.
+	 */
+	[[nodiscard]] std::optional<usize> index(const usize i) const
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		if (!m_has_index(n))
+			return std::nullopt;
+
+		return m_index(n);
+	}
+
+	/*!
+	 * Changes the tracking index of a contact.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @param[in] index The new tracking index.
+	 */
+	void set_index(const usize i, const std::optional<usize> index)
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		m_has_index(n) = index.has_value();
+		m_index(n) = index.value_or(0);
+	}
+
+	/*!
+	 * Whether a contact is valid.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @return Whether the contact is valid, or nothing if it was not validated.
+	 */
+	[[nodiscard]] std::optional<bool> valid(const usize i) const
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		if (!m_has_valid(n))
+			return std::nullopt;
+
+		return m_valid(n);
+	}
+
+	/*!
+	 * Changes whether a contact is valid.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @param[in] valid Whether the contact is valid.
+	 */
+	void set_valid(const usize i, const std::optional<bool> valid)
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		m_has_valid(n) = valid.has_value();
+		m_valid(n) = valid.value_or(false);
+	}
+
+	/*!
+	 * Whether a contact is stable.
+	 *
+	 * @param[in] i The position of the contact in the frame.
+	 * @return Whether the contact is stable, or nothing if its stability was not checked.
+	 */
+	[[nodiscard]] std::optional<bool> stable(const usize i) const
+	{
+		const Eigen::Index n = casts::to_eigen(i);
+
+		if (!m_has_stable(n))
+			return std::nullopt;
+
+		return m_stable(n);
+	}
+
+private:
+	/*!
+	 * Makes sure that the arrays can hold a certain amount of contacts.
+	 *
+	 * @param[in] size The number of contacts.
+	 */
+	void reserve(const usize size)
+	{
+		const Eigen::Index n = casts::to_eigen(size);
+
+		if (m_mean_x.size() >= n)
+			return;
+
+		m_mean_x.resize(n);
+		m_mean_y.resize(n);
+		m_size_x.resize(n);
+		m_size_y.resize(n);
+		m_orientation.resize(n);
+		m_index.resize(n);
+		m_normalized.resize(n);
+		m_has_index.resize(n);
+		m_valid.resize(n);
+		m_has_valid.resize(n);
+		m_stable.resize(n);
+		m_has_stable.resize(n);
+	}
+};
+
+} // namespace iptsd::contacts
+
+#endif // IPTSD_CONTACTS_FRAME_HPP
@@ -3,19 +3,91 @@
 #ifndef IPTSD_CONTACTS_STABILITY_CONFIG_HPP
 #define IPTSD_CONTACTS_STABILITY_CONFIG_HPP
 
+#include <common/casts.hpp>
 #include <common/types.hpp>
 
+#include <gsl/gsl>
+
 #include <optional>
 #include <type_traits>
 
 namespace iptsd::contacts::stability {
 
+enum class Algorithm : u8 {
+	/*
+	 * Changes below the lower threshold are discarded, changes above it are kept unchanged.
+	 */
+	THRESHOLD,
+
+	/*
+	 * Changes are smoothed by a low pass filter, whose cutoff frequency grows with the
+	 * speed of the change (1€ filter). Slow movements are smoothed a lot, which removes
+	 * jitter, while fast movements are barely smoothed, which keeps the lag low.
+	 */
+	ADAPTIVE,
+};
+
+/*
+ * The defaults for how fast the cutoff frequency of the adaptive filter increases with the
+ * speed of a change. Position and size are measured in centimeters, orientation in degrees.
+ *
+ * The filter works with normalized contacts, so core::Config scales these with the size of
+ * the screen. The defaults of Config are scaled for a screen with REFERENCE_DIAGONAL.
+ */
+constexpr f64 ADAPTIVE_POSITION_BETA = 10;
+constexpr f64 ADAPTIVE_SIZE_BETA = 10;
+constexpr f64 ADAPTIVE_ORIENTATION_BETA = 1.5;
+
+// The screen diagonal in centimeters that the defaults of the adaptive filter are scaled for.
+constexpr f64 REFERENCE_DIAGONAL = 30;
+
 template <class T>
 struct Config {
 public:
 	static_assert(std::is_floating_point_v<T>);
 
 public:
+	/*
+	 * How small changes of a contact are stabilized.
+	 *
+	 * With both algorithms, the upper limit of the thresholds is used to
+	 * mark contacts as unstable if they change too much between two frames.
+	 */
+	Algorithm algorithm = Algorithm::THRESHOLD;
+
+	/*
+	 * The cutoff frequency of the adaptive filter for contacts that are not changing,
+	 * relative to the frame rate. Lower values remove more jitter, but add more lag.
+	 */
+	T adaptive_min_cutoff = gsl::narrow_cast<T>(0.02);
+
+	/*
+	 * How much the cutoff frequency of the adaptive filter increases with the speed of
+	 * the position. Higher values reduce the lag of fast movements.
+	 *
+	 * The speed is measured in normalized coordinates, so this has to be scaled with the size
+	 * of the screen.
+	 */
+	T adaptive_position_beta = casts::to<T>(ADAPTIVE_POSITION_BETA * REFERENCE_DIAGONAL);
+
+	/*
+	 * How much the cutoff frequency of the adaptive filter increases with the speed of
+	 * the size. Like the position, the size is measured in normalized coordinates.
+	 */
+	T adaptive_size_beta = casts::to<T>(ADAPTIVE_SIZE_BETA * REFERENCE_DIAGONAL);
+
+	/*
+	 * How much the cutoff frequency of the adaptive filter increases with the speed of
+	 * the orientation. The orientation is normalized to the range [0, 1].
+	 */
+	T adaptive_orientation_beta = casts::to<T>(ADAPTIVE_ORIENTATION_BETA * 180);
+
+	/*
+	 * The cutoff frequency of the filter that smoothes the speed estimate of the
+	 * adaptive filter, relative to the frame rate.
+	 */
+	T adaptive_derivative_cutoff = gsl::narrow_cast<T>(0.15);
+
 	/*
 	 * The limits that the size difference of a contact between two frames may not exceed.
 	 */
@@ -4,6 +4,7 @@
 #define IPTSD_CONTACTS_STABILITY_STABILIZER_HPP
 
 #include "../contact.hpp"
+#include "../frame.hpp"
 #include "config.hpp"
 
 #include <common/casts.hpp>
@@ -12,8 +13,10 @@
 #include <gsl/gsl>
 
 #include <algorithm>
-#include <iterator>
+#include <cmath>
+#include <optional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace iptsd::contacts::stability {
@@ -23,11 +26,35 @@ class Stabilizer {
 public:
 	static_assert(std::is_floating_point_v<T>);
 
+private:
+	/*
+	 * The state of the adaptive filter for a single contact.
+	 */
+	struct FilterState {
+		// The index of the contact.
+		usize index = 0;
+
+		// The smoothed change of the position per frame.
+		Vector2<T> mean = Vector2<T>::Zero();
+
+		// The smoothed change of the size per frame.
+		Vector2<T> size = Vector2<T>::Zero();
+
+		// The smoothed change of the orientation per frame.
+		T orientation = casts::to<T>(0);
+	};
+
 private:
 	Config<T> m_config;
 
 	// The last frame.
-	std::vector<Contact<T>> m_last {};
+	ContactFrame<T> m_last {};
+
+	// The state of the adaptive filter for the contacts of the last frame.
+	std::vector<FilterState> m_states {};
+
+	// The state of the adaptive filter for the contacts of the current frame.
+	std::vector<FilterState> m_next {};
 
 public:
 	Stabilizer(Config<T> config) : m_config {std::move(config)} {};
@@ -38,6 +65,7 @@ public:
 	void reset()
 	{
 		m_last.clear();
+		m_states.clear();
 	}
 
 	/*!
@@ -47,14 +75,16 @@ public:
 	 */
 	void stabilize(std::vector<Contact<T>> &frame)
 	{
+		m_next.clear();
+
 		// Stabilize contacts
 		for (Contact<T> &contact : frame)
 			this->stabilize_contact(contact);
 
-		m_last.clear();
+		std::swap(m_states, m_next);
 
 		// Save a copy of the new data
-		std::copy(frame.begin(), frame.end(), std::back_inserter(m_last));
+		m_last.assign(frame);
 	}
 
 private:
@@ -63,7 +93,7 @@ private:
 	 *
 	 * @param[in,out] contact The contact to stabilize.
 	 */
-	void stabilize_contact(Contact<T> &contact) const
+	void stabilize_contact(Contact<T> &contact)
 	{
 		// Contacts that can't be tracked can't be stabilized.
 		if (!contact.index.has_value())
@@ -72,7 +102,22 @@ private:
 		contact.stable = true;
 
 		const usize index = contact.index.value();
-		const auto wrapper = Contact<T>::find_in_frame(index, m_last);
+		const std::optional<usize> position = m_last.find(index);
+
+		std::optional<Contact<T>> wrapper = std::nullopt;
+
+		if (position.has_value())
+			wrapper = m_last.contact(position.value());
+
+		if (m_config.algorithm == Algorithm::ADAPTIVE) {
+			FilterState state = this->find_state(index);
+
+			if (wrapper.has_value())
+				this->filter_contact(contact, wrapper.value(), state);
+
+			m_next.push_back(state);
+			return;
+		}
 
 		if (!wrapper.has_value())
 			return;
@@ -189,6 +234,157 @@ private:
 		else if (delta > thresh.y())
 			current.stable = false;
 	}
+
+	/*!
+	 * Looks up the state of the adaptive filter for a contact.
+	 *
+	 * @param[in] index The index of the contact.
+	 * @return The stored state, or a new one if the contact wasn't present in the last frame.
+	 */
+	[[nodiscard]] FilterState find_state(const usize index) const
+	{
+		for (const FilterState &state : m_states) {
+			if (state.index == index)
+				return state;
+		}
+
+		FilterState state {};
+		state.index = index;
+
+		return state;
+	}
+
+	/*!
+	 * Stabilizes a contact using the adaptive filter.
+	 *
+	 * Contacts that change too much are still marked as unstable, but all other
+	 * changes are smoothed instead of being discarded or passed through.
+	 *
+	 * @param[in,out] current The contact to stabilize.
+	 * @param[in] last The stabilized contact from the last frame.
+	 * @param[in,out] state The state of the filter for this contact.
+	 */
+	void filter_contact(Contact<T> &current, const Contact<T> &last, FilterState &state) const
+	{
+		const Vector2<T> dsize = current.size - last.size;
+		const Vector2<T> dmean = current.mean - last.mean;
+
+		if (m_config.size_threshold.has_value()) {
+			const Vector2<T> thresh = m_config.size_threshold.value();
+
+			if (dsize.cwiseAbs().maxCoeff() > thresh.y())
+				current.stable = false;
+		}
+
+		if (m_config.position_threshold.has_value()) {
+			const Vector2<T> thresh = m_config.position_threshold.value();
+
+			if (dmean.norm() > thresh.y())
+				current.stable = false;
+		}
+
+		const T size_beta = m_config.adaptive_size_beta;
+		const T position_beta = m_config.adaptive_position_beta;
+
+		current.size = last.size + this->adapt(dsize, state.size, size_beta) * dsize;
+		current.mean = last.mean + this->adapt(dmean, state.mean, position_beta) * dmean;
+
+		this->filter_orientation(current, last, state);
+	}
+
+	/*!
+	 * Stabilizes the orientation of a contact using the adaptive filter.
+	 *
+	 * @param[in,out] current The contact to stabilize.
+	 * @param[in] last The stabilized contact from the last frame.
+	 * @param[in,out] state The state of the filter for this contact.
+	 */
+	void filter_orientation(Contact<T> &current,
+	                        const Contact<T> &last,
+	                        FilterState &state) const
+	{
+		const T aspect = current.size.maxCoeff() / current.size.minCoeff();
+
+		// See stabilize_orientation
+		if (aspect < 1.1) {
+			current.orientation = 0;
+			state.orientation = 0;
+			return;
+		}
+
+		const T max = current.normalized ? casts::to<T>(1) : gsl::narrow_cast<T>(M_PI);
+
+		// Take the shorter way around, to properly handle going from 0° to 179°.
+		T delta = current.orientation - last.orientation;
+
+		if (delta > max / 2)
+			delta -= max;
+		else if (delta < -max / 2)
+			delta += max;
+
+		if (m_config.orientation_threshold.has_value()) {
+			const Vector2<T> thresh = m_config.orientation_threshold.value();
+
+			if (std::abs(delta) > thresh.y())
+				current.stable = false;
+		}
+
+		const T beta = m_config.adaptive_orientation_beta;
+		const T alpha = this->adapt(delta, state.orientation, beta);
+
+		T orientation = last.orientation + alpha * delta;
+
+		if (orientation < 0)
+			orientation += max;
+		else if (orientation >= max)
+			orientation -= max;
+
+		current.orientation = orientation;
+	}
+
+	/*!
+	 * Updates the speed estimate of a value and calculates the smoothing factor for it.
+	 *
+	 * @param[in] delta The difference between the new value and the last filtered value.
+	 * @param[in,out] speed The smoothed change of the value per frame.
+	 * @param[in] beta How much the cutoff frequency increases with the speed.
+	 * @return The smoothing factor for the change of the value.
+	 */
+	[[nodiscard]] T adapt(const Vector2<T> &delta, Vector2<T> &speed, const T beta) const
+	{
+		speed += this->alpha(m_config.adaptive_derivative_cutoff) * (delta - speed);
+
+		const T fmin = m_config.adaptive_min_cutoff;
+		return this->alpha(fmin + beta * speed.norm());
+	}
+
+	/*!
+	 * Updates the speed estimate of a value and calculates the smoothing factor for it.
+	 *
+	 * @param[in] delta The difference between the new value and the last filtered value.
+	 * @param[in,out] speed The smoothed change of the value per frame.
+	 * @param[in] beta How much the cutoff frequency increases with the speed.
+	 * @return The smoothing factor for the change of the value.
+	 */
+	[[nodiscard]] T adapt(const T delta, T &speed, const T beta) const
+	{
+		speed += this->alpha(m_config.adaptive_derivative_cutoff) * (delta - speed);
+
+		const T fmin = m_config.adaptive_min_cutoff;
+		return this->alpha(fmin + beta * std::abs(speed));
+	}
+
+	/*!
+	 * Calculates the smoothing factor of an exponential low pass filter.
+	 *
+	 * @param[in] cutoff The cutoff frequency of the filter, relative to the frame rate.
+	 * @return The weight of a new value, compared to the previous output of the filter.
+	 */
+	[[nodiscard]] static T alpha(const T cutoff)
+	{
+		const T tau = 1 / (2 * gsl::narrow_cast<T>(M_PI) * cutoff);
+		return 1 / (1 + tau);
+	}
 };
 
 } // namespace iptsd::contacts::stability
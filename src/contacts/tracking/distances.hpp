@@ -3,13 +3,11 @@
 #ifndef IPTSD_CONTACTS_TRACKING_DISTANCES_HPP
 #define IPTSD_CONTACTS_TRACKING_DISTANCES_HPP
 
-#include "../contact.hpp"
+#include "../frame.hpp"
 
 #include <common/casts.hpp>
 #include <common/types.hpp>
 
-#include <vector>
-
 namespace iptsd::contacts::tracking::distances {
 
 /*!
@@ -23,26 +21,21 @@ namespace iptsd::contacts::tracking::distances {
  * @param[out] out The output data.
  */
 template <class Derived>
-void calculate(const std::vector<Contact<typename DenseBase<Derived>::Scalar>> &x,
-               const std::vector<Contact<typename DenseBase<Derived>::Scalar>> &y,
+void calculate(const ContactFrame<typename DenseBase<Derived>::Scalar> &x,
+               const ContactFrame<typename DenseBase<Derived>::Scalar> &y,
                DenseBase<Derived> &out)
 {
-	using T = typename DenseBase<Derived>::Scalar;
-
 	const Eigen::Index sx = casts::to_eigen(x.size());
 	const Eigen::Index sy = casts::to_eigen(y.size());
 
 	out.derived().conservativeResize(sy, sx);
 
-	// Calculate the distances between current and previous inputs
+	// Calculate the distances of one previous input to all current inputs at once
 	for (Eigen::Index iy = 0; iy < sy; iy++) {
-		const Contact<T> &cy = y[casts::to_unsigned(iy)];
-
-		for (Eigen::Index ix = 0; ix < sx; ix++) {
-			const Contact<T> &cx = x[casts::to_unsigned(ix)];
+		const auto dx = x.mean_x() - y.mean_x()(iy);
+		const auto dy = x.mean_y() - y.mean_y()(iy);
 
-			out(iy, ix) = gsl::narrow_cast<T>((cx.mean - cy.mean).hypotNorm());
-		}
+		out.derived().row(iy) = (dx.square() + dy.square()).sqrt();
 	}
 }
 
@@ -4,13 +4,14 @@
 #define IPTSD_CONTACTS_TRACKING_TRACKER_HPP
 
 #include "../contact.hpp"
+#include "../frame.hpp"
 #include "distances.hpp"
 
 #include <common/casts.hpp>
 #include <common/types.hpp>
 
 #include <algorithm>
-#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace iptsd::contacts::tracking {
@@ -22,7 +23,10 @@ public:
 
 private:
 	// The last frame.
-	std::vector<Contact<T>> m_last {};
+	ContactFrame<T> m_last {};
+
+	// The current frame.
+	ContactFrame<T> m_frame {};
 
 	// The distances between all contacts from the current and the last frame.
 	Image<T> m_distances {};
@@ -51,12 +55,14 @@ public:
 			counter = contact.index.value() + 1;
 		}
 
+		m_frame.assign(frame);
+
 		if (!m_last.empty()) {
 			const usize min = std::min(frame.size(), m_last.size());
 
 			// Calculate the distances between all contacts from the current and last
 			// frame
-			distances::calculate(frame, m_last, m_distances);
+			distances::calculate(m_frame, m_last, m_distances);
 
 			// Copy the old indices back for the amount of contacts that can be tracked.
 			for (usize i = 0; i < min; i++) {
@@ -65,20 +71,21 @@ public:
 
 				m_distances.minCoeff(&y, &x);
 
+				const usize cx = casts::to_unsigned(x);
+				const usize cy = casts::to_unsigned(y);
+
 				// Copy the index of the contact
-				frame[casts::to_unsigned(x)].index =
-					m_last[casts::to_unsigned(y)].index;
+				frame[cx].index = m_last.index(cy);
+				m_frame.set_index(cx, frame[cx].index);
 
 				// Invalidate all entries containing these contacts
 				m_distances.row(y) = Eigen::NumTraits<T>::infinity();
 				m_distances.col(x) = Eigen::NumTraits<T>::infinity();
 			}
-
-			m_last.clear();
 		}
 
-		// Save a copy of the new data
-		std::copy(frame.begin(), frame.end(), std::back_inserter(m_last));
+		// Keep the new data for the next frame
+		std::swap(m_last, m_frame);
 	}
 
 private:
@@ -91,7 +98,7 @@ private:
 	[[nodiscard]] usize find_new_index(usize min) const
 	{
 		while (true) {
-			if (!Contact<T>::find_in_frame(min, m_last).has_value())
+			if (!m_last.find(min).has_value())
 				return min;
 
 			min++;
@@ -4,11 +4,15 @@
 #define IPTSD_CONTACTS_VALIDATION_VALIDATOR_HPP
 
 #include "../contact.hpp"
+#include "../frame.hpp"
 #include "config.hpp"
 
+#include <common/casts.hpp>
 #include <common/types.hpp>
 
+#include <optional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace iptsd::contacts::validation {
@@ -23,7 +27,16 @@ private:
 	Config<T> m_config;
 
 	// The last frame.
-	std::vector<Contact<T>> m_last {};
+	ContactFrame<T> m_last {};
+
+	// The current frame.
+	ContactFrame<T> m_frame {};
+
+	// Whether the size of the contacts of the current frame is within the limits.
+	Array<bool> m_size_valid {};
+
+	// Whether the aspect ratio of the contacts of the current frame is within the limits.
+	Array<bool> m_aspect_valid {};
 
 public:
 	Validator(Config<T> config) : m_config {std::move(config)} {};
@@ -43,23 +56,33 @@ public:
 	 */
 	void validate(std::vector<Contact<T>> &frame)
 	{
-		for (Contact<T> &contact : frame)
-			contact.valid = this->check_contact(contact);
+		m_frame.assign(frame);
 
-		m_last.clear();
+		// The limits don't depend on anything else, so all contacts are checked at once.
+		if (m_config.size_limits.has_value())
+			this->check_size();
 
-		// Save a copy of the new data
-		std::copy(frame.begin(), frame.end(), std::back_inserter(m_last));
+		if (m_config.aspect_limits.has_value())
+			this->check_aspect();
+
+		for (usize i = 0; i < frame.size(); i++) {
+			frame[i].valid = this->check_contact(i, frame[i]);
+			m_frame.set_valid(i, frame[i].valid);
+		}
+
+		// Keep the new data for the next frame
+		std::swap(m_last, m_frame);
 	}
 
 private:
 	/*!
 	 * Checks a single contact.
 	 *
+	 * @param[in] i The position of the contact in the frame.
 	 * @param[in] contact The contact to check.
 	 * @return Whether the contact is valid.
 	 */
-	bool check_contact(const Contact<T> &contact)
+	bool check_contact(const usize i, const Contact<T> &contact)
 	{
 		// Don't invalidate unstable contacts
 		if (!contact.stable.value_or(true))
@@ -72,12 +95,14 @@ private:
 		if (m_config.track_validity && !this->check_temporal(contact))
 			return false;
 
+		const Eigen::Index n = casts::to_eigen(i);
+
 		// Only do the size check if it is enabled
-		if (m_config.size_limits.has_value() && !this->check_size(contact))
+		if (m_config.size_limits.has_value() && !m_size_valid(n))
 			return false;
 
 		// Only do the aspect check if it is enabled
-		if (m_config.aspect_limits.has_value() && !this->check_aspect(contact))
+		if (m_config.aspect_limits.has_value() && !m_aspect_valid(n))
 			return false;
 
 		return true;
@@ -95,56 +120,43 @@ private:
 		if (!contact.index.has_value())
 			return true;
 
-		const auto wrapper = Contact<T>::find_in_frame(contact.index.value(), m_last);
-
-		if (!wrapper.has_value())
-			return true;
-
-		const Contact<T> &last = wrapper.value();
+		const std::optional<usize> last = m_last.find(contact.index.value());
 
-		if (!last.valid.has_value())
+		if (!last.has_value())
 			return true;
 
-		return last.valid.value();
+		return m_last.valid(last.value()).value_or(true);
 	}
 
 	/*!
-	 * Checks the size of a contact.
-	 *
-	 * @param[in] contact The contact to check.
-	 * @return Whether the size of the contact is within the valid range.
+	 * Checks the size of all contacts of the current frame.
 	 */
-	bool check_size(const Contact<T> &contact)
+	void check_size()
 	{
 		if (!m_config.size_limits.has_value())
-			return true;
+			return;
 
 		const Vector2<T> &limit = m_config.size_limits.value();
-		const Vector2<T> &size = contact.size;
+		const auto major = m_frame.size_x().max(m_frame.size_y());
 
-		const T major = size.maxCoeff();
-		return major >= limit.minCoeff() && major <= limit.maxCoeff();
+		m_size_valid = major >= limit.minCoeff() && major <= limit.maxCoeff();
 	}
 
 	/*!
-	 * Checks the aspect ratio of a contact.
-	 *
-	 * @param[in] contact The contact to check.
-	 * @return Whether the aspect ratio of the contact is within the valid range.
+	 * Checks the aspect ratio of all contacts of the current frame.
 	 */
-	bool check_aspect(const Contact<T> &contact)
+	void check_aspect()
 	{
 		if (!m_config.aspect_limits.has_value())
-			return true;
+			return;
 
 		const Vector2<T> &limit = m_config.aspect_limits.value();
-		const Vector2<T> &size = contact.size;
 
-		const T major = size.maxCoeff();
-		const T minor = size.minCoeff();
+		const auto major = m_frame.size_x().max(m_frame.size_y());
+		const auto minor = m_frame.size_x().min(m_frame.size_y());
 
-		const T aspect = major / minor;
-		return aspect >= limit.minCoeff() && aspect <= limit.maxCoeff();
+		const auto aspect = major / minor;
+		m_aspect_valid = aspect >= limit.minCoeff() && aspect <= limit.maxCoeff();
 	}
 };
 
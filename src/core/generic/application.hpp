@@ -7,17 +7,25 @@
 #include "device.hpp"
 #include "dft.hpp"
 #include "errors.hpp"
+#include "heatmap-filter.hpp"
+#include "heatmap.hpp"
+#include "predictor.hpp"
 
 #include <common/casts.hpp>
+#include <common/cpu.hpp>
 #include <common/error.hpp>
+#include <common/reader.hpp>
 #include <common/types.hpp>
 #include <contacts/finder.hpp>
 #include <ipts/data.hpp>
 #include <ipts/parser.hpp>
+#include <ipts/protocol/hid.hpp>
+#include <ipts/timeline.hpp>
 
 #include <spdlog/spdlog.h>
 
 #include <functional>
+#include <string_view>
 #include <vector>
 
 namespace iptsd::core {
@@ -63,6 +71,16 @@ protected:
 	 */
 	ipts::Parser m_parser {};
 
+	/*
+	 * Removes the per-pixel baseline and temporal noise from the raw heatmap data.
+	 */
+	HeatmapFilter m_filter;
+
+	/*
+	 * Converts the raw heatmap data into the format expected by the contact finder.
+	 */
+	HeatmapNormalizer m_normalizer;
+
 	/*
 	 * Temporary storage for normalized heatmap data.
 	 */
@@ -88,6 +106,16 @@ protected:
 	 */
 	DftStylus m_dft;
 
+	/*
+	 * Converts the timestamps of the incoming reports into a continuous timeline.
+	 */
+	ipts::Timeline m_timeline {};
+
+	/*
+	 * Predicts the future state of the stylus to compensate for the processing latency.
+	 */
+	StylusPredictor m_predictor;
+
 public:
 	Application(const Config &config,
 	            const DeviceInfo &info,
@@ -95,8 +123,11 @@ public:
 		: m_config {config},
 		  m_info {info},
 		  m_metadata {metadata},
+		  m_filter {config},
+		  m_normalizer {config.invert_x, config.invert_y},
 		  m_finder {config.contacts()},
-		  m_dft {config, metadata}
+		  m_dft {config, metadata},
+		  m_predictor {config}
 	{
 		if (m_config.width == 0 || m_config.height == 0)
 			throw common::Error<Error::InvalidScreenSize> {};
@@ -104,6 +135,11 @@ public:
 		m_parser.on_heatmap = [&](const auto &data) { this->process_heatmap(data); };
 		m_parser.on_stylus = [&](const auto &data) { this->process_stylus(data); };
 		m_parser.on_dft = [&](const auto &data) { this->process_dft(data); };
+
+		m_dft.on_stylus = [&](const auto &data) { this->process_stylus(data); };
+
+		const std::string_view level = common::cpu::format_as(common::cpu::level());
+		spdlog::debug("Using {} variant of the processing kernels", level);
 	}
 
 	virtual ~Application() = default;
@@ -115,9 +151,29 @@ public:
 	 */
 	void process(const gsl::span<u8> data)
 	{
+		if (data.size() >= sizeof(ipts::protocol::hid::ReportHeader)) {
+			Reader reader {data};
+			const auto header = reader.read<ipts::protocol::hid::ReportHeader>();
+
+			m_timeline.update(header.timestamp);
+		}
+
+		// Don't hold back the stylus if the rest of a group got lost.
+		m_dft.expire(m_timeline.now());
+
 		this->on_data(data);
 	}
 
+	/*!
+	 * Forgets the state that was learned from previous data.
+	 *
+	 * Called by the runners before the data flow starts.
+	 */
+	void reset()
+	{
+		m_filter.reset();
+	}
+
 	/*!
 	 * For running application specific code after the runner has started.
 	 */
@@ -135,7 +191,11 @@ protected:
 	 */
 	virtual void on_data(const gsl::span<u8> data)
 	{
-		m_parser.parse(data);
+		const ipts::ParseStatus status = m_parser.parse(data);
+
+		// Malformed reports are expected from time to time, they are counted by the parser.
+		if (status != ipts::ParseStatus::Ok)
+			spdlog::debug("Skipped malformed report: {}", ipts::format_as(status));
 	}
 
 	/*!
@@ -155,47 +215,24 @@ private:
 	 * IPTS usually sends data that goes from 255 (no contact) to 0 (contact).
 	 * For contact detection we need data that goes from 0 (no contact) to 1 (contact).
 	 *
+	 * The heatmap is also mirrored according to the configuration while it is normalized,
+	 * so the coordinates of the found contacts don't need to be inverted afterwards.
+	 *
 	 * @param[in] data The data to process.
 	 */
 	void process_heatmap(const ipts::Heatmap &data)
 	{
-		const Eigen::Index rows = casts::to_eigen(data.rows);
-		const Eigen::Index cols = casts::to_eigen(data.columns);
-
-		if (rows == 0 || cols == 0)
+		if (data.rows == 0 || data.columns == 0)
 			return;
 
-		// Make sure the heatmap buffer has the right size
-		if (m_heatmap.rows() != rows || m_heatmap.cols() != cols)
-			m_heatmap.conservativeResize(rows, cols);
-
-		// Map the buffer to an Eigen container
-		const Eigen::Map<const Image<u8>> mapped {data.data.data(), rows, cols};
-
-		const auto min = casts::to<f64>(data.min);
-		const auto max = casts::to<f64>(data.max);
-
-		// Normalize the heatmap to range [0, 1]
-		const auto norm = (mapped.cast<f64>() - min) / (max - min);
-
-		// IPTS sends inverted heatmaps
-		m_heatmap = 1.0 - norm;
+		if (m_filter.enabled())
+			m_normalizer.normalize(m_filter.filter(data), m_heatmap);
+		else
+			m_normalizer.normalize(data, m_heatmap);
 
 		// Search for contacts
 		m_finder.find(m_heatmap, m_contacts);
 
-		// Invert contact coordinates if neccessary
-		for (contacts::Contact<f64> &contact : m_contacts) {
-			if (m_config.invert_x)
-				contact.mean.x() = 1.0 - contact.mean.x();
-
-			if (m_config.invert_y)
-				contact.mean.y() = 1.0 - contact.mean.y();
-
-			if (m_config.invert_x != m_config.invert_y)
-				contact.orientation = 1.0 - contact.orientation;
-		}
-
 		// Hand off the found contacts to the handler code.
 		this->on_contacts(m_contacts);
 	}
@@ -214,6 +251,14 @@ private:
 		corrected.x += off.x();
 		corrected.y += off.y();
 
+		// Compensate for the time it takes until the input is visible.
+		if (m_predictor.enabled()) {
+			const auto predicted = m_predictor.predict(corrected, m_timeline.now());
+
+			if (predicted.has_value())
+				corrected = predicted.value();
+		}
+
 		// Hand off the stylus data to the handler code.
 		this->on_stylus(corrected);
 	}
@@ -221,15 +266,14 @@ private:
 	/*!
 	 * Handles incoming DFT windows.
 	 *
-	 * DFT windows update the state of the DFT based stylus. The updated data is then
-	 * processed exactly like older data, through @ref process_stylus.
+	 * DFT windows are collected into groups, which update the state of the DFT based stylus.
+	 * The updated data is then processed exactly like older data, through @ref process_stylus.
 	 *
 	 * @param[in] data The DFT window to process.
 	 */
 	void process_dft(const ipts::DftWindow &data)
 	{
-		m_dft.input(data);
-		this->process_stylus(m_dft.get_stylus());
+		m_dft.input(data, m_timeline.now());
 	}
 
 	/*!
@@ -45,10 +45,24 @@ public:
 	f64 contacts_size_max = 2;
 	f64 contacts_aspect_min = 1;
 	f64 contacts_aspect_max = 2.5;
+	std::string contacts_stabilizer = "threshold";
+	f64 contacts_adaptive_min_cutoff = 0.02;
+	f64 contacts_adaptive_position_beta = contacts::stability::ADAPTIVE_POSITION_BETA;
+	f64 contacts_adaptive_size_beta = contacts::stability::ADAPTIVE_SIZE_BETA;
+	f64 contacts_adaptive_orientation_beta = contacts::stability::ADAPTIVE_ORIENTATION_BETA;
+	f64 contacts_adaptive_derivative_cutoff = 0.15;
+	bool contacts_baseline = false;
+	f64 contacts_baseline_frames = 128;
+	f64 contacts_temporal_smoothing = 0.25;
+	usize contacts_pyramid_threshold = 10000;
+	usize contacts_parallel_threshold = 20000;
+	std::string contacts_engine = "gaussian";
 
 	// [Stylus]
 	bool stylus_disable = false;
 	f64 stylus_tip_distance = 0;
+	f64 stylus_prediction_horizon = 0;
+	f64 stylus_prediction_max_angle = 60;
 
 	// [DFT]
 	usize dft_position_min_amp = 50;
@@ -61,6 +75,9 @@ public:
 	usize dft_mpp2_contact_min_mag = 50000;
 	f64 dft_tilt_distance = 0.6;
 
+	// [Output]
+	std::string output_shared_memory;
+
 public:
 	/*!
 	 * Generates a configuration object for the contact detection library.
@@ -94,6 +111,23 @@ public:
 		config.detection.neutral_value_offset = nval_offset / 255.0;
 		config.detection.neutral_value_backoff = 16; // TODO: config option
 
+		if (this->contacts_pyramid_threshold > 0)
+			config.detection.pyramid_threshold = this->contacts_pyramid_threshold;
+
+		if (this->contacts_parallel_threshold > 0)
+			config.detection.parallel_threshold = this->contacts_parallel_threshold;
+
+		using Engine = contacts::detection::Engine;
+
+		if (this->contacts_engine == "gaussian")
+			config.detection.engine = Engine::GAUSSIAN;
+		else if (this->contacts_engine == "moments")
+			config.detection.engine = Engine::MOMENTS;
+		else if (this->contacts_engine == "hybrid")
+			config.detection.engine = Engine::HYBRID;
+		else
+			throw common::Error<Error::InvalidDetectionEngine> {};
+
 		const f64 diagonal = std::hypot(this->width, this->height);
 
 		config.validation.track_validity = true;
@@ -106,6 +140,29 @@ public:
 			this->contacts_aspect_max,
 		};
 
+		using Stabilizer = contacts::stability::Algorithm;
+
+		if (this->contacts_stabilizer == "threshold")
+			config.stability.algorithm = Stabilizer::THRESHOLD;
+		else if (this->contacts_stabilizer == "adaptive")
+			config.stability.algorithm = Stabilizer::ADAPTIVE;
+		else
+			throw common::Error<Error::InvalidStabilizerAlgorithm> {};
+
+		const f64 min_cutoff = this->contacts_adaptive_min_cutoff;
+		const f64 dcutoff = this->contacts_adaptive_derivative_cutoff;
+
+		// The betas are given per centimeter and per degree.
+		const f64 position_beta = this->contacts_adaptive_position_beta * diagonal;
+		const f64 size_beta = this->contacts_adaptive_size_beta * diagonal;
+		const f64 orientation_beta = this->contacts_adaptive_orientation_beta * 180;
+
+		config.stability.adaptive_min_cutoff = min_cutoff;
+		config.stability.adaptive_position_beta = position_beta;
+		config.stability.adaptive_size_beta = size_beta;
+		config.stability.adaptive_orientation_beta = orientation_beta;
+		config.stability.adaptive_derivative_cutoff = dcutoff;
+
 		config.stability.size_threshold = Vector2<f64> {
 			this->contacts_size_thresh_min / diagonal,
 			this->contacts_size_thresh_max / diagonal,
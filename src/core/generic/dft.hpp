@@ -6,17 +6,66 @@
 #include "config.hpp"
 
 #include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
 #include <ipts/data.hpp>
 #include <ipts/protocol/dft.hpp>
 
+#include <gsl/gsl>
+
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <functional>
 #include <optional>
 #include <utility>
+#include <vector>
 
 namespace iptsd::core {
 
+/*
+ * Calculates the state of a DFT based stylus.
+ *
+ * The device measures the stylus in groups, each consisting of several DFT windows of different
+ * types. The windows of a group are buffered until the group is complete, and are then processed
+ * together, so that there is exactly one update of the stylus per group.
+ */
 class DftStylus {
+public:
+	// How long to wait for the missing windows of a group before it is processed anyway.
+	static constexpr chrono::microseconds GROUP_TIMEOUT = 10ms;
+
+	// The callback that is invoked when the state of the stylus was updated.
+	std::function<void(const ipts::StylusData &)> on_stylus;
+
+private:
+	/*
+	 * A copy of a DFT window, because the received data is only valid until the next report.
+	 */
+	struct Window {
+		ipts::protocol::dft::Type type {};
+
+		u8 width = 0;
+		u8 height = 0;
+
+		std::vector<ipts::protocol::dft::Row> x {};
+		std::vector<ipts::protocol::dft::Row> y {};
+	};
+
+	/*
+	 * The order in which the windows of a group are processed.
+	 *
+	 * The button uses the phase of the position signal and the button state of the binary
+	 * window, and the pressure uses the contact state of the MPP v2 position window.
+	 */
+	static constexpr std::array<ipts::protocol::dft::Type, 5> ORDER {
+		ipts::protocol::dft::Type::Position,
+		ipts::protocol::dft::Type::PositionMPP_2,
+		ipts::protocol::dft::Type::BinaryMPP_2,
+		ipts::protocol::dft::Type::Button,
+		ipts::protocol::dft::Type::Pressure,
+	};
+
 private:
 	Config m_config;
 	std::optional<const ipts::Metadata> m_metadata;
@@ -42,17 +91,177 @@ private:
 	// This is used to override the contact state in the pressure frame handling.
 	std::optional<bool> m_mppv2_in_contact = std::nullopt;
 
+	/*
+	 * group assembly
+	 */
+
+	// The group whose windows are being received.
+	std::optional<u32> m_pending_group = std::nullopt;
+
+	// How many windows of the pending group were received, including the processed ones.
+	usize m_pending_size = 0;
+
+	// When the first window of the pending group was received.
+	chrono::microseconds m_pending_start {};
+
+	// The buffered windows of the pending group. Only the first m_buffered are used.
+	std::vector<Window> m_windows {};
+	usize m_buffered = 0;
+
+	// How many windows a complete group has.
+	std::optional<usize> m_group_size = std::nullopt;
+
+	// How many groups in a row had less windows than a complete group.
+	usize m_short_groups = 0;
+
 public:
 	DftStylus(Config config, const std::optional<const ipts::Metadata> &metadata)
 		: m_config {std::move(config)},
 		  m_metadata {metadata} {};
 
+	/*!
+	 * Adds a DFT window to the group it belongs to.
+	 *
+	 * Once the group is complete, the state of the stylus is calculated and @ref on_stylus
+	 * is invoked. A group is complete when it has as many windows as the previous one, or when
+	 * the windows of the next group start. Windows that don't belong to a group are processed
+	 * right away.
+	 *
+	 * @param[in] dft The dft window received from the IPTS hardware.
+	 * @param[in] now The time at which the window was received.
+	 */
+	void input(const ipts::DftWindow &dft, const chrono::microseconds now)
+	{
+		if (!dft.group.has_value()) {
+			this->flush();
+
+			this->handle(dft);
+			this->emit();
+
+			return;
+		}
+
+		if (m_pending_group != dft.group) {
+			this->flush();
+
+			if (m_pending_group.has_value())
+				this->learn(m_pending_size);
+
+			m_pending_group = dft.group;
+			m_pending_size = 0;
+			m_pending_start = now;
+		}
+
+		this->buffer(dft);
+		m_pending_size++;
+
+		if (m_group_size.has_value() && m_pending_size == m_group_size.value())
+			this->flush();
+	}
+
+	/*!
+	 * Processes the pending group, if its missing windows didn't arrive in time.
+	 *
+	 * @param[in] now The current time.
+	 */
+	void expire(const chrono::microseconds now)
+	{
+		if (m_buffered == 0 || now - m_pending_start < GROUP_TIMEOUT)
+			return;
+
+		this->flush();
+	}
+
+private:
+	/*!
+	 * Learns how many windows a complete group has from a group that has ended.
+	 *
+	 * The layout of the groups only changes when a different stylus is used. A single group
+	 * with less windows most likely lost one, so the size is only reduced if that repeats.
+	 *
+	 * @param[in] size How many windows the group had.
+	 */
+	void learn(const usize size)
+	{
+		if (!m_group_size.has_value() || size >= m_group_size.value()) {
+			m_group_size = size;
+			m_short_groups = 0;
+			return;
+		}
+
+		if (++m_short_groups < 3)
+			return;
+
+		m_group_size = size;
+		m_short_groups = 0;
+	}
+
+	/*!
+	 * Copies a DFT window into the buffer of the pending group.
+	 *
+	 * @param[in] dft The DFT window to copy.
+	 */
+	void buffer(const ipts::DftWindow &dft)
+	{
+		if (m_buffered == m_windows.size())
+			m_windows.emplace_back();
+
+		Window &window = m_windows[m_buffered++];
+
+		window.type = dft.type;
+		window.width = dft.width;
+		window.height = dft.height;
+
+		window.x.assign(dft.x.begin(), dft.x.end());
+		window.y.assign(dft.y.begin(), dft.y.end());
+	}
+
+	/*!
+	 * Processes the buffered windows of the pending group and updates the stylus once.
+	 */
+	void flush()
+	{
+		if (m_buffered == 0)
+			return;
+
+		for (const ipts::protocol::dft::Type type : ORDER) {
+			for (usize i = 0; i < m_buffered; i++) {
+				Window &window = m_windows[i];
+
+				if (window.type != type)
+					continue;
+
+				ipts::DftWindow dft {};
+				dft.group = m_pending_group;
+				dft.type = window.type;
+				dft.width = window.width;
+				dft.height = window.height;
+				dft.x = gsl::span<ipts::protocol::dft::Row> {window.x};
+				dft.y = gsl::span<ipts::protocol::dft::Row> {window.y};
+
+				this->handle(dft);
+			}
+		}
+
+		m_buffered = 0;
+		this->emit();
+	}
+
+	/*!
+	 * Passes the state of the stylus to the callback.
+	 */
+	void emit() const
+	{
+		if (this->on_stylus)
+			this->on_stylus(m_stylus);
+	}
+
 	/*!
 	 * Loads a DFT window and calculates stylus properties from it.
 	 *
 	 * @param[in] dft The dft window received from the IPTS hardware.
 	 */
-	void input(const ipts::DftWindow &dft)
+	void handle(const ipts::DftWindow &dft)
 	{
 		switch (dft.type) {
 		case ipts::protocol::dft::Type::Position:
@@ -76,17 +285,6 @@ public:
 		}
 	}
 
-	/*!
-	 * The current state of the DFT stylus.
-	 *
-	 * @return An object describing the current position and state of the DFT based stylus.
-	 */
-	[[nodiscard]] const ipts::StylusData &get_stylus() const
-	{
-		return m_stylus;
-	}
-
-private:
 	/*!
 	 * Calculates the stylus position from a DFT window.
 	 *
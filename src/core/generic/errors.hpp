@@ -12,6 +12,8 @@ namespace iptsd::core {
 enum class Error : u8 {
 	InvalidScreenSize,
 	InvalidNeutralValueAlgorithm,
+	InvalidStabilizerAlgorithm,
+	InvalidDetectionEngine,
 };
 
 inline std::string format_as(Error err)
@@ -21,6 +23,10 @@ inline std::string format_as(Error err)
 		return "core: The screen size is 0! Is your device supported?";
 	case Error::InvalidNeutralValueAlgorithm:
 		return "core: The selected neutral value algorithm is invalid!";
+	case Error::InvalidStabilizerAlgorithm:
+		return "core: The selected stabilizer algorithm is invalid!";
+	case Error::InvalidDetectionEngine:
+		return "core: The selected contact detection engine is invalid!";
 	default:
 		return "core: Invalid error code!";
 	}
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CORE_GENERIC_HEATMAP_HPP
+#define IPTSD_CORE_GENERIC_HEATMAP_HPP
+
+#include <common/casts.hpp>
+#include <common/cpu.hpp>
+#include <common/types.hpp>
+#include <ipts/data.hpp>
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace iptsd::core {
+
+/*
+ * Converts raw IPTS heatmaps into the format expected by the contact finder.
+ *
+ * IPTS sends heatmaps as bytes that go from max (no contact) to min (contact), in the
+ * orientation of the sensor. The contact finder wants values from 0 (no contact) to
+ * 1 (contact), in the orientation of the screen.
+ *
+ * Because the input only has 256 possible values, and the range rarely changes, the
+ * conversion is done through a lookup table, while the image is mirrored in the same pass.
+ */
+class HeatmapNormalizer {
+private:
+	// Whether the heatmap has to be mirrored along the X axis.
+	bool m_invert_x;
+
+	// Whether the heatmap has to be mirrored along the Y axis.
+	bool m_invert_y;
+
+	// The range of values that the lookup table was built for.
+	std::optional<std::pair<u8, u8>> m_range = std::nullopt;
+
+	// Maps every possible input value to its normalized and inverted value.
+	std::array<f64, std::numeric_limits<u8>::max() + 1> m_lut {};
+
+public:
+	HeatmapNormalizer(const bool invert_x, const bool invert_y)
+		: m_invert_x {invert_x},
+		  m_invert_y {invert_y} {};
+
+	/*!
+	 * Normalizes, inverts and mirrors a heatmap.
+	 *
+	 * @param[in] data The heatmap received from the device.
+	 * @param[out] out The normalized heatmap, in screen orientation.
+	 */
+	void normalize(const ipts::Heatmap &data, Image<f64> &out)
+	{
+		const Eigen::Index rows = casts::to_eigen(data.rows);
+		const Eigen::Index cols = casts::to_eigen(data.columns);
+
+		// Make sure the heatmap buffer has the right size
+		if (out.rows() != rows || out.cols() != cols)
+			out.conservativeResize(rows, cols);
+
+		this->update_lut(data.min, data.max);
+
+		// Map the buffer to an Eigen container
+		const Eigen::Map<const Image<u8>> mapped {data.data.data(), rows, cols};
+
+		const auto lookup = [&](const u8 value) { return m_lut[value]; };
+
+		// The mapping is compiled for multiple instruction sets.
+		common::cpu::dispatch([&]() {
+			if (m_invert_x && m_invert_y)
+				out = mapped.reverse().unaryExpr(lookup);
+			else if (m_invert_x)
+				out = mapped.rowwise().reverse().unaryExpr(lookup);
+			else if (m_invert_y)
+				out = mapped.colwise().reverse().unaryExpr(lookup);
+			else
+				out = mapped.unaryExpr(lookup);
+		});
+	}
+
+private:
+	/*!
+	 * Rebuilds the lookup table if the range of the heatmap has changed.
+	 *
+	 * @param[in] min The value that the device sends for the strongest contact.
+	 * @param[in] max The value that the device sends for no contact.
+	 */
+	void update_lut(const u8 min, const u8 max)
+	{
+		const std::pair<u8, u8> range {min, max};
+
+		if (m_range == range)
+			return;
+
+		const auto fmin = casts::to<f64>(min);
+		const auto fmax = casts::to<f64>(max);
+
+		for (usize i = 0; i < m_lut.size(); i++) {
+			// Normalize the value to range [0, 1]
+			const f64 norm = (casts::to<f64>(i) - fmin) / (fmax - fmin);
+
+			// IPTS sends inverted heatmaps
+			m_lut[i] = 1.0 - norm;
+		}
+
+		m_range = range;
+	}
+};
+
+} // namespace iptsd::core
+
+#endif // IPTSD_CORE_GENERIC_HEATMAP_HPP
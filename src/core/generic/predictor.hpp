@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CORE_GENERIC_PREDICTOR_HPP
+#define IPTSD_CORE_GENERIC_PREDICTOR_HPP
+
+#include "config.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+#include <ipts/data.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <utility>
+
+namespace iptsd::core {
+
+/*
+ * Extrapolates the state of the stylus into the future.
+ *
+ * Between the sensor taking a sample and the sample reaching the compositor, several
+ * milliseconds pass. When drawing, this shows up as a gap between the pen tip and the end
+ * of the line. By predicting where the stylus will be once the sample is displayed, that
+ * gap can be hidden.
+ *
+ * The prediction fits a line through the most recent samples of the current stroke and
+ * extends it by the configured horizon. It is only done while the stylus touches the screen,
+ * and is skipped whenever the history does not describe a smooth movement.
+ */
+class StylusPredictor {
+public:
+	// From how many reports the samples are used to estimate the movement of the stylus.
+	static constexpr usize HISTORY = 5;
+
+	// If no sample was received for this long, the stroke is considered to be interrupted.
+	static constexpr chrono::microseconds MAX_GAP = 25ms;
+
+private:
+	struct Sample {
+		// The time at which the sample was measured.
+		chrono::microseconds time {};
+
+		// The time at which the report containing the sample was received.
+		chrono::microseconds report {};
+
+		// The state of the stylus.
+		ipts::StylusData data {};
+	};
+
+private:
+	Config m_config;
+
+	// The samples of the current stroke, the newest one is at the back.
+	std::deque<Sample> m_history {};
+
+	// The time at which the last report was received.
+	std::optional<chrono::microseconds> m_report = std::nullopt;
+
+	// The time between the last two reports, if they were received close enough to each other.
+	std::optional<chrono::microseconds> m_interval = std::nullopt;
+
+	// How many samples the last report contained.
+	isize m_expected = 0;
+
+	// How many samples of the current report have been received.
+	isize m_received = 0;
+
+public:
+	StylusPredictor(Config config) : m_config {std::move(config)} {};
+
+	/*!
+	 * Whether prediction is enabled in the configuration.
+	 */
+	[[nodiscard]] bool enabled() const
+	{
+		return m_config.stylus_prediction_horizon > 0;
+	}
+
+	/*!
+	 * Forgets all stored samples, so that the next sample starts a new stroke.
+	 */
+	void reset()
+	{
+		m_history.clear();
+	}
+
+	/*!
+	 * Adds a sample to the history and predicts the future state of the stylus.
+	 *
+	 * Reports can contain multiple samples, which all are passed with the same time.
+	 * They are spread over the time since the previous report, see @ref sample_time.
+	 *
+	 * @param[in] data The current state of the stylus.
+	 * @param[in] time The time at which the report containing the state was received.
+	 * @return The predicted state of the stylus, or nothing if it can't be predicted.
+	 */
+	std::optional<ipts::StylusData> predict(const ipts::StylusData &data,
+	                                        const chrono::microseconds time)
+	{
+		if (!this->enabled())
+			return std::nullopt;
+
+		this->update_interval(time);
+		const chrono::microseconds sample = this->sample_time(time);
+
+		// Hovering is not predicted, and lifting the stylus ends the stroke.
+		if (!data.proximity || !data.contact) {
+			this->reset();
+			return std::nullopt;
+		}
+
+		if (!m_history.empty()) {
+			const Sample &last = m_history.back();
+
+			const bool rubber = last.data.rubber != data.rubber;
+			const bool serial = last.data.serial != data.serial;
+			const bool gap = time - last.report > MAX_GAP || time < last.report;
+
+			// Samples of another tool or after a pause are not part of the stroke.
+			if (rubber || serial || gap)
+				this->reset();
+		}
+
+		m_history.push_back(Sample {sample, time, data});
+
+		while (this->reports() > HISTORY)
+			m_history.pop_front();
+
+		if (m_history.size() < 3)
+			return std::nullopt;
+
+		if (this->is_turning())
+			return std::nullopt;
+
+		return this->extrapolate();
+	}
+
+private:
+	/*!
+	 * Measures the time between two consecutive reports.
+	 *
+	 * @param[in] time The time at which the current report was received.
+	 */
+	void update_interval(const chrono::microseconds time)
+	{
+		if (m_report == time)
+			return;
+
+		const std::optional<chrono::microseconds> last = std::exchange(m_report, time);
+		m_expected = std::exchange(m_received, 0);
+
+		if (last.has_value() && time > last.value() && time - last.value() <= MAX_GAP)
+			m_interval = time - last.value();
+		else
+			m_interval = std::nullopt;
+	}
+
+	/*!
+	 * Derives the time at which a sample was measured.
+	 *
+	 * The samples of a report were measured one after the other since the previous report,
+	 * and the last one at the time of the report. Usually, every report contains the same
+	 * number of samples, so they are spaced evenly based on the size of the last report.
+	 *
+	 * @param[in] report The time at which the report containing the sample was received.
+	 * @return The time of the sample.
+	 */
+	[[nodiscard]] chrono::microseconds sample_time(const chrono::microseconds report)
+	{
+		const isize index = m_received++;
+
+		if (!m_interval.has_value() || m_expected == 0)
+			return report;
+
+		// Samples beyond the size of the last report are treated as the newest ones.
+		const isize remaining = std::max(m_expected - 1 - index, isize {0});
+
+		return report - m_interval.value() * remaining / m_expected;
+	}
+
+	/*!
+	 * Counts the reports that the stored samples belong to.
+	 *
+	 * @return The number of different reports in the history.
+	 */
+	[[nodiscard]] usize reports() const
+	{
+		usize count = 0;
+
+		for (usize i = 0; i < m_history.size(); i++) {
+			if (i == 0 || m_history[i].report != m_history[i - 1].report)
+				count++;
+		}
+
+		return count;
+	}
+
+	/*!
+	 * Checks if the direction of the stylus changed sharply between the last samples.
+	 *
+	 * Extrapolating a sharp turn overshoots the corner, which is worse than not predicting.
+	 *
+	 * @return Whether the angle between the last two movements is above the limit.
+	 */
+	[[nodiscard]] bool is_turning() const
+	{
+		const usize n = m_history.size();
+
+		const Vector2<f64> a = this->position(n - 3);
+		const Vector2<f64> b = this->position(n - 2);
+		const Vector2<f64> c = this->position(n - 1);
+
+		const Vector2<f64> v1 = b - a;
+		const Vector2<f64> v2 = c - b;
+
+		const f64 norm = v1.norm() * v2.norm();
+
+		// If the stylus is not moving there is no direction to compare.
+		if (norm == 0)
+			return false;
+
+		const f64 cos = std::clamp(v1.dot(v2) / norm, -1.0, 1.0);
+		const f64 angle = std::acos(cos) * 180.0 / M_PI;
+
+		return angle > m_config.stylus_prediction_max_angle;
+	}
+
+	/*!
+	 * Extrapolates the stored samples by the configured horizon.
+	 *
+	 * @return The predicted state of the stylus, or nothing if the prediction is not plausible.
+	 */
+	[[nodiscard]] std::optional<ipts::StylusData> extrapolate() const
+	{
+		const Sample &last = m_history.back();
+		const chrono::microseconds span = last.time - m_history.front().time;
+
+		if (span <= 0us)
+			return std::nullopt;
+
+		const milliseconds<f64> horizon {m_config.stylus_prediction_horizon};
+
+		// Don't look further into the future than the history reaches into the past.
+		const f64 h = std::min(horizon, milliseconds<f64> {span}).count();
+
+		ipts::StylusData predicted = last.data;
+
+		predicted.pressure += this->slope([](const auto &d) { return d.pressure; }) * h;
+
+		/*
+		 * If the pressure is falling towards zero, the stylus is about to be lifted.
+		 * The movement while lifting is erratic, and predicting a lift would
+		 * end the stroke too early.
+		 */
+		if (predicted.pressure <= 0)
+			return std::nullopt;
+
+		predicted.pressure = std::min(predicted.pressure, 1.0);
+
+		predicted.x += this->slope([](const auto &d) { return d.x; }) * h;
+		predicted.y += this->slope([](const auto &d) { return d.y; }) * h;
+
+		predicted.x = std::clamp(predicted.x, 0.0, 1.0);
+		predicted.y = std::clamp(predicted.y, 0.0, 1.0);
+
+		const auto has_tilt = [](const Sample &s) { return s.data.altitude > 0; };
+
+		// Styli without tilt information report an altitude of zero.
+		const bool tilt = std::all_of(m_history.begin(), m_history.end(), has_tilt);
+
+		if (!tilt)
+			return predicted;
+
+		const f64 azimuth = last.data.azimuth;
+
+		// The azimuth wraps around, so look at the change relative to the newest sample.
+		const f64 dazm = this->slope([&](const auto &d) {
+			return std::remainder(d.azimuth - azimuth, 2 * M_PI);
+		});
+
+		predicted.altitude += this->slope([](const auto &d) { return d.altitude; }) * h;
+		predicted.altitude = std::clamp(predicted.altitude, 0.0, M_PI_2);
+
+		predicted.azimuth = std::fmod(azimuth + dazm * h + 2 * M_PI, 2 * M_PI);
+
+		return predicted;
+	}
+
+	/*!
+	 * Fits a line through one property of the stored samples.
+	 *
+	 * @param[in] property Selects the property from the state of the stylus.
+	 * @return The change of the property per millisecond.
+	 */
+	template <class Func>
+	[[nodiscard]] f64 slope(const Func &property) const
+	{
+		const chrono::microseconds origin = m_history.back().time;
+
+		f64 mean_t = 0;
+		f64 mean_v = 0;
+
+		for (const Sample &s : m_history) {
+			mean_t += milliseconds<f64> {s.time - origin}.count();
+			mean_v += property(s.data);
+		}
+
+		const f64 n = casts::to<f64>(m_history.size());
+
+		mean_t /= n;
+		mean_v /= n;
+
+		f64 cov = 0;
+		f64 var = 0;
+
+		for (const Sample &s : m_history) {
+			const f64 dt = milliseconds<f64> {s.time - origin}.count() - mean_t;
+
+			cov += dt * (property(s.data) - mean_v);
+			var += dt * dt;
+		}
+
+		if (var == 0)
+			return 0;
+
+		return cov / var;
+	}
+
+	/*!
+	 * The physical position of a stored sample.
+	 *
+	 * @param[in] i The index of the sample.
+	 * @return The position of the stylus in centimeters.
+	 */
+	[[nodiscard]] Vector2<f64> position(const usize i) const
+	{
+		const ipts::StylusData &data = m_history[i].data;
+		return Vector2<f64> {data.x * m_config.width, data.y * m_config.height};
+	}
+};
+
+} // namespace iptsd::core
+
+#endif // IPTSD_CORE_GENERIC_PREDICTOR_HPP
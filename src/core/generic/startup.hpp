@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CORE_GENERIC_STARTUP_HPP
+#define IPTSD_CORE_GENERIC_STARTUP_HPP
+
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace iptsd::core {
+
+/*
+ * Measures how long the individual steps of bringing up a device take.
+ *
+ * Touch input only works once all steps are done, so this is the time that users have to
+ * wait after booting or resuming. Every step lasts from the end of the previous step (or the
+ * creation of the trace) until it is recorded.
+ */
+class StartupTrace {
+public:
+	using clock = chrono::steady_clock;
+
+	struct Step {
+		// What was done during the step.
+		std::string_view name;
+
+		// How long the step took.
+		clock::duration duration;
+	};
+
+private:
+	// The time at which the last step ended.
+	clock::time_point m_last = clock::now();
+
+	// The steps that have been recorded so far.
+	std::vector<Step> m_steps {};
+
+public:
+	/*!
+	 * Ends the current step.
+	 *
+	 * @param[in] name What was done during the step. Must be a string literal.
+	 */
+	void step(const std::string_view name)
+	{
+		const clock::time_point now = clock::now();
+
+		m_steps.push_back(Step {name, now - m_last});
+		m_last = now;
+	}
+
+	/*!
+	 * Runs a function as a step of its own.
+	 *
+	 * This can be used to measure the construction of members in an initializer list.
+	 *
+	 * @param[in] name What the function does. Must be a string literal.
+	 * @param[in] func The function to run.
+	 * @return The value returned by the function.
+	 */
+	template <class Func>
+	auto measure(const std::string_view name, const Func &func) -> std::invoke_result_t<Func>
+	{
+		if constexpr (std::is_void_v<std::invoke_result_t<Func>>) {
+			func();
+			this->step(name);
+		} else {
+			auto value = func();
+			this->step(name);
+
+			return value;
+		}
+	}
+
+	/*!
+	 * The steps that have been recorded so far.
+	 */
+	[[nodiscard]] const std::vector<Step> &steps() const
+	{
+		return m_steps;
+	}
+
+	/*!
+	 * How long all recorded steps took together.
+	 */
+	[[nodiscard]] clock::duration total() const
+	{
+		clock::duration total {};
+
+		for (const Step &step : m_steps)
+			total += step.duration;
+
+		return total;
+	}
+
+	/*!
+	 * Formats the recorded steps for the log.
+	 *
+	 * @return The total time, followed by the time of every step.
+	 */
+	[[nodiscard]] std::string summary() const
+	{
+		using ms = milliseconds<f64>;
+
+		const f64 total = chrono::duration_cast<ms>(this->total()).count();
+		std::string summary = fmt::format("{:.2f}ms", total);
+
+		for (usize i = 0; i < m_steps.size(); i++) {
+			const Step &step = m_steps[i];
+			const f64 duration = chrono::duration_cast<ms>(step.duration).count();
+
+			const char *separator = i == 0 ? " (" : ", ";
+			summary += fmt::format("{}{}: {:.2f}ms", separator, step.name, duration);
+		}
+
+		if (!m_steps.empty())
+			summary += ")";
+
+		return summary;
+	}
+};
+
+} // namespace iptsd::core
+
+#endif // IPTSD_CORE_GENERIC_STARTUP_HPP
@@ -20,27 +20,28 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace iptsd::core::linux {
 
+/*
+ * Loads the configuration of a device from the preset and config files.
+ *
+ * The files are read and parsed when the loader is created. The metadata of the device, which
+ * provides the default values, is only needed when the config is assembled. This allows the
+ * files to be loaded while the metadata is still being queried from the device.
+ */
 class ConfigLoader {
 private:
-	Config m_config {};
 	DeviceInfo m_info;
 
-	bool m_loaded_config = false;
+	// The parsed config files, in the order in which they are applied.
+	std::vector<std::pair<std::filesystem::path, INIReader>> m_files {};
 
 public:
-	ConfigLoader(const DeviceInfo &info, const std::optional<const ipts::Metadata> &metadata)
-		: m_info {info}
+	ConfigLoader(const DeviceInfo &info) : m_info {info}
 	{
-		if (metadata.has_value()) {
-			m_config.width = casts::to<f64>(metadata->dimensions.width) / 1e3;
-			m_config.height = casts::to<f64>(metadata->dimensions.height) / 1e3;
-			m_config.invert_x = metadata->transform.xx < 0;
-			m_config.invert_y = metadata->transform.yy < 0;
-		}
-
 		this->load_dir(common::buildopts::PresetDir, true);
 		this->load_dir("./etc/presets", true);
 
@@ -60,18 +61,31 @@ public:
 
 		this->load_dir(common::buildopts::ConfigDir, false);
 
-		if (!m_loaded_config)
+		if (m_files.empty())
 			spdlog::info("No config file loaded, using default values.");
 	}
 
 	/*!
-	 * The loaded config object.
+	 * Assembles the config object.
 	 *
+	 * @param[in] metadata The metadata of the device, which provides the default values.
 	 * @return The configuration data that was loaded for the given device.
 	 */
-	[[nodiscard]] Config config() const
+	[[nodiscard]] Config config(const std::optional<const ipts::Metadata> &metadata) const
 	{
-		return m_config;
+		Config config {};
+
+		if (metadata.has_value()) {
+			config.width = casts::to<f64>(metadata->dimensions.width) / 1e3;
+			config.height = casts::to<f64>(metadata->dimensions.height) / 1e3;
+			config.invert_x = metadata->transform.xx < 0;
+			config.invert_y = metadata->transform.yy < 0;
+		}
+
+		for (const auto &[path, ini] : m_files)
+			this->apply(ini, config);
+
+		return config;
 	}
 
 private:
@@ -90,102 +104,121 @@ private:
 			if (!p.is_regular_file())
 				continue;
 
+			INIReader ini = parse(p.path());
+
 			if (check_device) {
 				u16 vendor = 0;
 				u16 product = 0;
 
-				this->load_device(p.path(), vendor, product);
+				this->get(ini, "Device", "Vendor", vendor);
+				this->get(ini, "Device", "Product", product);
 
 				// Ignore this file if it is meant for a different device.
 				if (m_info.vendor != vendor || m_info.product != product)
 					continue;
 			}
 
-			this->load_file(p.path());
+			spdlog::info("Loading config {}.", p.path().c_str());
+			m_files.emplace_back(p.path(), std::move(ini));
 		}
 	}
 
 	/*!
-	 * Determines for which device a config file is meant.
+	 * Loads a single configuration file.
 	 *
-	 * @param[in] path The path to the config file.
-	 * @param[out] vendor The vendor ID the config is targeting.
-	 * @param[out] product The product ID the config is targeting.
+	 * @param[in] path The file to load.
 	 */
-	void load_device(const std::filesystem::path &path, u16 &vendor, u16 &product) const
+	void load_file(const std::filesystem::path &path)
 	{
-		const INIReader ini {path};
-
-		if (ini.ParseError() != 0)
-			throw common::Error<Error::ParsingFailed> {path.c_str()};
-
-		vendor = 0;
-		product = 0;
-
-		this->get(ini, "Device", "Vendor", vendor);
-		this->get(ini, "Device", "Product", product);
+		spdlog::info("Loading config {}.", path.c_str());
+		m_files.emplace_back(path, parse(path));
 	}
 
 	/*!
-	 * Loads configuration data from a single file.
+	 * Reads and parses a config file.
 	 *
-	 * @param[in] path The file to load and parse.
+	 * @param[in] path The file to parse.
+	 * @return The parsed file.
 	 */
-	void load_file(const std::filesystem::path &path)
+	[[nodiscard]] static INIReader parse(const std::filesystem::path &path)
 	{
-		spdlog::info("Loading config {}.", path.c_str());
-
-		const INIReader ini {path};
+		INIReader ini {path};
 
 		if (ini.ParseError() != 0)
 			throw common::Error<Error::ParsingFailed> {path.c_str()};
 
+		return ini;
+	}
+
+	/*!
+	 * Applies the values from a config file.
+	 *
+	 * @param[in] ini The parsed config file.
+	 * @param[in,out] config The config object that is modified.
+	 */
+	void apply(const INIReader &ini, Config &config) const
+	{
 		// clang-format off
 
-		this->get(ini, "Config", "InvertX", m_config.invert_x);
-		this->get(ini, "Config", "InvertY", m_config.invert_y);
-		this->get(ini, "Config", "Width", m_config.width);
-		this->get(ini, "Config", "Height", m_config.height);
-
-		this->get(ini, "Touch", "Disable", m_config.touch_disable);
-		this->get(ini, "Touch", "DisableOnPalm", m_config.touch_disable_on_palm);
-		this->get(ini, "Touch", "DisableOnStylus", m_config.touch_disable_on_stylus);
-		this->get(ini, "Touch", "Overshoot", m_config.touch_overshoot);
-
-		this->get(ini, "Contacts", "Neutral", m_config.contacts_neutral);
-		this->get(ini, "Contacts", "NeutralValue", m_config.contacts_neutral_value);
-		this->get(ini, "Contacts", "ActivationThreshold", m_config.contacts_activation_threshold);
-		this->get(ini, "Contacts", "DeactivationThreshold", m_config.contacts_deactivation_threshold);
-		this->get(ini, "Contacts", "SizeThresholdMin", m_config.contacts_size_thresh_min);
-		this->get(ini, "Contacts", "SizeThresholdMax", m_config.contacts_size_thresh_max);
-		this->get(ini, "Contacts", "PositionThresholdMin", m_config.contacts_position_thresh_min);
-		this->get(ini, "Contacts", "PositionThresholdMax", m_config.contacts_position_thresh_max);
-		this->get(ini, "Contacts", "OrientationThresholdMin", m_config.contacts_orientation_thresh_min);
-		this->get(ini, "Contacts", "OrientationThresholdMax", m_config.contacts_orientation_thresh_max);
-		this->get(ini, "Contacts", "SizeMin", m_config.contacts_size_min);
-		this->get(ini, "Contacts", "SizeMax", m_config.contacts_size_max);
-		this->get(ini, "Contacts", "AspectMin", m_config.contacts_aspect_max);
-		this->get(ini, "Contacts", "AspectMax", m_config.contacts_aspect_max);
-
-		this->get(ini, "Stylus", "Disable", m_config.stylus_disable);
-		this->get(ini, "Stylus", "TipDistance", m_config.stylus_tip_distance);
-
-		this->get(ini, "DFT", "PositionMinAmp", m_config.dft_position_min_amp);
-		this->get(ini, "DFT", "PositionMinMag", m_config.dft_position_min_mag);
-		this->get(ini, "DFT", "PositionExp", m_config.dft_position_exp);
-		this->get(ini, "DFT", "ButtonMinMag", m_config.dft_button_min_mag);
-		this->get(ini, "DFT", "FreqMinMag", m_config.dft_freq_min_mag);
-		this->get(ini, "DFT", "TiltMinMag", m_config.dft_tilt_min_mag);
-		this->get(ini, "DFT", "TiltDistance", m_config.dft_tilt_distance);
-		this->get(ini, "DFT", "Mpp2ContactMinMag", m_config.dft_mpp2_contact_min_mag);
-		this->get(ini, "DFT", "Mpp2ButtonMinMag", m_config.dft_mpp2_button_min_mag);
+		this->get(ini, "Config", "InvertX", config.invert_x);
+		this->get(ini, "Config", "InvertY", config.invert_y);
+		this->get(ini, "Config", "Width", config.width);
+		this->get(ini, "Config", "Height", config.height);
+
+		this->get(ini, "Touch", "Disable", config.touch_disable);
+		this->get(ini, "Touch", "DisableOnPalm", config.touch_disable_on_palm);
+		this->get(ini, "Touch", "DisableOnStylus", config.touch_disable_on_stylus);
+		this->get(ini, "Touch", "Overshoot", config.touch_overshoot);
+
+		this->get(ini, "Contacts", "Neutral", config.contacts_neutral);
+		this->get(ini, "Contacts", "NeutralValue", config.contacts_neutral_value);
+		this->get(ini, "Contacts", "ActivationThreshold", config.contacts_activation_threshold);
+		this->get(ini, "Contacts", "DeactivationThreshold", config.contacts_deactivation_threshold);
+		this->get(ini, "Contacts", "SizeThresholdMin", config.contacts_size_thresh_min);
+		this->get(ini, "Contacts", "SizeThresholdMax", config.contacts_size_thresh_max);
+		this->get(ini, "Contacts", "PositionThresholdMin", config.contacts_position_thresh_min);
+		this->get(ini, "Contacts", "PositionThresholdMax", config.contacts_position_thresh_max);
+		this->get(ini, "Contacts", "OrientationThresholdMin", config.contacts_orientation_thresh_min);
+		this->get(ini, "Contacts", "OrientationThresholdMax", config.contacts_orientation_thresh_max);
+		this->get(ini, "Contacts", "SizeMin", config.contacts_size_min);
+		this->get(ini, "Contacts", "SizeMax", config.contacts_size_max);
+		this->get(ini, "Contacts", "AspectMin", config.contacts_aspect_max);
+		this->get(ini, "Contacts", "AspectMax", config.contacts_aspect_max);
+		this->get(ini, "Contacts", "Stabilizer", config.contacts_stabilizer);
+		this->get(ini, "Contacts", "AdaptiveMinCutoff", config.contacts_adaptive_min_cutoff);
+		this->get(ini, "Contacts", "AdaptivePositionBeta", config.contacts_adaptive_position_beta);
+		this->get(ini, "Contacts", "AdaptiveSizeBeta", config.contacts_adaptive_size_beta);
+		this->get(ini, "Contacts", "AdaptiveOrientationBeta", config.contacts_adaptive_orientation_beta);
+		this->get(ini, "Contacts", "AdaptiveDerivativeCutoff", config.contacts_adaptive_derivative_cutoff);
+		this->get(ini, "Contacts", "Baseline", config.contacts_baseline);
+		this->get(ini, "Contacts", "BaselineFrames", config.contacts_baseline_frames);
+		this->get(ini, "Contacts", "TemporalSmoothing", config.contacts_temporal_smoothing);
+		this->get(ini, "Contacts", "PyramidThreshold", config.contacts_pyramid_threshold);
+		this->get(ini, "Contacts", "ParallelThreshold", config.contacts_parallel_threshold);
+		this->get(ini, "Contacts", "Engine", config.contacts_engine);
+
+		this->get(ini, "Stylus", "Disable", config.stylus_disable);
+		this->get(ini, "Stylus", "TipDistance", config.stylus_tip_distance);
+		this->get(ini, "Stylus", "PredictionHorizon", config.stylus_prediction_horizon);
+		this->get(ini, "Stylus", "PredictionMaxAngle", config.stylus_prediction_max_angle);
+
+		this->get(ini, "DFT", "PositionMinAmp", config.dft_position_min_amp);
+		this->get(ini, "DFT", "PositionMinMag", config.dft_position_min_mag);
+		this->get(ini, "DFT", "PositionExp", config.dft_position_exp);
+		this->get(ini, "DFT", "ButtonMinMag", config.dft_button_min_mag);
+		this->get(ini, "DFT", "FreqMinMag", config.dft_freq_min_mag);
+		this->get(ini, "DFT", "TiltMinMag", config.dft_tilt_min_mag);
+		this->get(ini, "DFT", "TiltDistance", config.dft_tilt_distance);
+		this->get(ini, "DFT", "Mpp2ContactMinMag", config.dft_mpp2_contact_min_mag);
+		this->get(ini, "DFT", "Mpp2ButtonMinMag", config.dft_mpp2_button_min_mag);
+
+		this->get(ini, "Output", "SharedMemory", config.output_shared_memory);
 
 		// Legacy options that are kept for compatibility
-		this->get(ini, "DFT", "TipDistance", m_config.stylus_tip_distance);
-		this->get(ini, "Contacts", "SizeThreshold", m_config.contacts_size_thresh_max);
+		this->get(ini, "DFT", "TipDistance", config.stylus_tip_distance);
+		this->get(ini, "Contacts", "SizeThreshold", config.contacts_size_thresh_max);
 
 		// clang-format on
-		m_loaded_config = true;
 	}
 
 	/*!
@@ -11,16 +11,20 @@
 #include <common/chrono.hpp>
 #include <common/error.hpp>
 #include <core/generic/application.hpp>
+#include <core/generic/startup.hpp>
 #include <ipts/data.hpp>
+#include <hid/device.hpp>
 #include <ipts/device.hpp>
 
 #include <spdlog/spdlog.h>
 
 #include <atomic>
 #include <filesystem>
+#include <future>
 #include <memory>
 #include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace iptsd::core::linux {
@@ -31,8 +35,11 @@ private:
 	static_assert(std::is_base_of_v<Application, T>);
 
 private:
-	// The hidraw device serving as the source of data.
-	std::shared_ptr<HidrawDevice> m_device;
+	// Measures how long it takes to bring up the device.
+	StartupTrace m_startup {};
+
+	// The HID device serving as the source of data.
+	std::shared_ptr<hid::Device> m_device;
 
 	// The IPTS touchscreen interface
 	ipts::Device m_ipts;
@@ -53,25 +60,20 @@ private:
 public:
 	template <class... Args>
 	DeviceRunner(const std::filesystem::path &path, Args... args)
-		: m_device {std::make_shared<HidrawDevice>(path)},
-		  m_ipts {m_device}
+		: m_device {m_startup.measure("Open", [&]() { return open(path); })},
+		  m_ipts {m_startup.measure("Descriptor",
+		                            [&]() { return ipts::Device {m_device}; })}
 	{
-		DeviceInfo info {};
-		info.vendor = m_device->vendor();
-		info.product = m_device->product();
-		info.buffer_size = m_ipts.buffer_size();
-
-		const std::optional<const ipts::Metadata> meta = m_ipts.metadata();
-
-		const ConfigLoader loader {info, meta};
-		m_application.emplace(loader.config(), info, meta, args...);
-
-		m_buffer.resize(casts::to<usize>(info.buffer_size));
-
-		const u16 vendor = info.vendor;
-		const u16 product = info.product;
+		this->init(args...);
+	}
 
-		spdlog::info("Connected to device {:04X}:{:04X}", vendor, product);
+	template <class... Args>
+	DeviceRunner(std::shared_ptr<hid::Device> device, Args... args)
+		: m_device {std::move(device)},
+		  m_ipts {m_startup.measure("Descriptor",
+		                            [&]() { return ipts::Device {m_device}; })}
+	{
+		this->init(args...);
 	}
 
 	/*!
@@ -89,6 +91,16 @@ public:
 		return m_application.value();
 	}
 
+	/*!
+	 * How long the steps of bringing up the device took.
+	 *
+	 * The last step, switching the device to multitouch mode, is done by @ref run.
+	 */
+	[[nodiscard]] const StartupTrace &startup() const
+	{
+		return m_startup;
+	}
+
 	/*!
 	 * Stops the loop that reads from the device.
 	 *
@@ -111,8 +123,12 @@ public:
 
 		// Enable multitouch mode
 		m_ipts.set_mode(ipts::Mode::Multitouch);
+		m_startup.step("Mode");
+
+		spdlog::info("Device is ready after {}", m_startup.summary());
 
 		// Signal the application that the data flow has started.
+		m_application->reset();
 		m_application->on_start();
 
 		usize errors = 0;
@@ -123,16 +139,10 @@ public:
 				break;
 			}
 
-			try {
-				const isize size = m_device->read(m_buffer);
-				const gsl::span<u8> data {m_buffer.data(),
-				                          casts::to_unsigned(size)};
-
-				// Does this report contain touch data?
-				if (!m_ipts.is_touch_data(m_buffer))
-					continue;
+			isize size = 0;
 
-				m_application->process(data);
+			try {
+				size = m_device->read(m_buffer);
 			} catch (const std::exception &e) {
 				spdlog::warn(e.what());
 
@@ -145,6 +155,19 @@ public:
 
 			// Reset error count.
 			errors = 0;
+
+			// Does this report contain touch data?
+			if (!m_ipts.is_touch_data(m_buffer))
+				continue;
+
+			const gsl::span<u8> data {m_buffer.data(), casts::to_unsigned(size)};
+
+			try {
+				m_application->process(data);
+			} catch (const std::exception &e) {
+				// The device is fine, so there is no need to wait before reading again.
+				spdlog::warn(e.what());
+			}
 		}
 
 		spdlog::info("Stopping");
@@ -161,6 +184,54 @@ public:
 
 		return m_should_stop;
 	}
+
+private:
+	/*!
+	 * Opens a hidraw device.
+	 *
+	 * @param[in] path The path to the device node.
+	 * @return The opened device.
+	 */
+	[[nodiscard]] static std::shared_ptr<hid::Device> open(const std::filesystem::path &path)
+	{
+		return std::make_shared<HidrawDevice>(path);
+	}
+
+	/*!
+	 * Loads the config and creates the application.
+	 *
+	 * @param[in] args Additional arguments that are passed to the application.
+	 */
+	template <class... Args>
+	void init(Args... args)
+	{
+		DeviceInfo info {};
+		info.vendor = m_device->vendor();
+		info.product = m_device->product();
+		info.buffer_size = m_ipts.buffer_size();
+
+		/*
+		 * Querying the metadata has to wait for the firmware of the device.
+		 * The config files don't depend on it, so they are loaded in the meantime.
+		 */
+		auto metadata = std::async(std::launch::async, [&]() { return m_ipts.metadata(); });
+
+		const ConfigLoader loader {info};
+		m_startup.step("Config");
+
+		const std::optional<const ipts::Metadata> meta = metadata.get();
+		m_startup.step("Metadata");
+
+		m_application.emplace(loader.config(meta), info, meta, args...);
+		m_startup.step("Application");
+
+		m_buffer.resize(casts::to<usize>(info.buffer_size));
+
+		const u16 vendor = info.vendor;
+		const u16 product = info.product;
+
+		spdlog::info("Connected to device {:04X}:{:04X}", vendor, product);
+	}
 };
 
 } // namespace iptsd::core::linux
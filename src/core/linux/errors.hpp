@@ -20,6 +20,20 @@ enum class Error : u8 {
 	SyscallCloseFailed,
 	SyscallIoctlFailed,
 	SyscallSigactionFailed,
+	SyscallPollFailed,
+	SyscallTruncateFailed,
+	SyscallMmapFailed,
+	SyscallMunmapFailed,
+	SyscallUnlinkFailed,
+
+	EventNodeNotFound,
+	UhidDescriptorTooLarge,
+
+	MockDeviceEmpty,
+	MockDeviceFault,
+	MockDeviceInvalidReport,
+
+	RingInvalidName,
 };
 
 inline std::string format_as(Error err)
@@ -43,6 +57,28 @@ inline std::string format_as(Error err)
 		return "core: linux: IOCTL {} failed: {}";
 	case Error::SyscallSigactionFailed:
 		return "core: linux: Sigaction for signal {} failed: {}";
+	case Error::SyscallPollFailed:
+		return "core: linux: Polling files failed: {}";
+	case Error::SyscallTruncateFailed:
+		return "core: linux: Resizing file failed: {}";
+	case Error::SyscallMmapFailed:
+		return "core: linux: Mapping file into memory failed: {}";
+	case Error::SyscallMunmapFailed:
+		return "core: linux: Unmapping memory failed: {}";
+	case Error::SyscallUnlinkFailed:
+		return "core: linux: Removing file {} failed: {}";
+	case Error::EventNodeNotFound:
+		return "core: linux: No event node found for input device {}!";
+	case Error::UhidDescriptorTooLarge:
+		return "core: linux: The HID descriptor of {} is too large for uhid!";
+	case Error::MockDeviceEmpty:
+		return "core: linux: Data file {} does not contain any reports!";
+	case Error::MockDeviceFault:
+		return "core: linux: Simulated failure while reading from {}!";
+	case Error::MockDeviceInvalidReport:
+		return "core: linux: Unsupported feature report for mock device {}!";
+	case Error::RingInvalidName:
+		return "core: linux: Invalid name for the shared memory ring: '{}'!";
 	default:
 		return "core: linux: Invalid error code!";
 	}
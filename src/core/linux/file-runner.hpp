@@ -6,25 +6,59 @@
 #include "config-loader.hpp"
 
 #include <common/casts.hpp>
+#include <common/chrono.hpp>
 #include <common/reader.hpp>
 #include <core/generic/application.hpp>
 #include <ipts/data.hpp>
+#include <ipts/protocol/hid.hpp>
+#include <ipts/timeline.hpp>
 
+#include <gsl/gsl>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <optional>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
 namespace iptsd::core::linux {
 
+/*
+ * How precisely the reports of a paced replay were passed to the application.
+ */
+struct Pacing {
+	// The number of reports that were scheduled.
+	usize count = 0;
+
+	// The summed delay between the scheduled time of the reports and when they were processed.
+	chrono::nanoseconds total {};
+
+	// The largest delay between the scheduled time of a report and when it was processed.
+	chrono::nanoseconds max {};
+
+	/*!
+	 * The average delay between the scheduled time of a report and when it was processed.
+	 */
+	[[nodiscard]] chrono::nanoseconds mean() const
+	{
+		if (count == 0)
+			return chrono::nanoseconds {0};
+
+		return total / casts::to_signed(count);
+	}
+};
+
 template <class T>
 class FileRunner {
 private:
 	static_assert(std::is_base_of_v<Application, T>);
 
+	using clock = chrono::steady_clock;
+
 private:
 	// The contents of the file.
 	std::vector<u8> m_file {};
@@ -35,6 +69,15 @@ private:
 	// Whether the loop for reading from the file should stop.
 	std::atomic_bool m_should_stop = false;
 
+	// How fast the reports are replayed relative to how they were recorded.
+	std::optional<f64> m_speed = std::nullopt;
+
+	// Converts the timestamps of the reports into the time at which they are replayed.
+	ipts::Timeline m_timeline {};
+
+	// How precisely the reports of the last run were replayed.
+	Pacing m_pacing {};
+
 	/*
 	 * deferred initialization
 	 */
@@ -63,8 +106,8 @@ public:
 		if (has_meta)
 			meta = m_reader->read<ipts::Metadata>();
 
-		const ConfigLoader loader {m_info, meta};
-		m_application.emplace(loader.config(), m_info, meta, args...);
+		const ConfigLoader loader {m_info};
+		m_application.emplace(loader.config(meta), m_info, meta, args...);
 
 		const u16 vendor = m_info.vendor;
 		const u16 product = m_info.product;
@@ -87,6 +130,30 @@ public:
 		return m_application.value();
 	}
 
+	/*!
+	 * Replays the reports at the speed at which they were recorded.
+	 *
+	 * The time between two reports is taken from the timestamps in their header.
+	 * This exposes effects that don't happen when processing as fast as possible,
+	 * like the CPU clocking down or caches going cold in between reports.
+	 *
+	 * @param[in] speed A factor for the replay speed. If it is not set, reports are not paced.
+	 */
+	void pace(const std::optional<f64> speed)
+	{
+		m_speed = speed;
+	}
+
+	/*!
+	 * How precisely the reports of the last run were replayed.
+	 *
+	 * @return The delay statistics of the last run. Empty if the reports were not paced.
+	 */
+	[[nodiscard]] const Pacing &pacing() const
+	{
+		return m_pacing;
+	}
+
 	/*!
 	 * Stops the loop that reads from the file.
 	 *
@@ -110,7 +177,13 @@ public:
 
 		Reader local = m_reader.value();
 
+		m_timeline.reset();
+		m_pacing = Pacing {};
+
+		const clock::time_point start = clock::now();
+
 		// Signal the application that the data flow has started.
+		m_application->reset();
 		m_application->on_start();
 
 		while (!m_should_stop && local.size() > 0) {
@@ -129,8 +202,12 @@ public:
 				 * instead of writing the entire buffer all the time.
 				 */
 				Reader buffer = local.sub(casts::to<usize>(m_info.buffer_size));
+				const auto data = buffer.subspan<u8>(casts::to<usize>(size));
+
+				if (m_speed.has_value())
+					this->wait(data, start);
 
-				m_application->process(buffer.subspan<u8>(casts::to<usize>(size)));
+				m_application->process(data);
 			} catch (const std::exception &e) {
 				spdlog::warn(e.what());
 			}
@@ -144,6 +221,34 @@ public:
 
 		return m_should_stop;
 	}
+
+private:
+	/*!
+	 * Waits until a report should be replayed.
+	 *
+	 * @param[in] data The report.
+	 * @param[in] start The time at which the replay was started.
+	 */
+	void wait(const gsl::span<u8> data, const clock::time_point start)
+	{
+		if (data.size() < sizeof(ipts::protocol::hid::ReportHeader))
+			return;
+
+		Reader reader {data};
+		const auto header = reader.read<ipts::protocol::hid::ReportHeader>();
+
+		const seconds<f64> offset = m_timeline.update(header.timestamp) / m_speed.value();
+		const clock::time_point target =
+			start + chrono::duration_cast<clock::duration>(offset);
+
+		std::this_thread::sleep_until(target);
+
+		const chrono::nanoseconds delay = clock::now() - target;
+
+		m_pacing.count++;
+		m_pacing.total += delay;
+		m_pacing.max = std::max(m_pacing.max, delay);
+	}
 };
 
 } // namespace iptsd::core::linux
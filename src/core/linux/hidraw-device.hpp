@@ -17,6 +17,7 @@
 #include <linux/hidraw.h>
 
 #include <filesystem>
+#include <optional>
 #include <vector>
 
 namespace iptsd::core::linux {
@@ -29,7 +30,8 @@ private:
 	struct hidraw_devinfo m_devinfo {};
 	struct hidraw_report_descriptor m_desc {};
 
-	std::vector<hid::Report> m_reports {};
+	// The parsed descriptor. It is only parsed when it is needed for the first time.
+	std::optional<std::vector<hid::Report>> m_reports = std::nullopt;
 
 public:
 	HidrawDevice(const std::filesystem::path &path)
@@ -43,8 +45,6 @@ public:
 
 		m_desc.size = desc_size;
 		syscalls::ioctl(m_fd, HIDIOCGRDESC, &m_desc);
-
-		hid::parse(gsl::span<u8> {&m_desc.value[0], desc_size}, m_reports);
 	}
 
 	~HidrawDevice() override
@@ -93,7 +93,10 @@ public:
 	 */
 	const std::vector<hid::Report> &descriptor() override
 	{
-		return m_reports;
+		if (!m_reports.has_value())
+			m_reports = hid::parse(gsl::span<u8> {&m_desc.value[0], m_desc.size});
+
+		return m_reports.value();
 	}
 
 	/*!
@@ -0,0 +1,460 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CORE_LINUX_MOCK_DEVICE_HPP
+#define IPTSD_CORE_LINUX_MOCK_DEVICE_HPP
+
+#include "errors.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/error.hpp>
+#include <common/reader.hpp>
+#include <common/types.hpp>
+#include <core/generic/device.hpp>
+#include <hid/device.hpp>
+#include <hid/report.hpp>
+#include <ipts/data.hpp>
+#include <ipts/protocol/descriptor.hpp>
+#include <ipts/protocol/hid.hpp>
+#include <ipts/protocol/metadata.hpp>
+#include <ipts/timeline.hpp>
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace iptsd::core::linux {
+
+/*
+ * A HID device that replays the reports of a binary data file from memory.
+ *
+ * Data files don't contain the HID descriptor of the device they were recorded from,
+ * so a minimal descriptor is derived from the data: One touch data report for every
+ * report ID that appears in the file, a modesetting report and, if the file contains
+ * metadata, a metadata report.
+ *
+ * This allows running the full device code path (e.g. through a DeviceRunner)
+ * without any hardware, for example for benchmarking or for testing error recovery.
+ */
+class MockDevice : public hid::Device {
+private:
+	using clock = chrono::steady_clock;
+
+public:
+	// The callback that is invoked after the last report of the file was read.
+	std::function<void()> on_wrap;
+
+private:
+	// The path of the data file.
+	std::string m_name;
+
+	// The contents of the data file.
+	std::vector<u8> m_file {};
+
+	// Information about the device that produced the data.
+	DeviceInfo m_info {};
+
+	// The metadata of the device that produced the data.
+	std::optional<ipts::Metadata> m_metadata = std::nullopt;
+
+	// The reports that are replayed.
+	std::vector<gsl::span<u8>> m_data {};
+
+	// The descriptor that was derived from the data.
+	std::vector<hid::Report> m_reports {};
+
+	// The report ID of the modesetting report.
+	u8 m_modesetting_id = 0;
+
+	// The report ID of the metadata report.
+	u8 m_metadata_id = 0;
+
+	// The mode that was set through the modesetting report.
+	u8 m_mode = 0;
+
+	// The index of the next report that is read.
+	usize m_index = 0;
+
+	// How fast the reports are replayed relative to how they were recorded.
+	std::optional<f64> m_speed = std::nullopt;
+
+	// The fixed time between two reports.
+	std::optional<clock::duration> m_interval = std::nullopt;
+
+	// Converts the timestamps of the reports into the time at which they are read.
+	ipts::Timeline m_timeline {};
+
+	// The time at which the first report of the current pass through the file was read.
+	std::optional<clock::time_point> m_start = std::nullopt;
+
+	// The time at which the next report is read if the interval is fixed.
+	clock::time_point m_next {};
+
+	// The time at which the current report is read, once it was determined.
+	std::optional<clock::time_point> m_due = std::nullopt;
+
+	// Every n-th read fails, if set.
+	usize m_failure_rate = 0;
+
+	// The total number of reads.
+	usize m_reads = 0;
+
+public:
+	MockDevice(const std::filesystem::path &path) : m_name {path.string()}
+	{
+		std::ifstream ifs {};
+		ifs.open(path, std::ios::in | std::ios::binary);
+
+		std::noskipws(ifs);
+		m_file = std::vector<u8> {std::istream_iterator<u8>(ifs),
+		                          std::istream_iterator<u8>()};
+
+		Reader reader {m_file};
+		m_info = reader.read<DeviceInfo>();
+
+		const auto has_meta = reader.read<u8>();
+		if (has_meta)
+			m_metadata = reader.read<ipts::Metadata>();
+
+		const usize buffer_size = casts::to<usize>(m_info.buffer_size);
+
+		while (reader.size() >= sizeof(u64) + buffer_size) {
+			const auto size = reader.read<u64>();
+
+			// The data file contains the entire buffer, even if the report was smaller.
+			Reader buffer = reader.sub(buffer_size);
+			const usize length = std::min(casts::to<usize>(size), buffer_size);
+			const auto data = buffer.subspan<u8>(length);
+
+			if (!data.empty())
+				m_data.push_back(data);
+		}
+
+		if (m_data.empty())
+			throw common::Error<Error::MockDeviceEmpty> {m_name};
+
+		this->create_descriptor();
+	}
+
+	/*!
+	 * The "name", aka. the path of the data file.
+	 */
+	std::string_view name() override
+	{
+		return m_name;
+	}
+
+	/*!
+	 * The vendor ID of the device that produced the data.
+	 */
+	u16 vendor() override
+	{
+		return m_info.vendor;
+	}
+
+	/*!
+	 * The product ID of the device that produced the data.
+	 */
+	u16 product() override
+	{
+		return m_info.product;
+	}
+
+	/*!
+	 * The HID descriptor that was derived from the data.
+	 */
+	const std::vector<hid::Report> &descriptor() override
+	{
+		return m_reports;
+	}
+
+	/*!
+	 * The number of reports in the data file.
+	 */
+	[[nodiscard]] usize size() const
+	{
+		return m_data.size();
+	}
+
+	/*!
+	 * The mode that was last set through the modesetting report.
+	 */
+	[[nodiscard]] u8 mode() const
+	{
+		return m_mode;
+	}
+
+	/*!
+	 * Reads reports at the speed at which they were recorded.
+	 *
+	 * The time between two reports is taken from the timestamps in their header.
+	 *
+	 * @param[in] speed A factor for the replay speed. If it is not set, reports are not paced.
+	 */
+	void pace(const std::optional<f64> speed)
+	{
+		m_speed = speed;
+		m_start = std::nullopt;
+		m_due = std::nullopt;
+	}
+
+	/*!
+	 * Reads reports with a fixed time in between them.
+	 *
+	 * Only used if the reports are not paced by their timestamps.
+	 *
+	 * @param[in] interval The time between two reports. If not set, reports are not paced.
+	 */
+	void interval(const std::optional<clock::duration> interval)
+	{
+		m_interval = interval;
+		m_start = std::nullopt;
+		m_due = std::nullopt;
+	}
+
+	/*!
+	 * Determines when the next report is read.
+	 *
+	 * This allows waiting for the next report without blocking in @ref read.
+	 *
+	 * @return The time at which the next report is read, or nothing if reports are not paced.
+	 */
+	std::optional<clock::time_point> due()
+	{
+		if (!m_speed.has_value() && !m_interval.has_value())
+			return std::nullopt;
+
+		if (m_due.has_value())
+			return m_due;
+
+		const clock::time_point now = clock::now();
+
+		if (!m_start.has_value()) {
+			m_start = now;
+			m_next = now;
+			m_timeline.reset();
+		}
+
+		const gsl::span<u8> data = m_data[m_index];
+
+		if (m_speed.has_value()) {
+			if (data.size() < sizeof(ipts::protocol::hid::ReportHeader)) {
+				m_due = now;
+				return m_due;
+			}
+
+			Reader reader {data};
+			const auto header = reader.read<ipts::protocol::hid::ReportHeader>();
+
+			const chrono::microseconds elapsed = m_timeline.update(header.timestamp);
+			const seconds<f64> offset = elapsed / m_speed.value();
+			const auto delay = chrono::duration_cast<clock::duration>(offset);
+
+			m_due = m_start.value() + delay;
+		} else {
+			m_due = m_next;
+			m_next += m_interval.value();
+		}
+
+		return m_due;
+	}
+
+	/*!
+	 * Makes reading from the device fail regularly.
+	 *
+	 * @param[in] rate Every n-th read fails. Zero disables failures.
+	 */
+	void fail_every(const usize rate)
+	{
+		m_failure_rate = rate;
+	}
+
+	/*!
+	 * Reads the next report from the data file.
+	 *
+	 * After the last report, reading starts again from the beginning of the file.
+	 *
+	 * @param[in] buffer The target storage for the report.
+	 * @return The size of the report that was read in bytes.
+	 */
+	isize read(const gsl::span<u8> buffer) override
+	{
+		m_reads++;
+
+		if (m_failure_rate > 0 && m_reads % m_failure_rate == 0)
+			throw common::Error<Error::MockDeviceFault> {m_name};
+
+		const std::optional<clock::time_point> due = this->due();
+		m_due = std::nullopt;
+
+		if (due.has_value())
+			std::this_thread::sleep_until(due.value());
+
+		const gsl::span<u8> data = m_data[m_index];
+		const usize size = std::min(data.size(), buffer.size());
+		std::copy_n(data.begin(), size, buffer.begin());
+
+		m_index++;
+
+		if (m_index == m_data.size()) {
+			m_index = 0;
+			m_start = std::nullopt;
+
+			if (on_wrap)
+				on_wrap();
+		}
+
+		return casts::to_signed(size);
+	}
+
+	/*!
+	 * Gets the data of a HID feature report.
+	 *
+	 * @param[in] report The report ID to get, followed by enough space to fit the data.
+	 */
+	void get_feature(const gsl::span<u8> report) override
+	{
+		if (report.empty())
+			throw common::Error<Error::MockDeviceInvalidReport> {m_name};
+
+		const u8 id = report[0];
+
+		if (id == m_modesetting_id && report.size() >= 2) {
+			report[1] = m_mode;
+			return;
+		}
+
+		if (id != m_metadata_id || !m_metadata.has_value())
+			throw common::Error<Error::MockDeviceInvalidReport> {m_name};
+
+		const std::vector<u8> data = this->metadata_report();
+
+		if (report.size() < data.size())
+			throw common::Error<Error::MockDeviceInvalidReport> {m_name};
+
+		std::copy(data.begin(), data.end(), report.begin());
+	}
+
+	/*!
+	 * Sets the data of a HID feature report.
+	 *
+	 * @param[in] report The report ID to set, followed by the new data.
+	 */
+	void set_feature(const gsl::span<u8> report) override
+	{
+		if (report.size() < 2 || report[0] != m_modesetting_id)
+			throw common::Error<Error::MockDeviceInvalidReport> {m_name};
+
+		m_mode = report[1];
+	}
+
+private:
+	/*!
+	 * Derives a HID descriptor from the reports of the data file.
+	 */
+	void create_descriptor()
+	{
+		namespace descriptor = ipts::protocol::descriptor;
+
+		std::set<u8> ids {};
+
+		for (const gsl::span<u8> data : m_data)
+			ids.insert(data[0]);
+
+		const u32 buffer_size = casts::to<u32>(m_info.buffer_size);
+
+		const std::vector<hid::Usage> touch {
+			{descriptor::USAGE_PAGE_DIGITIZER, descriptor::USAGE_SCAN_TIME},
+			{descriptor::USAGE_PAGE_DIGITIZER, descriptor::USAGE_GESTURE_DATA},
+		};
+
+		for (const u8 id : ids)
+			m_reports.emplace_back(hid::ReportType::Input, id, buffer_size, 8, touch);
+
+		// The feature reports use the first IDs that are not taken by touch data.
+		const auto unused = [&]() {
+			u8 id = 1;
+
+			while (ids.count(id) > 0)
+				id++;
+
+			ids.insert(id);
+			return id;
+		};
+
+		const std::vector<hid::Usage> set_mode {
+			{descriptor::USAGE_PAGE_VENDOR, descriptor::USAGE_SET_MODE},
+		};
+
+		m_modesetting_id = unused();
+		m_reports.emplace_back(hid::ReportType::Feature, m_modesetting_id, 1, 8, set_mode);
+
+		if (!m_metadata.has_value())
+			return;
+
+		const std::vector<hid::Usage> metadata {
+			{descriptor::USAGE_PAGE_DIGITIZER, descriptor::USAGE_METADATA},
+		};
+
+		m_metadata_id = unused();
+
+		// The report ID is not part of the report size.
+		const u32 size = casts::to<u32>(this->metadata_report().size() - 1);
+
+		m_reports.emplace_back(hid::ReportType::Feature, m_metadata_id, size, 8, metadata);
+	}
+
+	/*!
+	 * Serializes the metadata into the format of the metadata feature report.
+	 *
+	 * @return The report ID, followed by a HID frame containing the metadata.
+	 */
+	[[nodiscard]] std::vector<u8> metadata_report() const
+	{
+		const ipts::Metadata &meta = m_metadata.value();
+
+		std::vector<u8> payload {};
+		append(payload, meta.dimensions);
+		append(payload, meta.unknown_byte);
+		append(payload, meta.transform);
+		append(payload, meta.unknown);
+
+		ipts::protocol::hid::Frame frame {};
+		frame.size = casts::to<u32>(sizeof(frame) + payload.size());
+		frame.type = ipts::protocol::hid::FrameType::Metadata;
+
+		std::vector<u8> report {m_metadata_id};
+		append(report, frame);
+
+		report.insert(report.end(), payload.begin(), payload.end());
+		return report;
+	}
+
+	/*!
+	 * Appends the binary representation of a value to a buffer.
+	 *
+	 * @param[in] buffer The buffer to append to.
+	 * @param[in] value The value to append.
+	 */
+	template <class T>
+	static void append(std::vector<u8> &buffer, const T &value)
+	{
+		const usize offset = buffer.size();
+
+		buffer.resize(offset + sizeof(T));
+		std::memcpy(&buffer[offset], &value, sizeof(T));
+	}
+};
+
+} // namespace iptsd::core::linux
+
+#endif // IPTSD_CORE_LINUX_MOCK_DEVICE_HPP
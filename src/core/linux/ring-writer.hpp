@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_CORE_LINUX_RING_WRITER_HPP
+#define IPTSD_CORE_LINUX_RING_WRITER_HPP
+
+#include "errors.hpp"
+#include "syscalls.hpp"
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/error.hpp>
+#include <common/types.hpp>
+#include <contacts/contact.hpp>
+#include <core/generic/config.hpp>
+#include <core/generic/device.hpp>
+#include <ipts/data.hpp>
+#include <ring/layout.hpp>
+
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+
+#include <grp.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <limits>
+#include <new>
+#include <optional>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace iptsd::core::linux {
+
+/*
+ * Publishes the processed data into a ring in shared memory.
+ *
+ * Other programs can map the ring and read the frames without any syscalls.
+ * See ring/layout.hpp for the format, and ring/reader.hpp for a library to read it.
+ */
+class RingWriter {
+public:
+	// How many frames are kept in the ring.
+	static constexpr u32 SLOTS = 64;
+
+	// The slots are aligned to cache lines, so that writing one doesn't slow down the others.
+	static constexpr usize ALIGNMENT = 64;
+
+private:
+	// The file of the ring.
+	std::filesystem::path m_path;
+
+	// The mapped memory of the ring.
+	gsl::span<std::byte> m_data {};
+
+	// The header at the start of the ring.
+	ring::Header *m_header = nullptr;
+
+	// The current state, which is copied into the ring for every frame.
+	ring::Frame m_frame {};
+
+public:
+	/*!
+	 * Creates the ring.
+	 *
+	 * @param[in] name The name of the ring. It is created as a file in /dev/shm.
+	 * @param[in] config The configuration, providing the size of the screen.
+	 * @param[in] info The device that produces the data.
+	 */
+	RingWriter(const std::string &name, const Config &config, const DeviceInfo &info)
+		: m_path {path(name)}
+	{
+		const usize header_size = align(sizeof(ring::Header));
+		const usize slot_size = align(sizeof(ring::Slot));
+		const usize size = header_size + slot_size * SLOTS;
+
+		/*
+		 * Readers of a previous instance keep their mapping of the old file, so it must
+		 * not be reused. Resizing it would crash them.
+		 */
+		if (::unlink(m_path.c_str()) == -1 && errno != ENOENT) {
+			const std::string error = syscalls::impl::last_error();
+			throw common::Error<Error::SyscallUnlinkFailed> {m_path.c_str(), error};
+		}
+
+		const int flags = O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC;
+		const int fd = syscalls::open(m_path, flags, S_IRUSR | S_IWUSR);
+		const auto _close = gsl::finally([&]() { syscalls::close(fd); });
+
+		this->restrict(fd);
+
+		// The new file is filled with zeros, so all slots are empty.
+		syscalls::ftruncate(fd, size);
+
+		void *data = syscalls::mmap(fd, size, PROT_READ | PROT_WRITE);
+		m_data = gsl::span<std::byte> {static_cast<std::byte *>(data), size};
+
+		m_header = new (m_data.data()) ring::Header {};
+		m_header->version = ring::VERSION;
+		m_header->header_size = casts::to<u32>(header_size);
+		m_header->slot_size = casts::to<u32>(slot_size);
+		m_header->slot_count = SLOTS;
+		m_header->max_contacts = ring::MAX_CONTACTS;
+		m_header->vendor = info.vendor;
+		m_header->product = info.product;
+		m_header->width = config.width;
+		m_header->height = config.height;
+
+		for (u32 i = 0; i < SLOTS; i++)
+			new (this->slot(i)) ring::Slot {};
+
+		m_header->active.store(1, std::memory_order_relaxed);
+
+		// Readers treat the ring as ready once they see the magic, so it is written last.
+		m_header->magic.store(ring::MAGIC, std::memory_order_release);
+
+		spdlog::info("Publishing to shared memory at {}", m_path.c_str());
+	}
+
+	RingWriter(const RingWriter &) = delete;
+	RingWriter &operator=(const RingWriter &) = delete;
+
+	RingWriter(RingWriter &&) = delete;
+	RingWriter &operator=(RingWriter &&) = delete;
+
+	~RingWriter()
+	{
+		m_header->active.store(0, std::memory_order_release);
+
+		try {
+			syscalls::munmap(m_data.data(), m_data.size());
+			syscalls::unlink(m_path);
+		} catch (const std::exception &e) {
+			spdlog::warn(e.what());
+		}
+	}
+
+	/*!
+	 * Publishes a frame with new contacts.
+	 *
+	 * @param[in] contacts The contacts that were found on the current heatmap.
+	 * @param[in] time When the device sent the heatmap.
+	 */
+	void update(const std::vector<contacts::Contact<f64>> &contacts,
+	            const chrono::microseconds time)
+	{
+		const usize count = std::min<usize>(contacts.size(), ring::MAX_CONTACTS);
+		const usize untracked = std::numeric_limits<u32>::max();
+
+		for (usize i = 0; i < count; i++) {
+			const contacts::Contact<f64> &contact = contacts[i];
+			ring::Contact &out = m_frame.contacts.at(i);
+
+			out.x = contact.mean.x();
+			out.y = contact.mean.y();
+			out.major = contact.size.x();
+			out.minor = contact.size.y();
+			out.orientation = contact.orientation;
+			out.index = casts::to<u32>(contact.index.value_or(untracked));
+			out.valid = state(contact.valid);
+			out.stable = state(contact.stable);
+		}
+
+		m_frame.flags = ring::flags::CONTACTS;
+		m_frame.contact_count = casts::to<u32>(count);
+
+		if (count < contacts.size())
+			m_frame.flags |= ring::flags::TRUNCATED;
+
+		this->publish(time);
+	}
+
+	/*!
+	 * Publishes a frame with a new state of the stylus.
+	 *
+	 * @param[in] stylus The current state of the stylus.
+	 * @param[in] time When the device sent the stylus data.
+	 */
+	void update(const ipts::StylusData &stylus, const chrono::microseconds time)
+	{
+		ring::Stylus &out = m_frame.stylus;
+
+		out.proximity = stylus.proximity ? 1 : 0;
+		out.contact = stylus.contact ? 1 : 0;
+		out.button = stylus.button ? 1 : 0;
+		out.rubber = stylus.rubber ? 1 : 0;
+		out.serial = stylus.serial;
+		out.x = stylus.x;
+		out.y = stylus.y;
+		out.pressure = stylus.pressure;
+		out.altitude = stylus.altitude;
+		out.azimuth = stylus.azimuth;
+
+		// The contacts stay the same, but the flag only refers to this frame.
+		m_frame.flags = ring::flags::STYLUS;
+
+		this->publish(time);
+	}
+
+private:
+	/*!
+	 * Copies the current state into the next slot of the ring.
+	 *
+	 * @param[in] time When the device sent the data.
+	 */
+	void publish(const chrono::microseconds time)
+	{
+		using ns = chrono::nanoseconds;
+
+		const u64 sequence = m_header->head.load(std::memory_order_relaxed);
+		const ns now = chrono::steady_clock::now().time_since_epoch();
+
+		m_frame.sequence = sequence;
+		m_frame.time = casts::to<u64>(chrono::duration_cast<ns>(now).count());
+		m_frame.report_time = casts::to<u64>(time.count());
+
+		ring::Slot *slot = this->slot(sequence % SLOTS);
+
+		slot->lock.store(sequence * 2 + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// The unused contacts are not copied.
+		const usize unused = ring::MAX_CONTACTS - m_frame.contact_count;
+		const usize size = sizeof(ring::Frame) - unused * sizeof(ring::Contact);
+
+		std::memcpy(&slot->frame, &m_frame, size);
+
+		slot->lock.store(sequence * 2 + 2, std::memory_order_release);
+		m_header->head.store(sequence + 1, std::memory_order_release);
+	}
+
+	/*!
+	 * Returns a slot of the ring.
+	 *
+	 * @param[in] index The index of the slot.
+	 * @return A pointer to the slot.
+	 */
+	[[nodiscard]] ring::Slot *slot(const u64 index) const
+	{
+		const u64 offset = m_header->header_size + index * m_header->slot_size;
+		std::byte *data = m_data.subspan(casts::to<usize>(offset)).data();
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return reinterpret_cast<ring::Slot *>(data);
+	}
+
+	/*!
+	 * Restricts who can read the ring.
+	 *
+	 * Like the input devices, the ring can only be read by the input group. If the group
+	 * does not exist, only the owner can read it.
+	 *
+	 * @param[in] fd The file descriptor of the ring.
+	 */
+	void restrict(const int fd) const
+	{
+		std::array<char, 1024> buffer {};
+
+		struct group group {};
+		struct group *result = nullptr;
+
+		::getgrnam_r("input", &group, buffer.data(), buffer.size(), &result);
+
+		const uid_t owner = static_cast<uid_t>(-1);
+
+		// The file was created with access for the owner only.
+		if (result == nullptr || ::fchown(fd, owner, result->gr_gid) == -1) {
+			spdlog::warn("Could not give the input group access to {}", m_path.c_str());
+			return;
+		}
+
+		if (::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP) == -1) {
+			const std::string error = syscalls::impl::last_error();
+			const char *path = m_path.c_str();
+
+			spdlog::warn("Could not change the permissions of {}: {}", path, error);
+		}
+	}
+
+	/*!
+	 * Determines the file of the ring.
+	 *
+	 * The name comes from the config, but the daemon runs as root and removes the file
+	 * if it exists. It must not be able to refer to a file outside of the directory.
+	 *
+	 * @param[in] name The name of the ring.
+	 * @return The path of the file in /dev/shm.
+	 */
+	[[nodiscard]] static std::filesystem::path path(const std::string &name)
+	{
+		const bool special = name == "." || name == "..";
+
+		if (name.empty() || special || name.find('/') != std::string::npos)
+			throw common::Error<Error::RingInvalidName> {name};
+
+		return std::filesystem::path {ring::DIRECTORY} / name;
+	}
+
+	/*!
+	 * Converts an optional property of a contact.
+	 *
+	 * @param[in] value The property.
+	 * @return The representation of the property in the ring.
+	 */
+	[[nodiscard]] static u8 state(const std::optional<bool> &value)
+	{
+		if (!value.has_value())
+			return ring::state::UNKNOWN;
+
+		return value.value() ? ring::state::YES : ring::state::NO;
+	}
+
+	/*!
+	 * Rounds a size up to the alignment of the slots.
+	 *
+	 * @param[in] size The size to round.
+	 * @return The aligned size.
+	 */
+	[[nodiscard]] static usize align(const usize size)
+	{
+		return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+};
+
+} // namespace iptsd::core::linux
+
+#endif // IPTSD_CORE_LINUX_RING_WRITER_HPP
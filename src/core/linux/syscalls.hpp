@@ -5,13 +5,16 @@
 
 #include "errors.hpp"
 
+#include <common/casts.hpp>
 #include <common/error.hpp>
 #include <common/types.hpp>
 
 #include <gsl/gsl>
 
 #include <linux/input.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 
 #include <cerrno>
 #include <csignal> // IWYU pragma: keep
@@ -35,10 +38,10 @@ inline std::string last_error()
 
 } // namespace impl
 
-inline int open(const std::filesystem::path &file, const int args)
+inline int open(const std::filesystem::path &file, const int args, const mode_t mode = 0)
 {
 	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-	const int ret = ::open(file.c_str(), args);
+	const int ret = ::open(file.c_str(), args, mode);
 	if (ret == -1)
 		throw common::Error<Error::SyscallOpenFailed> {file.c_str(), impl::last_error()};
 
@@ -106,6 +109,51 @@ inline int sigaction(const int sig, const struct sigaction *act, struct sigactio
 	return ret;
 }
 
+inline int poll(const gsl::span<struct pollfd> fds, const int timeout)
+{
+	const int ret = ::poll(fds.data(), fds.size(), timeout);
+	if (ret == -1)
+		throw common::Error<Error::SyscallPollFailed> {impl::last_error()};
+
+	return ret;
+}
+
+inline int ftruncate(const int fd, const usize size)
+{
+	const int ret = ::ftruncate(fd, casts::to<off_t>(size));
+	if (ret == -1)
+		throw common::Error<Error::SyscallTruncateFailed> {impl::last_error()};
+
+	return ret;
+}
+
+inline void *mmap(const int fd, const usize size, const int prot)
+{
+	void *ret = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+	if (ret == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+		throw common::Error<Error::SyscallMmapFailed> {impl::last_error()};
+
+	return ret;
+}
+
+inline int munmap(void *addr, const usize size)
+{
+	const int ret = ::munmap(addr, size);
+	if (ret == -1)
+		throw common::Error<Error::SyscallMunmapFailed> {impl::last_error()};
+
+	return ret;
+}
+
+inline int unlink(const std::filesystem::path &file)
+{
+	const int ret = ::unlink(file.c_str());
+	if (ret == -1)
+		throw common::Error<Error::SyscallUnlinkFailed> {file.c_str(), impl::last_error()};
+
+	return ret;
+}
+
 } // namespace iptsd::core::linux::syscalls
 
 #endif // IPTSD_CORE_LINUX_SYSCALLS_HPP
@@ -11,8 +11,10 @@
 #include <common/types.hpp>
 
 #include <algorithm>
+#include <iterator>
 #include <optional>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace iptsd::hid {
 
@@ -44,19 +46,28 @@ private:
 	// The size of the report
 	u64 m_report_size;
 
-	// The usage values describing the report
-	std::unordered_set<Usage> m_usages;
+	/*
+	 * The usage values describing the report, sorted and without duplicates.
+	 *
+	 * Reports only have a handful of usages, so a sorted vector is smaller and faster
+	 * to build and search than a hash set.
+	 */
+	std::vector<Usage> m_usages;
 
 public:
 	Report(const ReportType type,
 	       const std::optional<u8> report_id,
 	       const u32 report_count,
 	       const u32 report_size,
-	       const std::unordered_set<Usage> &usages)
+	       std::vector<Usage> usages)
 		: m_type {type},
 		  m_report_id {report_id},
 		  m_report_size {casts::to<u64>(report_count) * report_size},
-		  m_usages {usages} {};
+		  m_usages {std::move(usages)}
+	{
+		std::sort(m_usages.begin(), m_usages.end());
+		m_usages.erase(std::unique(m_usages.begin(), m_usages.end()), m_usages.end());
+	};
 
 	/*!
 	 * The type of the HID report.
@@ -85,7 +96,7 @@ public:
 	/*!
 	 * The usage tags of the HID report.
 	 */
-	[[nodiscard]] const std::unordered_set<Usage> &usages() const
+	[[nodiscard]] const std::vector<Usage> &usages() const
 	{
 		return m_usages;
 	}
@@ -98,7 +109,7 @@ public:
 	 */
 	[[nodiscard]] bool find_usage(const Usage value) const
 	{
-		return this->find_usage(value.page, value.value);
+		return std::binary_search(m_usages.cbegin(), m_usages.cend(), value);
 	}
 
 	/*!
@@ -110,11 +121,7 @@ public:
 	 */
 	[[nodiscard]] bool find_usage(const u16 page, const u16 value) const
 	{
-		return std::any_of(m_usages.cbegin(),
-		                   m_usages.cend(),
-		                   [&](const Usage &usage) -> bool {
-					   return usage.page == page && usage.value == value;
-				   });
+		return this->find_usage(Usage {page, value});
 	}
 
 	/*!
@@ -132,8 +139,16 @@ public:
 
 		m_report_size += other.size();
 
-		for (const Usage &usage : other.usages())
-			m_usages.insert(usage);
+		std::vector<Usage> usages {};
+		usages.reserve(m_usages.size() + other.usages().size());
+
+		std::set_union(m_usages.cbegin(),
+		               m_usages.cend(),
+		               other.usages().cbegin(),
+		               other.usages().cend(),
+		               std::back_inserter(usages));
+
+		m_usages = std::move(usages);
 	}
 };
 
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_HID_SERIALIZER_HPP
+#define IPTSD_HID_SERIALIZER_HPP
+
+#include "report.hpp"
+#include "spec.hpp"
+#include "usage.hpp"
+
+#include <common/casts.hpp>
+#include <common/types.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace iptsd::hid {
+namespace impl {
+
+// The usage page for vendor defined data.
+constexpr static u16 USAGE_PAGE_VENDOR = 0xFF00;
+
+// The data of a main item describing a field of variable, absolute values.
+constexpr static u8 MAIN_DATA_VARIABLE = 0b00000010;
+
+// The data of a collection item describing an application collection.
+constexpr static u8 COLLECTION_APPLICATION = 0x01;
+
+/*!
+ * Appends a short item to a binary HID descriptor.
+ *
+ * @param[in] buffer The descriptor to append to.
+ * @param[in] type The type of the item.
+ * @param[in] tag The tag of the item.
+ * @param[in] data The data of the item, which is stored in as few bytes as possible.
+ */
+template <class Tag>
+inline void write_item(std::vector<u8> &buffer, const ItemType type, const Tag tag, const u32 data)
+{
+	u8 size = 3;
+
+	if (data <= 0xFF)
+		size = 1;
+	else if (data <= 0xFFFF)
+		size = 2;
+
+	const u32 header = (static_cast<u32>(tag) << SHIFT_TAG) |
+	                   (static_cast<u32>(type) << SHIFT_TYPE) |
+	                   (casts::to<u32>(size) << SHIFT_SIZE);
+
+	buffer.push_back(casts::to<u8>(header));
+
+	// A size of 3 means that the data is four bytes long.
+	const usize bytes = size == 3 ? 4 : size;
+
+	for (usize i = 0; i < bytes; i++)
+		buffer.push_back(casts::to<u8>((data >> (i * 8)) & 0xFF));
+}
+
+} // namespace impl
+
+/*!
+ * Creates the binary representation of a HID descriptor.
+ *
+ * The descriptor only contains what @ref parse reads: The ID, size and usages of the reports.
+ * All reports are wrapped in a vendor defined application collection, so that the kernel
+ * doesn't try to interpret them as input devices.
+ *
+ * @param[in] reports The reports that the descriptor will define.
+ * @return The binary representation of the descriptor.
+ */
+inline std::vector<u8> serialize(const std::vector<Report> &reports)
+{
+	std::vector<u8> buffer {};
+
+	impl::write_item(buffer, ItemType::Global, TagGlobal::UsagePage, impl::USAGE_PAGE_VENDOR);
+	impl::write_item(buffer, ItemType::Local, TagLocal::Usage, 0x01);
+	impl::write_item(buffer,
+	                 ItemType::Main,
+	                 TagMain::Collection,
+	                 impl::COLLECTION_APPLICATION);
+
+	for (const Report &report : reports) {
+		const std::optional<u8> id = report.id();
+
+		if (id.has_value())
+			impl::write_item(buffer, ItemType::Global, TagGlobal::ReportId, id.value());
+
+		// Every usage sets its page, because the order of the usages is not known.
+		for (const auto &[page, value] : report.usages()) {
+			impl::write_item(buffer, ItemType::Global, TagGlobal::UsagePage, page);
+			impl::write_item(buffer, ItemType::Local, TagLocal::Usage, value);
+		}
+
+		u32 size = 8;
+		u32 count = casts::to<u32>(report.size() / 8);
+
+		// Fall back to single bits if the report doesn't consist of whole bytes.
+		if (report.size() % 8 != 0) {
+			size = 1;
+			count = casts::to<u32>(report.size());
+		}
+
+		impl::write_item(buffer, ItemType::Global, TagGlobal::ReportSize, size);
+		impl::write_item(buffer, ItemType::Global, TagGlobal::ReportCount, count);
+
+		TagMain tag {};
+
+		switch (report.type()) {
+		case ReportType::Input:
+			tag = TagMain::Input;
+			break;
+		case ReportType::Output:
+			tag = TagMain::Output;
+			break;
+		case ReportType::Feature:
+			tag = TagMain::Feature;
+			break;
+		}
+
+		impl::write_item(buffer, ItemType::Main, tag, impl::MAIN_DATA_VARIABLE);
+	}
+
+	// End Collection has no data, so it is written directly.
+	const u32 end = static_cast<u32>(TagMain::EndCollection) << SHIFT_TAG;
+	buffer.push_back(casts::to<u8>(end));
+
+	return buffer;
+}
+
+} // namespace iptsd::hid
+
+#endif // IPTSD_HID_SERIALIZER_HPP
@@ -12,7 +12,8 @@
 #include <common/types.hpp>
 
 #include <optional>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace iptsd::hid {
 
@@ -27,7 +28,8 @@ private:
 	std::optional<u16> m_usage_min = std::nullopt;
 	std::optional<u16> m_usage_max = std::nullopt;
 
-	std::unordered_set<Usage> m_usages {};
+	// The usages of the current field. The report sorts them and removes duplicates.
+	std::vector<Usage> m_usages {};
 
 public:
 	/*!
@@ -103,7 +105,7 @@ public:
 		if (!m_usage_page.has_value())
 			throw common::Error<Error::UsageBeforePage> {};
 
-		m_usages.insert(Usage {m_usage_page.value(), usage});
+		m_usages.push_back(Usage {m_usage_page.value(), usage});
 	}
 
 	/*!
@@ -128,7 +130,7 @@ public:
 
 		if (m_usage_max.has_value()) {
 			for (u16 i = usage_min; i < (m_usage_max.value() + 1); i++)
-				m_usages.insert(Usage {m_usage_page.value(), i});
+				m_usages.push_back(Usage {m_usage_page.value(), i});
 
 			m_usage_max.reset();
 		} else {
@@ -148,7 +150,7 @@ public:
 
 		if (m_usage_min.has_value()) {
 			for (u16 i = m_usage_min.value(); i < (usage_max + 1); i++)
-				m_usages.insert(Usage {m_usage_page.value(), i});
+				m_usages.push_back(Usage {m_usage_page.value(), i});
 
 			m_usage_min.reset();
 		} else {
@@ -190,7 +192,7 @@ public:
 			m_report_id,
 			m_report_size.value(),
 			m_report_count.value(),
-			m_usages,
+			std::move(m_usages),
 		};
 
 		this->reset_local();
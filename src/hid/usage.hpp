@@ -3,10 +3,9 @@
 #ifndef IPTSD_HID_USAGE_HPP
 #define IPTSD_HID_USAGE_HPP
 
-#include <common/casts.hpp>
 #include <common/types.hpp>
 
-#include <functional>
+#include <tuple>
 
 namespace iptsd::hid {
 
@@ -23,23 +22,17 @@ struct Usage {
 	{
 		return !(*this == other);
 	}
-};
-
-} // namespace iptsd::hid
 
-/*
- * Implement std::hash for usage so it can be added to unordered_set.
- */
-template <>
-struct std::hash<iptsd::hid::Usage> {
-public:
-	usize operator()(const iptsd::hid::Usage &usage) const noexcept
+	/*
+	 * Usages are sorted by their page first, so that a report can store them in a sorted
+	 * vector and search it with a binary search.
+	 */
+	bool operator<(const Usage &other) const
 	{
-		using namespace iptsd;
-
-		const u32 value = (casts::to<u32>(usage.page) << 16) + usage.value;
-		return std::hash<u32> {}(value);
+		return std::tie(this->page, this->value) < std::tie(other.page, other.value);
 	}
 };
 
+} // namespace iptsd::hid
+
 #endif // IPTSD_HID_USAGE_HPP
@@ -9,33 +9,79 @@
 #include <hid/report.hpp>
 #include <hid/usage.hpp>
 
+#include <array>
 #include <optional>
 #include <vector>
 
 namespace iptsd::ipts {
 
+/*
+ * What an input report is used for.
+ */
+enum class ReportKind : u8 {
+	Unknown,
+	TouchData,
+};
+
 class Descriptor {
 private:
 	std::vector<hid::Report> m_reports {};
 
+	// What the input reports are used for, indexed by their report ID.
+	std::array<ReportKind, 256> m_table {};
+
+	// All reports that contain touch data.
+	std::vector<hid::Report> m_touch_data {};
+
+	// The report for changing the mode of the device.
+	std::optional<hid::Report> m_modesetting = std::nullopt;
+
+	// The report for fetching metadata from the device.
+	std::optional<hid::Report> m_metadata = std::nullopt;
+
 public:
-	Descriptor(const std::vector<hid::Report> &reports) : m_reports {reports} {};
+	Descriptor(const std::vector<hid::Report> &reports) : m_reports {reports}
+	{
+		// Classify all reports once, so that lookups don't have to search the descriptor.
+		for (const hid::Report &report : m_reports) {
+			if (protocol::descriptor::is_set_mode(report) && !m_modesetting.has_value())
+				m_modesetting = report;
+
+			if (protocol::descriptor::is_metadata(report) && !m_metadata.has_value())
+				m_metadata = report;
+
+			if (!protocol::descriptor::is_touch_data(report))
+				continue;
+
+			m_touch_data.push_back(report);
+
+			const std::optional<u8> id = report.id();
+
+			// Only reports with an ID can be identified when they are received.
+			if (report.type() == hid::ReportType::Input && id.has_value())
+				m_table.at(id.value()) = ReportKind::TouchData;
+		}
+	};
+
+	/*!
+	 * Looks up what the input report with a certain ID is used for.
+	 *
+	 * @param[in] id The report ID, which is the first byte of a report.
+	 * @return The kind of the report. It is unknown if the ID is not used.
+	 */
+	[[nodiscard]] ReportKind kind(const u8 id) const
+	{
+		return m_table.at(id);
+	}
 
 	/*!
 	 * Searches for all reports that contain touch data in the HID descriptor.
 	 *
 	 * @return A list of reports containing IPTS touch data.
 	 */
-	[[nodiscard]] std::vector<hid::Report> find_touch_data_reports() const
+	[[nodiscard]] const std::vector<hid::Report> &find_touch_data_reports() const
 	{
-		std::vector<hid::Report> out {};
-
-		for (const hid::Report &report : m_reports) {
-			if (protocol::descriptor::is_touch_data(report))
-				out.push_back(report);
-		}
-
-		return out;
+		return m_touch_data;
 	}
 
 	/*!
@@ -46,14 +92,9 @@ public:
 	 *
 	 * @return The HID report for modesetting if it exists, null otherwise.
 	 */
-	[[nodiscard]] std::optional<hid::Report> find_modesetting_report() const
+	[[nodiscard]] const std::optional<hid::Report> &find_modesetting_report() const
 	{
-		for (const hid::Report &report : m_reports) {
-			if (protocol::descriptor::is_set_mode(report))
-				return report;
-		}
-
-		return std::nullopt;
+		return m_modesetting;
 	}
 
 	/*!
@@ -64,14 +105,9 @@ public:
 	 *
 	 * @return The HID report for fetching metadata if it exists, null otherwise.
 	 */
-	[[nodiscard]] std::optional<hid::Report> find_metadata_report() const
+	[[nodiscard]] const std::optional<hid::Report> &find_metadata_report() const
 	{
-		for (const hid::Report &report : m_reports) {
-			if (protocol::descriptor::is_metadata(report))
-				return report;
-		}
-
-		return std::nullopt;
+		return m_metadata;
 	}
 };
 
@@ -58,14 +58,10 @@ private:
 	// Support code for interfacing with the device through the HID descriptor
 	Descriptor m_descriptor;
 
-	// All reports of the HID descriptor that contain touch data
-	std::vector<hid::Report> m_touch_data_reports;
-
 public:
 	Device(std::shared_ptr<hid::Device> hid)
 		: m_hid {std::move(hid)},
-		  m_descriptor {m_hid->descriptor()},
-		  m_touch_data_reports {m_descriptor.find_touch_data_reports()}
+		  m_descriptor {m_hid->descriptor()}
 	{
 		// Check if the device can switch modes
 		if (!m_descriptor.find_modesetting_report().has_value())
@@ -93,7 +89,7 @@ public:
 	{
 		u64 size = 0;
 
-		for (const hid::Report &report : m_touch_data_reports)
+		for (const hid::Report &report : m_descriptor.find_touch_data_reports())
 			size = std::max(size, report.size());
 
 		return casts::to<usize>(size / 8);
@@ -160,10 +156,7 @@ public:
 		if (buffer.empty())
 			return false;
 
-		return std::any_of(
-			m_touch_data_reports.cbegin(),
-			m_touch_data_reports.cend(),
-			[&](const hid::Report &report) { return report.id() == buffer[0]; });
+		return m_descriptor.kind(buffer[0]) == ReportKind::TouchData;
 	}
 };
 
@@ -18,17 +18,49 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <array>
 #include <functional>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace iptsd::ipts {
 
+/*
+ * The result of parsing a HID report.
+ */
+enum class ParseStatus : u8 {
+	// The report was parsed.
+	Ok,
+
+	// A frame or report extends beyond the data that contains it.
+	Truncated,
+
+	// A frame is smaller than its own header.
+	InvalidSize,
+};
+
+inline std::string format_as(const ParseStatus status)
+{
+	switch (status) {
+	case ParseStatus::Ok:
+		return "Ok";
+	case ParseStatus::Truncated:
+		return "Truncated";
+	case ParseStatus::InvalidSize:
+		return "InvalidSize";
+	default:
+		return "Unknown";
+	}
+}
+
 class Parser {
 public:
 	// The callback that is invoked when stylus data was parsed.
 	std::function<void(const StylusData &)> on_stylus;
 
-	// The callback that is invoked when a capacitive heatmap was parsed.
+	// The callback that is invoked when a capacitive heatmap was parsed, after all other data.
 	std::function<void(const Heatmap &)> on_heatmap;
 
 	// The callback that is invoked when a DFT window was parsed.
@@ -41,6 +73,12 @@ private:
 	protocol::heatmap::Dimensions m_dim {};
 	protocol::dft::Metadata m_dft_meta {};
 
+	// How many reports were parsed with a certain result.
+	std::array<usize, 3> m_counters {};
+
+	// The heatmaps of the current report, which are emitted after all other data.
+	std::vector<Heatmap> m_heatmaps {};
+
 public:
 	/*!
 	 * Parses IPTS touch data from a HID report buffer.
@@ -48,10 +86,11 @@ public:
 	 * The data must have a three byte header, consisting of the report ID and a timestamp.
 	 *
 	 * @param[in] data The data to parse.
+	 * @return Whether the data was parsed, or why it was not.
 	 */
-	void parse(const gsl::span<u8> data)
+	ParseStatus parse(const gsl::span<u8> data)
 	{
-		this->parse<protocol::hid::ReportHeader>(data);
+		return this->parse<protocol::hid::ReportHeader>(data);
 	}
 
 	/*!
@@ -59,20 +98,305 @@ public:
 	 *
 	 * @tparam T The type (and size) of the header.
 	 * @param[in] data The data to parse.
+	 * @return Whether the data was parsed, or why it was not.
 	 */
 	template <class T>
-	void parse(const gsl::span<u8> data)
+	ParseStatus parse(const gsl::span<u8> data)
+	{
+		return this->parse_with_header(data, sizeof(T));
+	}
+
+	/*!
+	 * How many reports were parsed with a certain result.
+	 *
+	 * @param[in] status The result of parsing.
+	 * @return The number of reports that had this result.
+	 */
+	[[nodiscard]] usize count(const ParseStatus status) const
 	{
-		this->parse_with_header(data, sizeof(T));
+		return m_counters.at(static_cast<usize>(status));
 	}
 
 private:
-	void parse_with_header(const gsl::span<u8> data, const usize header)
+	/*!
+	 * Parses IPTS touch data with a header of a given size.
+	 *
+	 * The structure of the data is validated in full, before anything is parsed.
+	 * Malformed data is rejected as a whole, without invoking any callbacks.
+	 *
+	 * Heatmaps are emitted after everything else in the report. Processing a heatmap
+	 * can take a long time, and stylus data must not wait for it if both arrive together.
+	 *
+	 * @param[in] data The data to parse.
+	 * @param[in] header The size of the header.
+	 * @return Whether the data was parsed, or why it was not.
+	 */
+	ParseStatus parse_with_header(const gsl::span<u8> data, const usize header)
 	{
-		Reader reader(data);
-		reader.skip(header);
+		ParseStatus status = ParseStatus::Truncated;
+
+		if (data.size() >= header) {
+			Reader reader {data};
+			reader.skip_unchecked(header);
+
+			protocol::heatmap::Dimensions dim = m_dim;
+			status = validate_hid_frame(reader, dim);
+		}
 
+		m_counters.at(static_cast<usize>(status))++;
+
+		if (status != ParseStatus::Ok)
+			return status;
+
+		Reader reader {data};
+		reader.skip_unchecked(header);
+
+		m_heatmaps.clear();
 		this->parse_hid_frame(reader);
+
+		// The heatmaps point into the data, so they have to be emitted before returning.
+		if (this->on_heatmap) {
+			for (const Heatmap &heatmap : m_heatmaps)
+				this->on_heatmap(heatmap);
+		}
+
+		m_heatmaps.clear();
+		return status;
+	}
+
+	/*!
+	 * Checks if enough data is left for reading an object.
+	 *
+	 * @param[in] reader The data that the object is read from.
+	 * @param[in] size How many bytes have to be left.
+	 * @return Truncated if not enough data is left, Ok otherwise.
+	 */
+	static ParseStatus require(const Reader &reader, const usize size)
+	{
+		if (reader.size() < size)
+			return ParseStatus::Truncated;
+
+		return ParseStatus::Ok;
+	}
+
+	/*!
+	 * Validates the structure of an IPTS HID frame.
+	 *
+	 * This follows the same path as @ref parse_hid_frame, but only checks that all frames
+	 * and reports fit into the data that contains them.
+	 *
+	 * @param[in] reader The chunk of data allocated to the HID frame.
+	 * @param[in,out] dim The heatmap dimensions, which determine the size of heatmap reports.
+	 * @return Whether the frame is valid, or why it is not.
+	 */
+	static ParseStatus validate_hid_frame(Reader &reader, protocol::heatmap::Dimensions &dim)
+	{
+		if (reader.size() < sizeof(protocol::hid::Frame))
+			return ParseStatus::Truncated;
+
+		const auto frame = reader.read_unchecked<protocol::hid::Frame>();
+
+		if (frame.size < sizeof(frame))
+			return ParseStatus::InvalidSize;
+
+		const usize size = frame.size - sizeof(frame);
+
+		if (reader.size() < size)
+			return ParseStatus::Truncated;
+
+		Reader sub = reader.sub_unchecked(size);
+
+		switch (frame.type) {
+		case protocol::hid::FrameType::Hid:
+			while (sub.size() > 0) {
+				const ParseStatus status = validate_hid_frame(sub, dim);
+
+				if (status != ParseStatus::Ok)
+					return status;
+			}
+
+			return ParseStatus::Ok;
+		case protocol::hid::FrameType::Heatmap:
+			return validate_heatmap_frame(sub, dim);
+		case protocol::hid::FrameType::Metadata:
+			return require(sub,
+			               sizeof(protocol::metadata::Dimensions) + sizeof(u8) +
+			                       sizeof(protocol::metadata::Transform) +
+			                       sizeof(protocol::metadata::Unknown));
+		case protocol::hid::FrameType::Legacy:
+			return validate_legacy_frame(sub, dim);
+		case protocol::hid::FrameType::Reports:
+			// See parse_hid_frame
+			if (reader.size() == 4)
+				return ParseStatus::Ok;
+
+			return validate_report_frames(sub, dim);
+		default:
+			return ParseStatus::Ok;
+		}
+	}
+
+	/*!
+	 * Validates the structure of a heatmap frame.
+	 *
+	 * @param[in] reader The chunk of data allocated to the heatmap frame.
+	 * @param[in] dim The heatmap dimensions, which determine the size of the heatmap.
+	 * @return Whether the frame is valid, or why it is not.
+	 */
+	static ParseStatus validate_heatmap_frame(Reader &reader,
+	                                          const protocol::heatmap::Dimensions &dim)
+	{
+		if (reader.size() < sizeof(protocol::heatmap::Frame))
+			return ParseStatus::Truncated;
+
+		const auto header = reader.read_unchecked<protocol::heatmap::Frame>();
+
+		if (reader.size() < header.size)
+			return ParseStatus::Truncated;
+
+		const Reader sub = reader.sub_unchecked(header.size);
+		return require(sub, casts::to<usize>(dim.rows) * dim.columns);
+	}
+
+	/*!
+	 * Validates the structure of a legacy frame.
+	 *
+	 * @param[in] reader The chunk of data allocated to the legacy frame.
+	 * @param[in,out] dim The heatmap dimensions, which determine the size of heatmap reports.
+	 * @return Whether the frame is valid, or why it is not.
+	 */
+	static ParseStatus validate_legacy_frame(Reader &reader, protocol::heatmap::Dimensions &dim)
+	{
+		if (reader.size() < sizeof(protocol::legacy::Header))
+			return ParseStatus::Truncated;
+
+		const auto header = reader.read_unchecked<protocol::legacy::Header>();
+
+		for (u32 i = 0; i < header.elements; i++) {
+			if (reader.size() < sizeof(protocol::legacy::ReportGroup))
+				return ParseStatus::Truncated;
+
+			const auto group = reader.read_unchecked<protocol::legacy::ReportGroup>();
+
+			if (reader.size() < group.size)
+				return ParseStatus::Truncated;
+
+			Reader sub = reader.sub_unchecked(group.size);
+
+			if (group.type != protocol::legacy::GroupType::Stylus &&
+			    group.type != protocol::legacy::GroupType::Touch)
+				continue;
+
+			const ParseStatus status = validate_report_frames(sub, dim);
+
+			if (status != ParseStatus::Ok)
+				return status;
+		}
+
+		return ParseStatus::Ok;
+	}
+
+	/*!
+	 * Validates the structure of a list of report frames.
+	 *
+	 * @param[in] reader The chunk of data allocated to the list of report frames.
+	 * @param[in,out] dim The heatmap dimensions, which determine the size of heatmap reports.
+	 * @return Whether the frames are valid, or why they are not.
+	 */
+	static ParseStatus validate_report_frames(Reader &reader,
+	                                          protocol::heatmap::Dimensions &dim)
+	{
+		while (reader.size() > 0) {
+			if (reader.size() < sizeof(protocol::report::Frame))
+				return ParseStatus::Truncated;
+
+			const auto frame = reader.read_unchecked<protocol::report::Frame>();
+
+			if (reader.size() < frame.size)
+				return ParseStatus::Truncated;
+
+			Reader sub = reader.sub_unchecked(frame.size);
+			const ParseStatus status = validate_report(frame.type, sub, dim);
+
+			if (status != ParseStatus::Ok)
+				return status;
+		}
+
+		return ParseStatus::Ok;
+	}
+
+	/*!
+	 * Validates that a report is large enough for its contents.
+	 *
+	 * @param[in] type The type of the report.
+	 * @param[in] reader The chunk of data allocated to the report.
+	 * @param[in,out] dim The heatmap dimensions, which determine the size of heatmap reports.
+	 * @return Whether the report is valid, or why it is not.
+	 */
+	static ParseStatus validate_report(const protocol::report::Type type,
+	                                   const Reader &reader,
+	                                   protocol::heatmap::Dimensions &dim)
+	{
+		switch (type) {
+		case protocol::report::Type::StylusMPP_1_0:
+			return validate_stylus<protocol::stylus::SampleMPP_1_0>(reader);
+		case protocol::report::Type::StylusMPP_1_51:
+			return validate_stylus<protocol::stylus::SampleMPP_1_51>(reader);
+		case protocol::report::Type::HeatmapDimensions:
+			if (reader.size() < sizeof(protocol::heatmap::Dimensions))
+				return ParseStatus::Truncated;
+
+			dim = Reader {reader}.read_unchecked<protocol::heatmap::Dimensions>();
+			return ParseStatus::Ok;
+		case protocol::report::Type::HeatmapData:
+			return require(reader, casts::to<usize>(dim.rows) * dim.columns);
+		case protocol::report::Type::DftMetadata:
+			return require(reader, sizeof(protocol::dft::Metadata));
+		case protocol::report::Type::DftWindow:
+			return validate_dft_window(reader);
+		default:
+			return ParseStatus::Ok;
+		}
+	}
+
+	/*!
+	 * Validates that a stylus report contains all of its samples.
+	 *
+	 * @tparam T The type of the samples.
+	 * @param[in] reader The chunk of data allocated to the report.
+	 * @return Whether the report is valid, or why it is not.
+	 */
+	template <class T>
+	static ParseStatus validate_stylus(Reader reader)
+	{
+		if (reader.size() < sizeof(protocol::stylus::Report))
+			return ParseStatus::Truncated;
+
+		const auto report = reader.read_unchecked<protocol::stylus::Report>();
+
+		// The last sample is always read, even if the report claims to have none.
+		const usize samples = std::max<usize>(report.samples, 1);
+
+		return require(reader, samples * sizeof(T));
+	}
+
+	/*!
+	 * Validates that a DFT window report contains all of its rows.
+	 *
+	 * @param[in] reader The chunk of data allocated to the report.
+	 * @return Whether the report is valid, or why it is not.
+	 */
+	static ParseStatus validate_dft_window(Reader reader)
+	{
+		if (reader.size() < sizeof(protocol::dft::Window))
+			return ParseStatus::Truncated;
+
+		const auto window = reader.read_unchecked<protocol::dft::Window>();
+
+		// The window contains one set of rows for each axis.
+		const usize rows = casts::to<usize>(window.num_rows) * 2;
+
+		return require(reader, rows * sizeof(protocol::dft::Row));
 	}
 
 	/*!
@@ -85,8 +409,8 @@ private:
 	 */
 	void parse_hid_frame(Reader &reader)
 	{
-		const auto frame = reader.read<protocol::hid::Frame>();
-		Reader sub = reader.sub(frame.size - sizeof(frame));
+		const auto frame = reader.read_unchecked<protocol::hid::Frame>();
+		Reader sub = reader.sub_unchecked(frame.size - sizeof(frame));
 
 		switch (frame.type) {
 		case protocol::hid::FrameType::Hid:
@@ -142,11 +466,11 @@ private:
 	 */
 	void parse_legacy_frame(Reader &reader)
 	{
-		const auto header = reader.read<protocol::legacy::Header>();
+		const auto header = reader.read_unchecked<protocol::legacy::Header>();
 
 		for (u32 i = 0; i < header.elements; i++) {
-			const auto group = reader.read<protocol::legacy::ReportGroup>();
-			Reader sub = reader.sub(group.size);
+			const auto group = reader.read_unchecked<protocol::legacy::ReportGroup>();
+			Reader sub = reader.sub_unchecked(group.size);
 
 			switch (group.type) {
 			case protocol::legacy::GroupType::Stylus:
@@ -172,10 +496,10 @@ private:
 	{
 		Metadata m {};
 
-		m.dimensions = reader.read<protocol::metadata::Dimensions>();
-		m.unknown_byte = reader.read<u8>();
-		m.transform = reader.read<protocol::metadata::Transform>();
-		m.unknown = reader.read<protocol::metadata::Unknown>();
+		m.dimensions = reader.read_unchecked<protocol::metadata::Dimensions>();
+		m.unknown_byte = reader.read_unchecked<u8>();
+		m.transform = reader.read_unchecked<protocol::metadata::Transform>();
+		m.unknown = reader.read_unchecked<protocol::metadata::Unknown>();
 
 		if (this->on_metadata)
 			this->on_metadata(m);
@@ -191,8 +515,8 @@ private:
 	 */
 	void parse_report_frame(Reader &reader)
 	{
-		const auto frame = reader.read<protocol::report::Frame>();
-		Reader sub = reader.sub(frame.size);
+		const auto frame = reader.read_unchecked<protocol::report::Frame>();
+		Reader sub = reader.sub_unchecked(frame.size);
 
 		switch (frame.type) {
 		case protocol::report::Type::StylusMPP_1_0:
@@ -243,12 +567,12 @@ private:
 	 */
 	void parse_stylus_mpp_1_0(Reader &reader) const
 	{
-		const auto report = reader.read<protocol::stylus::Report>();
+		const auto report = reader.read_unchecked<protocol::stylus::Report>();
 
 		for (u8 i = 0; i < report.samples - 1; i++)
-			reader.skip(sizeof(protocol::stylus::SampleMPP_1_0));
+			reader.skip_unchecked(sizeof(protocol::stylus::SampleMPP_1_0));
 
-		const auto sample = reader.read<protocol::stylus::SampleMPP_1_0>();
+		const auto sample = reader.read_unchecked<protocol::stylus::SampleMPP_1_0>();
 
 		if (!this->on_stylus)
 			return;
@@ -291,12 +615,12 @@ private:
 	 */
 	void parse_stylus_mpp_1_51(Reader &reader) const
 	{
-		const auto report = reader.read<protocol::stylus::Report>();
+		const auto report = reader.read_unchecked<protocol::stylus::Report>();
 
 		for (u8 i = 0; i < report.samples - 1; i++)
-			reader.skip(sizeof(protocol::stylus::SampleMPP_1_51));
+			reader.skip_unchecked(sizeof(protocol::stylus::SampleMPP_1_51));
 
-		const auto sample = reader.read<protocol::stylus::SampleMPP_1_51>();
+		const auto sample = reader.read_unchecked<protocol::stylus::SampleMPP_1_51>();
 
 		if (!this->on_stylus)
 			return;
@@ -342,7 +666,7 @@ private:
 	 */
 	void parse_heatmap_dimensions(Reader &reader)
 	{
-		m_dim = reader.read<protocol::heatmap::Dimensions>();
+		m_dim = reader.read_unchecked<protocol::heatmap::Dimensions>();
 
 		// On newer devices, z_max may be 0, lets use a sane value instead.
 		if (m_dim.z_max == 0)
@@ -356,9 +680,11 @@ private:
 	 * Because your finger is conductive, putting it on the screen lowers the resistance.
 	 * So a touch is represented by a low value, and no touch is represented by a high value.
 	 *
+	 * The heatmap is only queued here, see @ref parse_with_header.
+	 *
 	 * @param[in] reader The chunk of data allocated to the report.
 	 */
-	void parse_heatmap_data(Reader &reader) const
+	void parse_heatmap_data(Reader &reader)
 	{
 		Heatmap heatmap {};
 
@@ -367,10 +693,10 @@ private:
 		heatmap.min = m_dim.z_min;
 		heatmap.max = m_dim.z_max;
 
-		heatmap.data = reader.subspan<u8>(casts::to<usize>(m_dim.rows) * m_dim.columns);
+		const usize size = casts::to<usize>(m_dim.rows) * m_dim.columns;
+		heatmap.data = reader.subspan_unchecked<u8>(size);
 
-		if (this->on_heatmap)
-			this->on_heatmap(heatmap);
+		m_heatmaps.push_back(heatmap);
 	}
 
 	/*!
@@ -381,10 +707,10 @@ private:
 	 *
 	 * @param[in] reader The chunk of data allocated to the frame.
 	 */
-	void parse_heatmap_frame(Reader &reader) const
+	void parse_heatmap_frame(Reader &reader)
 	{
-		const auto header = reader.read<protocol::heatmap::Frame>();
-		Reader sub = reader.sub(header.size);
+		const auto header = reader.read_unchecked<protocol::heatmap::Frame>();
+		Reader sub = reader.sub_unchecked(header.size);
 
 		this->parse_heatmap_data(sub);
 	}
@@ -402,10 +728,10 @@ private:
 	void parse_dft_window(Reader &reader) const
 	{
 		DftWindow dft {};
-		const auto window = reader.read<protocol::dft::Window>();
+		const auto window = reader.read_unchecked<protocol::dft::Window>();
 
-		dft.x = reader.subspan<protocol::dft::Row>(window.num_rows);
-		dft.y = reader.subspan<protocol::dft::Row>(window.num_rows);
+		dft.x = reader.subspan_unchecked<protocol::dft::Row>(window.num_rows);
+		dft.y = reader.subspan_unchecked<protocol::dft::Row>(window.num_rows);
 
 		dft.type = window.data_type;
 		dft.width = m_dim.columns;
@@ -429,7 +755,7 @@ private:
 	 */
 	void parse_dft_metadata(Reader &reader)
 	{
-		m_dft_meta = reader.read<protocol::dft::Metadata>();
+		m_dft_meta = reader.read_unchecked<protocol::dft::Metadata>();
 	}
 };
 
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_IPTS_TIMELINE_HPP
+#define IPTSD_IPTS_TIMELINE_HPP
+
+#include <common/casts.hpp>
+#include <common/chrono.hpp>
+#include <common/types.hpp>
+
+#include <optional>
+
+namespace iptsd::ipts {
+
+/*
+ * Converts the timestamps of HID reports into a continuous timeline.
+ *
+ * Every report starts with a 16 bit timestamp in units of 100μs, that wraps around
+ * after roughly 6.5 seconds. As long as the gap between two reports is shorter than
+ * that, the wrap-around can be undone by looking at the difference between them.
+ */
+class Timeline {
+public:
+	// The duration of one tick of the report timestamp.
+	static constexpr chrono::microseconds TICK = 100us;
+
+private:
+	// The timestamp of the previous report.
+	std::optional<u16> m_last = std::nullopt;
+
+	// The number of ticks since the first report.
+	u64 m_ticks = 0;
+
+public:
+	/*!
+	 * Advances the timeline to a new report.
+	 *
+	 * @param[in] timestamp The timestamp of the report.
+	 * @return The time that has passed between the first report and this one.
+	 */
+	chrono::microseconds update(const u16 timestamp)
+	{
+		// Unsigned subtraction takes care of the wrap-around.
+		if (m_last.has_value())
+			m_ticks += static_cast<u16>(timestamp - m_last.value());
+
+		m_last = timestamp;
+		return this->now();
+	}
+
+	/*!
+	 * The time that has passed between the first report and the most recent one.
+	 */
+	[[nodiscard]] chrono::microseconds now() const
+	{
+		return TICK * casts::to_signed(m_ticks);
+	}
+
+	/*!
+	 * Resets the timeline, so that the next report is treated as the first one.
+	 */
+	void reset()
+	{
+		m_last = std::nullopt;
+		m_ticks = 0;
+	}
+};
+
+} // namespace iptsd::ipts
+
+#endif // IPTSD_IPTS_TIMELINE_HPP
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_RING_LAYOUT_HPP
+#define IPTSD_RING_LAYOUT_HPP
+
+/*
+ * The layout of the shared memory ring that iptsd publishes its output to.
+ *
+ * This header is installed for other programs and only depends on the standard library.
+ *
+ * The ring is a file in /dev/shm, /dev/shm/iptsd unless configured otherwise. It starts with
+ * a Header, followed by Header::slot_count slots of Header::slot_size bytes each, starting at
+ * offset Header::header_size. Readers must use these fields instead of the sizes of the structs,
+ * so that fields can be appended in the future without breaking them. All values are in the
+ * native byte order.
+ *
+ * iptsd is the only writer. Every processed heatmap and every stylus update is published as
+ * a frame, which contains the current contacts and the current state of the stylus. Frames are
+ * numbered from zero, frame n is stored in slot n % slot_count. Every slot is protected by a
+ * sequence lock:
+ *
+ *   - While frame n is written, Slot::lock is 2n + 1.
+ *   - Once frame n is complete, Slot::lock is 2n + 2.
+ *   - Afterwards, Header::head is set to n + 1.
+ *
+ * To read frame n, load Slot::lock (acquire), read the frame, and load Slot::lock again after
+ * an acquire fence. If both values are 2n + 2, the frame is valid. Otherwise it was overwritten
+ * while reading it, and readers fell behind by at least slot_count frames.
+ *
+ * The file is created empty, resized and then initialized. Header::magic is written last
+ * (release), so a reader that loads it (acquire) and finds MAGIC sees the complete header and
+ * the full size of the file. If the file is smaller than the header or the magic is zero, the
+ * ring is not ready yet and has to be opened again.
+ *
+ * When iptsd stops, it sets Header::active to zero and removes the file. A new instance creates
+ * a new file, so readers have to open the ring again.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace iptsd::ring {
+
+// The first four bytes of the ring ("IPTR" in little endian).
+constexpr std::uint32_t MAGIC = 0x52545049;
+
+// Incremented when existing fields change. Appending fields does not change the version.
+constexpr std::uint32_t VERSION = 1;
+
+// The name of the ring if none is configured.
+constexpr const char *DEFAULT_NAME = "iptsd";
+
+// The directory in which the ring is created.
+constexpr const char *DIRECTORY = "/dev/shm";
+
+// How many contacts fit into a frame. Additional contacts are dropped.
+// Changing this changes the layout of the frames, so the version has to be incremented.
+constexpr std::uint32_t MAX_CONTACTS = 32;
+
+namespace flags {
+
+// The frame was published because the contacts were updated.
+constexpr std::uint32_t CONTACTS = 1U << 0;
+
+// The frame was published because the stylus was updated.
+constexpr std::uint32_t STYLUS = 1U << 1;
+
+// More contacts were found than fit into the frame.
+constexpr std::uint32_t TRUNCATED = 1U << 2;
+
+} // namespace flags
+
+namespace state {
+
+// The property is not known.
+constexpr std::uint8_t UNKNOWN = 0;
+
+// The property is false.
+constexpr std::uint8_t NO = 1;
+
+// The property is true.
+constexpr std::uint8_t YES = 2;
+
+} // namespace state
+
+struct Contact {
+	// The position of the center of the contact. Range: [0, 1]
+	double x;
+	double y;
+
+	// The diameter of the major and minor axis, relative to the diagonal of the screen.
+	double major;
+	double minor;
+
+	// The orientation of the major axis, with 1 meaning 180 degrees. Range: [0, 1)
+	double orientation;
+
+	// An index that stays the same while the contact is on the screen.
+	std::uint32_t index;
+
+	// Whether the contact is a finger, or something else like a palm. See @ref state.
+	std::uint8_t valid;
+
+	// Whether the shape of the contact stopped changing. See @ref state.
+	std::uint8_t stable;
+
+	std::array<std::uint8_t, 2> reserved;
+};
+
+static_assert(sizeof(Contact) == 48);
+
+struct Stylus {
+	// Whether the stylus is close to the screen.
+	std::uint8_t proximity;
+
+	// Whether the stylus touches the screen.
+	std::uint8_t contact;
+
+	// Whether the button of the stylus is pressed.
+	std::uint8_t button;
+
+	// Whether the eraser is used.
+	std::uint8_t rubber;
+
+	// The serial number of the stylus, if it is sent by the device.
+	std::uint32_t serial;
+
+	// The position of the stylus tip. Range: [0, 1]
+	double x;
+	double y;
+
+	// The pressure of the stylus tip. Range: [0, 1]
+	double pressure;
+
+	// The tilt of the stylus, in radians.
+	double altitude;
+	double azimuth;
+};
+
+static_assert(sizeof(Stylus) == 48);
+
+struct Frame {
+	// The number of the frame.
+	std::uint64_t sequence;
+
+	// When the frame was published, in nanoseconds of CLOCK_MONOTONIC.
+	std::uint64_t time;
+
+	// When the device sent the data, in microseconds since its first report.
+	std::uint64_t report_time;
+
+	// Why the frame was published. See @ref flags.
+	std::uint32_t flags;
+
+	// How many entries of @ref contacts are used.
+	std::uint32_t contact_count;
+
+	// The state of the stylus.
+	Stylus stylus;
+
+	// The contacts on the screen.
+	std::array<Contact, MAX_CONTACTS> contacts;
+};
+
+struct Slot {
+	// The sequence lock of the slot.
+	std::atomic<std::uint64_t> lock;
+
+	std::uint64_t reserved;
+
+	// The frame stored in the slot.
+	Frame frame;
+};
+
+struct Header {
+	// MAGIC once the ring is initialized, zero before.
+	std::atomic<std::uint32_t> magic;
+
+	// The version of the layout.
+	std::uint32_t version;
+
+	// The offset of the first slot.
+	std::uint32_t header_size;
+
+	// The distance between two slots.
+	std::uint32_t slot_size;
+
+	// How many slots the ring has.
+	std::uint32_t slot_count;
+
+	// How many contacts fit into a frame.
+	std::uint32_t max_contacts;
+
+	// The device that produced the data.
+	std::uint16_t vendor;
+	std::uint16_t product;
+
+	std::uint32_t reserved;
+
+	// The size of the screen, in centimeters.
+	double width;
+	double height;
+
+	// How many frames were published.
+	alignas(64) std::atomic<std::uint64_t> head;
+
+	// Whether iptsd is still publishing to the ring.
+	std::atomic<std::uint32_t> active;
+};
+
+// The values must be usable by other processes, without locks.
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+} // namespace iptsd::ring
+
+#endif // IPTSD_RING_LAYOUT_HPP
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef IPTSD_RING_READER_HPP
+#define IPTSD_RING_READER_HPP
+
+/*
+ * A header-only library for reading the output of iptsd from the shared memory ring.
+ *
+ * Only depends on the standard library and POSIX. See layout.hpp for the format of the ring.
+ *
+ *     iptsd::ring::Reader reader {};
+ *     iptsd::ring::Frame frame {};
+ *
+ *     while (reader.active()) {
+ *         if (reader.next(frame) != iptsd::ring::Status::Ok)
+ *             continue; // Or wait a bit
+ *
+ *         // Process the frame.
+ *     }
+ */
+
+#include "layout.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+namespace iptsd::ring {
+
+enum class Status : std::uint8_t {
+	// The frame was read.
+	Ok,
+
+	// The frame was not published yet.
+	Pending,
+
+	// The frame was overwritten by a newer one, before or while reading it.
+	Overwritten,
+};
+
+/*
+ * Thrown when the ring exists, but iptsd has not finished creating it yet.
+ *
+ * Opening the ring again a moment later will succeed.
+ */
+class NotReady : public std::runtime_error {
+public:
+	NotReady() : std::runtime_error {"iptsd ring: The ring is not ready yet"} {};
+};
+
+class Reader {
+private:
+	// The mapped memory of the ring.
+	const std::byte *m_data = nullptr;
+
+	// The size of the mapped memory.
+	std::size_t m_size = 0;
+
+	// The number of the next frame that is returned by @ref next.
+	std::uint64_t m_next = 0;
+
+public:
+	/*!
+	 * Opens and maps a ring.
+	 *
+	 * Throws NotReady if iptsd is still creating the ring.
+	 *
+	 * @param[in] name The name of the ring, as configured for iptsd.
+	 */
+	explicit Reader(const std::string &name = DEFAULT_NAME)
+	{
+		const std::string path = std::string {DIRECTORY} + "/" + name;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd == -1)
+			throw std::system_error {errno, std::system_category(), path};
+
+		struct stat info {};
+
+		if (::fstat(fd, &info) == -1) {
+			const int err = errno;
+			::close(fd);
+
+			throw std::system_error {err, std::system_category(), path};
+		}
+
+		const auto size = static_cast<std::size_t>(info.st_size);
+
+		// The file is resized after creating it.
+		if (size < sizeof(Header)) {
+			::close(fd);
+			throw NotReady {};
+		}
+
+		void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+		// The mapping stays valid after closing the file.
+		::close(fd);
+
+		if (data == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+			throw std::system_error {errno, std::system_category(), path};
+
+		m_data = static_cast<const std::byte *>(data);
+		m_size = size;
+
+		try {
+			this->validate();
+		} catch (...) {
+			this->unmap();
+			throw;
+		}
+
+		// Start with the frames that are published after opening the ring.
+		m_next = this->head();
+	}
+
+	Reader(const Reader &) = delete;
+	Reader &operator=(const Reader &) = delete;
+
+	Reader(Reader &&) = delete;
+	Reader &operator=(Reader &&) = delete;
+
+	~Reader()
+	{
+		this->unmap();
+	}
+
+	/*!
+	 * The header of the ring, describing the device and the layout.
+	 */
+	[[nodiscard]] const Header &header() const
+	{
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return *reinterpret_cast<const Header *>(m_data);
+	}
+
+	/*!
+	 * Whether iptsd is still publishing to the ring.
+	 *
+	 * If not, the ring has to be opened again once iptsd was restarted.
+	 */
+	[[nodiscard]] bool active() const
+	{
+		return this->header().active.load(std::memory_order_relaxed) != 0;
+	}
+
+	/*!
+	 * How many frames were published so far.
+	 *
+	 * The newest frame has the number head() - 1.
+	 */
+	[[nodiscard]] std::uint64_t head() const
+	{
+		return this->header().head.load(std::memory_order_acquire);
+	}
+
+	/*!
+	 * Passes a frame to a function, without copying it.
+	 *
+	 * The frame can be overwritten while the function is running. In that case the function
+	 * sees inconsistent data, and Status::Overwritten is returned afterwards. The caller must
+	 * then discard everything that the function derived from the frame.
+	 *
+	 * @param[in] sequence The number of the frame.
+	 * @param[in] func The function that is called with a reference to the frame.
+	 * @return Whether the frame that was passed to the function is valid.
+	 */
+	template <class Func>
+	Status visit(const std::uint64_t sequence, const Func &func) const
+	{
+		const std::uint32_t count = this->header().slot_count;
+		const Slot &slot = this->slot(sequence % count);
+
+		const std::uint64_t expected = sequence * 2 + 2;
+		const std::uint64_t before = slot.lock.load(std::memory_order_acquire);
+
+		if (before != expected)
+			return before < expected ? Status::Pending : Status::Overwritten;
+
+		func(slot.frame);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const std::uint64_t after = slot.lock.load(std::memory_order_relaxed);
+
+		return after == expected ? Status::Ok : Status::Overwritten;
+	}
+
+	/*!
+	 * Copies a frame.
+	 *
+	 * @param[in] sequence The number of the frame.
+	 * @param[out] frame The frame is copied here. Only valid if Status::Ok is returned.
+	 * @return Whether the frame was read.
+	 */
+	Status read(const std::uint64_t sequence, Frame &frame) const
+	{
+		return this->visit(sequence, [&](const Frame &f) { frame = f; });
+	}
+
+	/*!
+	 * Copies the next frame that was not read yet.
+	 *
+	 * If the reader fell behind so far that frames were overwritten, they are skipped.
+	 * Compare the numbers of the returned frames to find out how many were lost.
+	 *
+	 * @param[out] frame The frame is copied here. Only valid if Status::Ok is returned.
+	 * @return Status::Ok if a frame was read, Status::Pending if there is no new frame.
+	 */
+	Status next(Frame &frame)
+	{
+		const std::uint64_t count = this->header().slot_count;
+
+		while (true) {
+			const std::uint64_t head = this->head();
+
+			if (m_next >= head)
+				return Status::Pending;
+
+			// The slots of older frames have already been reused.
+			if (head - m_next > count)
+				m_next = head - count;
+
+			const Status status = this->read(m_next, frame);
+
+			if (status == Status::Pending)
+				return status;
+
+			m_next++;
+
+			if (status == Status::Ok)
+				return status;
+		}
+	}
+
+private:
+	/*!
+	 * Returns a slot of the ring.
+	 *
+	 * @param[in] index The index of the slot.
+	 * @return A reference to the slot.
+	 */
+	[[nodiscard]] const Slot &slot(const std::uint64_t index) const
+	{
+		const Header &header = this->header();
+		const std::uint64_t offset = header.header_size + index * header.slot_size;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		return *reinterpret_cast<const Slot *>(m_data + offset);
+	}
+
+	/*!
+	 * Checks that the mapped memory contains a ring that this reader understands.
+	 */
+	void validate() const
+	{
+		const Header &header = this->header();
+
+		// The magic is written last, so the rest of the header is complete if it is set.
+		const std::uint32_t magic = header.magic.load(std::memory_order_acquire);
+
+		if (magic == 0)
+			throw NotReady {};
+
+		if (magic != MAGIC)
+			throw std::runtime_error {"iptsd ring: The file is not a ring"};
+
+		if (header.version != VERSION)
+			throw std::runtime_error {"iptsd ring: Unsupported version of the layout"};
+
+		if (header.header_size < sizeof(Header) || header.slot_size < sizeof(Slot))
+			throw std::runtime_error {"iptsd ring: Invalid layout"};
+
+		if (header.slot_count == 0 || header.max_contacts != MAX_CONTACTS)
+			throw std::runtime_error {"iptsd ring: Invalid layout"};
+
+		const std::uint64_t slots = std::uint64_t {header.slot_count} * header.slot_size;
+
+		if (m_size < header.header_size + slots)
+			throw std::runtime_error {"iptsd ring: The file is too small"};
+	}
+
+	/*!
+	 * Unmaps the memory of the ring.
+	 */
+	void unmap()
+	{
+		if (m_data == nullptr)
+			return;
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+		::munmap(const_cast<std::byte *>(m_data), m_size);
+
+		m_data = nullptr;
+		m_size = 0;
+	}
+};
+
+} // namespace iptsd::ring
+
+#endif // IPTSD_RING_READER_HPP
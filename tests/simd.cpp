@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Runs the vectorized kernels with the native vector type and with the scalar reference
+ * implementation, and checks that both produce the same results.
+ *
+ * The widths of the test data cover every possible number of elements that are left over
+ * after the last full vector, so that the scalar tails of the loops are checked as well.
+ */
+
+#include <common/simd.hpp>
+#include <common/types.hpp>
+#include <contacts/detection/algorithms/convolution.hpp>
+#include <contacts/detection/algorithms/gaussian.hpp>
+#include <contacts/detection/algorithms/maximas.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace iptsd::tests::simd {
+namespace {
+
+using common::simd::Native;
+using common::simd::Scalar;
+
+// The heights of the test data. Includes heights that are smaller than the kernels.
+const std::vector<Eigen::Index> ROWS {1, 2, 3, 5, 9};
+
+/*!
+ * How many columns the test data has at most.
+ *
+ * Three full vectors plus every possible tail, and enough to fit the largest kernel.
+ */
+template <class T>
+constexpr Eigen::Index max_cols()
+{
+	return Native<T>::Size * 4 + 5;
+}
+
+/*!
+ * The largest difference between two results that is tolerated.
+ *
+ * The vectorized sums add up their elements in a different order.
+ */
+template <class T>
+constexpr T tolerance()
+{
+	return std::is_same_v<T, f32> ? static_cast<T>(1E-4) : static_cast<T>(1E-10);
+}
+
+/*!
+ * Creates random test data.
+ *
+ * @param[in] rng The source of random numbers.
+ * @param[in] rows The number of rows.
+ * @param[in] cols The number of columns.
+ * @return The test data, with values between 0 and 1.
+ */
+template <class T>
+Image<T> random(std::mt19937 &rng, const Eigen::Index rows, const Eigen::Index cols)
+{
+	std::uniform_real_distribution<T> dist {static_cast<T>(0), static_cast<T>(1)};
+
+	Image<T> data {rows, cols};
+
+	for (Eigen::Index y = 0; y < rows; y++) {
+		for (Eigen::Index x = 0; x < cols; x++)
+			data(y, x) = dist(rng);
+	}
+
+	return data;
+}
+
+/*!
+ * Compares the results of both implementations.
+ *
+ * @param[in] name The name of the kernel and of the test case, for the error message.
+ * @param[in] expected The result of the scalar implementation.
+ * @param[in] actual The result of the native implementation.
+ * @return Whether the results are the same, within the tolerance.
+ */
+template <class Derived>
+bool compare(const std::string &name,
+             const Eigen::DenseBase<Derived> &expected,
+             const Eigen::DenseBase<Derived> &actual)
+{
+	using T = typename Eigen::DenseBase<Derived>::Scalar;
+
+	const T magnitude = std::max(static_cast<T>(1), expected.derived().cwiseAbs().maxCoeff());
+
+	for (Eigen::Index y = 0; y < expected.rows(); y++) {
+		for (Eigen::Index x = 0; x < expected.cols(); x++) {
+			const T a = expected(y, x);
+			const T b = actual(y, x);
+
+			if (std::abs(a - b) <= tolerance<T>() * magnitude)
+				continue;
+
+			spdlog::error("{}: ({}, {}) is {}, expected {}", name, x, y, b, a);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Compares the convolution with a 3x3 and a 5x5 kernel.
+ */
+template <class T>
+bool check_convolution(std::mt19937 &rng)
+{
+	namespace convolution = contacts::detection::convolution::impl;
+
+	bool ok = true;
+
+	const Matrix<T, 3, 3> k3 = random<T>(rng, 3, 3).matrix();
+	const Matrix<T, 5, 5> k5 = random<T>(rng, 5, 5).matrix();
+
+	for (const Eigen::Index rows : ROWS) {
+		for (Eigen::Index cols = 1; cols <= max_cols<T>(); cols++) {
+			const Image<T> in = random<T>(rng, rows, cols);
+			const std::string name = fmt::format("convolution {}x{}", cols, rows);
+
+			Image<T> expected = Image<T>::Zero(rows, cols);
+			Image<T> actual = Image<T>::Zero(rows, cols);
+
+			convolution::run_any<Scalar<T>>(in, k3, expected);
+			convolution::run_any<Native<T>>(in, k3, actual);
+
+			ok &= compare(name + " (3x3)", expected, actual);
+
+			expected.setZero();
+			actual.setZero();
+
+			convolution::run_any<Scalar<T>>(in, k5, expected);
+			convolution::run_any<Native<T>>(in, k5, actual);
+
+			ok &= compare(name + " (5x5)", expected, actual);
+		}
+	}
+
+	return ok;
+}
+
+/*!
+ * Compares the search for local maxima.
+ */
+template <class T>
+bool check_maximas(std::mt19937 &rng)
+{
+	namespace maximas = contacts::detection::maximas::impl;
+
+	bool ok = true;
+
+	for (const Eigen::Index rows : ROWS) {
+		for (Eigen::Index cols = 1; cols <= max_cols<T>(); cols++) {
+			Image<T> in = random<T>(rng, rows, cols);
+
+			// Equal neighbours check that both implementations break ties the same way.
+			in = (in * 4).round() / 4;
+
+			std::vector<Point> expected {};
+			std::vector<Point> actual {};
+
+			maximas::find_rows<Scalar<T>>(in, static_cast<T>(0.1), 0, rows, expected);
+			maximas::find_rows<Native<T>>(in, static_cast<T>(0.1), 0, rows, actual);
+
+			const auto order = [](const Point &a, const Point &b) {
+				return std::make_pair(a.y(), a.x()) < std::make_pair(b.y(), b.x());
+			};
+
+			std::sort(expected.begin(), expected.end(), order);
+			std::sort(actual.begin(), actual.end(), order);
+
+			if (expected == actual)
+				continue;
+
+			spdlog::error("maximas {}x{}: Found {} maxima, expected {}",
+			              cols,
+			              rows,
+			              actual.size(),
+			              expected.size());
+
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+/*!
+ * Compares the assembly of the system of linear equations for fitting a Gaussian.
+ */
+template <class T>
+bool check_gaussian(std::mt19937 &rng)
+{
+	namespace gaussian = contacts::detection::gaussian::impl;
+
+	bool ok = true;
+
+	const Eigen::Index cols = max_cols<T>() + 3;
+	const Eigen::Index rows = 9;
+
+	const Image<T> data = random<T>(rng, rows, cols);
+
+	for (Eigen::Index left = 0; left < 3; left++) {
+		for (Eigen::Index width = 1; left + width <= cols; width++) {
+			const Box box {Point {left, 2}, Point {left + width - 1, rows - 3}};
+			const Eigen::Index height = box.sizes().y() + 1;
+
+			const Matrix<T> weights = random<T>(rng, height, width).matrix();
+
+			Matrix6<T> m1 {};
+			Matrix6<T> m2 {};
+			Vector6<T> rhs1 {};
+			Vector6<T> rhs2 {};
+
+			gaussian::assemble_system<Scalar<T>>(m1, rhs1, box, data, weights);
+			gaussian::assemble_system<Native<T>>(m2, rhs2, box, data, weights);
+
+			const std::string name = fmt::format("gaussian {}+{}", left, width);
+
+			ok &= compare(name + " (system)", m1, m2);
+			ok &= compare(name + " (rhs)", rhs1, rhs2);
+		}
+	}
+
+	return ok;
+}
+
+/*!
+ * Runs all checks with one type.
+ */
+template <class T>
+bool check(std::mt19937 &rng)
+{
+	bool ok = true;
+
+	ok &= check_convolution<T>(rng);
+	ok &= check_maximas<T>(rng);
+	ok &= check_gaussian<T>(rng);
+
+	return ok;
+}
+
+} // namespace
+} // namespace iptsd::tests::simd
+
+int main()
+{
+	spdlog::set_pattern("[%X.%e] [%^%l%$] %v");
+
+	// A fixed seed, so that failures can be reproduced.
+	std::mt19937 rng {42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+
+	bool ok = true;
+
+	ok &= iptsd::tests::simd::check<f32>(rng);
+	ok &= iptsd::tests::simd::check<f64>(rng);
+
+	if (!ok)
+		return EXIT_FAILURE;
+
+	spdlog::info("The native and scalar kernels produce the same results");
+	return 0;
+}